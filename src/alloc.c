@@ -0,0 +1,362 @@
+/* alloc.c
+ * -----------------------------------------------------------------------
+ * Copyright (C) 2025  Matteo Nicoli
+ *
+ * This file is part of TUR.
+ *
+ * TUR is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "alloc.h"
+#include "log.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ALLOC_ENV "TUR_ALLOC"
+/* Arena chunks are large enough to hold the tables of a big repository
+ * without going back to malloc every few commits */
+#define ARENA_CHUNK_SIZE ((size_t)1 << 20)
+/* Larger blocks get their own malloc so that tur_free can release them */
+#define ARENA_DIRECT_SIZE (ARENA_CHUNK_SIZE / 4)
+
+/* Prepended to the blocks of the count and arena backends. The alignment
+ * keeps the block itself aligned like malloc would. */
+typedef struct {
+	_Alignas(max_align_t) size_t size;
+	uint32_t tag;
+	/* Arena only: the block has been allocated with malloc */
+	uint32_t direct;
+} alloc_header_t;
+
+typedef struct {
+	size_t allocs;
+	size_t reallocs;
+	size_t frees;
+	size_t live;
+	size_t peak;
+} alloc_counters_t;
+
+typedef struct arena_chunk {
+	struct arena_chunk *next;
+	size_t size;
+	_Alignas(max_align_t) unsigned char data[];
+} arena_chunk_t;
+
+typedef struct {
+	unsigned char *next;
+	unsigned char *end;
+} arena_cursor_t;
+
+static const char *tag_names[ALLOC_N_TAGS] = {
+	"other", "repos", "walk", "cache", "render"
+};
+
+static alloc_backend_t backend = BACKEND_LIBC;
+static _Thread_local alloc_tag_t current_tag = ALLOC_OTHER;
+
+/* Count backend */
+static alloc_counters_t counters[ALLOC_N_TAGS];
+static size_t total_live = 0;
+static size_t total_peak = 0;
+
+/* Arena backend: every chunk is pushed on a single list, so that they can
+ * be released together whatever the thread that allocated them */
+static arena_chunk_t *chunks = NULL;
+static size_t arena_reserved = 0;
+static size_t arena_direct = 0;
+static _Thread_local arena_cursor_t cursor = { NULL, NULL };
+
+void alloc_init(void)
+{
+	const char *name = getenv(ALLOC_ENV);
+
+	if (!name || !*name || strcmp(name, "libc") == 0) {
+		backend = BACKEND_LIBC;
+	} else if (strcmp(name, "count") == 0) {
+		backend = BACKEND_COUNT;
+	} else if (strcmp(name, "arena") == 0) {
+		backend = BACKEND_ARENA;
+	} else {
+		(void)log_err("Unknown allocator '%s' in " ALLOC_ENV ". Set default: libc\n", name);
+		backend = BACKEND_LIBC;
+	}
+}
+
+alloc_backend_t alloc_backend(void)
+{
+	return backend;
+}
+
+alloc_tag_t alloc_set_tag(alloc_tag_t tag)
+{
+	const alloc_tag_t previous = current_tag;
+	current_tag = tag;
+	return previous;
+}
+
+size_t alloc_live_bytes(alloc_tag_t tag)
+{
+	return __atomic_load_n(&counters[tag].live, __ATOMIC_RELAXED);
+}
+
+static inline alloc_header_t *header_of(void *ptr)
+{
+	return (alloc_header_t *)ptr - 1;
+}
+
+static void raise_peak(size_t *peak, size_t value)
+{
+	size_t seen = __atomic_load_n(peak, __ATOMIC_RELAXED);
+	while (value > seen &&
+		   !__atomic_compare_exchange_n(peak, &seen, value, true,
+										__ATOMIC_RELAXED, __ATOMIC_RELAXED)) {}
+}
+
+static void count_live(alloc_tag_t tag, size_t added, size_t removed)
+{
+	alloc_counters_t *c = counters + tag;
+
+	if (added >= removed) {
+		const size_t delta = added - removed;
+		raise_peak(&c->peak, __atomic_add_fetch(&c->live, delta, __ATOMIC_RELAXED));
+		raise_peak(&total_peak, __atomic_add_fetch(&total_live, delta, __ATOMIC_RELAXED));
+	} else {
+		const size_t delta = removed - added;
+		(void)__atomic_sub_fetch(&c->live, delta, __ATOMIC_RELAXED);
+		(void)__atomic_sub_fetch(&total_live, delta, __ATOMIC_RELAXED);
+	}
+}
+
+static void *count_malloc(size_t size)
+{
+	if (size > SIZE_MAX - sizeof(alloc_header_t)) { return NULL; }
+	alloc_header_t *header = malloc(sizeof(alloc_header_t) + size);
+	if (!header) { return NULL; }
+
+	header->size = size;
+	header->tag = (uint32_t)current_tag;
+	header->direct = 0;
+	(void)__atomic_add_fetch(&counters[current_tag].allocs, 1, __ATOMIC_RELAXED);
+	count_live(current_tag, size, 0);
+	return header + 1;
+}
+
+/* A reallocated block moves to the tag of the caller */
+static void *count_realloc(void *ptr, size_t size)
+{
+	if (size > SIZE_MAX - sizeof(alloc_header_t)) { return NULL; }
+
+	alloc_header_t *header = header_of(ptr);
+	const size_t old_size = header->size;
+	const alloc_tag_t old_tag = (alloc_tag_t)header->tag;
+
+	header = realloc(header, sizeof(alloc_header_t) + size);
+	if (!header) { return NULL; }
+
+	header->size = size;
+	header->tag = (uint32_t)current_tag;
+	(void)__atomic_add_fetch(&counters[current_tag].reallocs, 1, __ATOMIC_RELAXED);
+	if (old_tag == current_tag) {
+		count_live(current_tag, size, old_size);
+	} else {
+		count_live(old_tag, 0, old_size);
+		count_live(current_tag, size, 0);
+	}
+	return header + 1;
+}
+
+static void count_free(void *ptr)
+{
+	alloc_header_t *header = header_of(ptr);
+	const alloc_tag_t tag = (alloc_tag_t)header->tag;
+
+	(void)__atomic_add_fetch(&counters[tag].frees, 1, __ATOMIC_RELAXED);
+	count_live(tag, 0, header->size);
+	free(header);
+}
+
+static bool arena_refill(size_t needed)
+{
+	const size_t size = needed > ARENA_CHUNK_SIZE ? needed : ARENA_CHUNK_SIZE;
+	arena_chunk_t *chunk = malloc(sizeof(arena_chunk_t) + size);
+	if (!chunk) { return false; }
+
+	chunk->size = size;
+	chunk->next = __atomic_load_n(&chunks, __ATOMIC_RELAXED);
+	while (!__atomic_compare_exchange_n(&chunks, &chunk->next, chunk, true,
+										__ATOMIC_RELEASE, __ATOMIC_RELAXED)) {}
+	(void)__atomic_add_fetch(&arena_reserved, size, __ATOMIC_RELAXED);
+
+	cursor.next = chunk->data;
+	cursor.end = chunk->data + size;
+	return true;
+}
+
+static void *arena_malloc(size_t size)
+{
+	if (size > SIZE_MAX - 2 * sizeof(alloc_header_t)) { return NULL; }
+
+	/* Rounded up so that the next header stays aligned */
+	const size_t rounded = (size + sizeof(alloc_header_t) - 1) & ~(sizeof(alloc_header_t) - 1);
+	const size_t needed = sizeof(alloc_header_t) + rounded;
+	alloc_header_t *header;
+
+	if (rounded >= ARENA_DIRECT_SIZE) {
+		header = malloc(sizeof(alloc_header_t) + size);
+		if (!header) { return NULL; }
+		header->direct = 1;
+		(void)__atomic_add_fetch(&arena_direct, 1, __ATOMIC_RELAXED);
+	} else {
+		if ((size_t)(cursor.end - cursor.next) < needed && !arena_refill(needed)) {
+			return NULL;
+		}
+		header = (alloc_header_t *)cursor.next;
+		cursor.next += needed;
+		header->direct = 0;
+	}
+	header->size = size;
+	header->tag = (uint32_t)current_tag;
+	return header + 1;
+}
+
+static void *arena_realloc(void *ptr, size_t size)
+{
+	alloc_header_t *header = header_of(ptr);
+	const size_t old_size = header->size;
+
+	if (header->direct) {
+		if (size > SIZE_MAX - sizeof(alloc_header_t)) { return NULL; }
+		header = realloc(header, sizeof(alloc_header_t) + size);
+		if (!header) { return NULL; }
+		header->size = size;
+		return header + 1;
+	}
+
+	const size_t old_rounded = (old_size + sizeof(alloc_header_t) - 1) & ~(sizeof(alloc_header_t) - 1);
+	const size_t rounded = (size + sizeof(alloc_header_t) - 1) & ~(sizeof(alloc_header_t) - 1);
+	unsigned char *block_end = (unsigned char *)ptr + old_rounded;
+
+	if (rounded <= old_rounded) {
+		header->size = size;
+		return ptr;
+	}
+	/* The last block of the chunk of this thread grows in place */
+	if (block_end == cursor.next && rounded < ARENA_DIRECT_SIZE &&
+		(size_t)(cursor.end - block_end) >= rounded - old_rounded) {
+		cursor.next += rounded - old_rounded;
+		header->size = size;
+		return ptr;
+	}
+
+	void *moved = arena_malloc(size);
+	if (!moved) { return NULL; }
+	memcpy(moved, ptr, old_size);
+	return moved;
+}
+
+static void arena_free(void *ptr)
+{
+	alloc_header_t *header = header_of(ptr);
+	if (header->direct) { free(header); }
+}
+
+void *tur_malloc(size_t size)
+{
+	switch (backend) {
+	case BACKEND_COUNT:
+		return count_malloc(size);
+	case BACKEND_ARENA:
+		return arena_malloc(size);
+	default:
+		return malloc(size);
+	}
+}
+
+void *tur_calloc(size_t n, size_t size)
+{
+	if (backend == BACKEND_LIBC) { return calloc(n, size); }
+	if (size && n > SIZE_MAX / size) { return NULL; }
+
+	void *ptr = tur_malloc(n * size);
+	if (ptr) { memset(ptr, 0, n * size); }
+	return ptr;
+}
+
+void *tur_realloc(void *ptr, size_t size)
+{
+	if (!ptr) { return tur_malloc(size); }
+
+	switch (backend) {
+	case BACKEND_COUNT:
+		return count_realloc(ptr, size);
+	case BACKEND_ARENA:
+		return arena_realloc(ptr, size);
+	default:
+		return realloc(ptr, size);
+	}
+}
+
+void tur_free(void *ptr)
+{
+	if (!ptr) { return; }
+
+	switch (backend) {
+	case BACKEND_COUNT:
+		count_free(ptr);
+		break;
+	case BACKEND_ARENA:
+		arena_free(ptr);
+		break;
+	default:
+		free(ptr);
+	}
+}
+
+static void print_counters(const char *name, const alloc_counters_t *c)
+{
+	(void)log_info("%-10s %10zu %10zu %10zu %12zu %12zu\n", name, c->allocs, c->reallocs,
+				   c->frees, c->peak, c->live);
+}
+
+void alloc_shutdown(void)
+{
+	if (backend == BACKEND_COUNT) {
+		alloc_counters_t sum = { 0 };
+
+		(void)log_info("\nAllocations\n%-10s %10s %10s %10s %12s %12s\n", "subsystem",
+					   "allocs", "reallocs", "frees", "peak bytes", "live bytes");
+		for (size_t tag = 0; tag < ALLOC_N_TAGS; tag++) {
+			print_counters(tag_names[tag], counters + tag);
+			sum.allocs += counters[tag].allocs;
+			sum.reallocs += counters[tag].reallocs;
+			sum.frees += counters[tag].frees;
+		}
+		/* Peaks of the subsystems are not reached at the same time */
+		sum.peak = total_peak;
+		sum.live = total_live;
+		print_counters("total", &sum);
+	} else if (backend == BACKEND_ARENA) {
+		(void)log_info("\nArena: %zu KB reserved in chunks, %zu large blocks\n",
+					   arena_reserved / 1024, arena_direct);
+		while (chunks) {
+			arena_chunk_t *next = chunks->next;
+			free(chunks);
+			chunks = next;
+		}
+		cursor.next = cursor.end = NULL;
+	}
+}
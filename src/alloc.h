@@ -0,0 +1,75 @@
+/* alloc.h
+ * -----------------------------------------------------------------------
+ * Copyright (C) 2025  Matteo Nicoli
+ *
+ * This file is part of TUR.
+ *
+ * TUR is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __ALLOC_H__
+#define __ALLOC_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/* Every allocation of tur goes through tur_malloc, tur_calloc,
+ * tur_realloc and tur_free, which forward to the backend selected with the
+ * TUR_ALLOC environment variable:
+ *     - libc (default): malloc and free, nothing else;
+ *     - count: every block carries a header with its size and tag, and the
+ *       allocations, live and peak bytes of each tag are reported at exit;
+ *     - arena: blocks are carved from per-thread chunks and released all
+ *       together at exit; tur_free only releases the large blocks.
+ * Memory obtained from libc or libgit2 (e.g. getline buffers) must still
+ * be released with their own functions. */
+
+typedef enum {
+	BACKEND_LIBC = 0,
+	BACKEND_COUNT,
+	BACKEND_ARENA
+} alloc_backend_t;
+
+/* Subsystem an allocation is accounted to: the tag of the calling thread
+ * when the block is allocated */
+typedef enum {
+	ALLOC_OTHER = 0,
+	ALLOC_REPOS,	/* Reading the repository list */
+	ALLOC_WALK,		/* Walking the histories and building the indexes */
+	ALLOC_CACHE,	/* .tur/commits and the interactive mode */
+	ALLOC_RENDER,	/* Rendering and writing the outputs */
+	ALLOC_N_TAGS
+} alloc_tag_t;
+
+/* Selects the backend: it must be called before the first allocation */
+void alloc_init(void);
+/* Prints the report of the count backend and releases the arenas. No
+ * block allocated by tur can be used after it. */
+void alloc_shutdown(void);
+/* Backend selected by alloc_init */
+alloc_backend_t alloc_backend(void);
+
+/* Sets the tag of the calling thread and returns the previous one */
+alloc_tag_t alloc_set_tag(alloc_tag_t tag);
+/* Bytes allocated with the tag and not freed yet: always 0 unless the
+ * count backend is selected */
+size_t alloc_live_bytes(alloc_tag_t tag);
+
+void *tur_malloc(size_t size);
+void *tur_calloc(size_t n, size_t size);
+void *tur_realloc(void *ptr, size_t size);
+void tur_free(void *ptr);
+
+#endif /* __ALLOC_H__ */
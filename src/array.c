@@ -19,6 +19,7 @@
  * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
  */
 
+#include "alloc.h"
 #include "array.h"
 #include "codes.h"
 
@@ -29,14 +30,14 @@
 
 return_code_t array_init(array_t **arr, size_t elem_sz)
 {
-	array_t *array = malloc(sizeof(array_t));
+	array_t *array = tur_malloc(sizeof(array_t));
 	if (!array) { return RUNTIME_MALLOC_ERROR; }
 	array->len = 0;
 	array->capacity = DEFAULT_ARRAY_SIZE;
 	array->element_size = elem_sz;
-	array->values = malloc(DEFAULT_ARRAY_SIZE * elem_sz);
+	array->values = tur_malloc(DEFAULT_ARRAY_SIZE * elem_sz);
 	if (!array->values) {
-		free(array);
+		tur_free(array);
 		return RUNTIME_ARRAY_REALLOC_ERROR;
 	}
 	*arr = array;
@@ -48,7 +49,7 @@ return_code_t array_add(array_t *src, void *elem, assign_fn_t assign_fn)
 {
 	if (src->len >= src->capacity) {
 		src->capacity += DEFAULT_ARRAY_SIZE;
-		src->values = realloc(src->values, src->capacity * src->element_size);
+		src->values = tur_realloc(src->values, src->capacity * src->element_size);
 		if (!src->values) { return RUNTIME_ARRAY_REALLOC_ERROR; }
 	}
 	assign_fn((uint8_t *)src->values + src->len * src->element_size,
@@ -91,7 +92,7 @@ void array_free(array_t **arr, free_fn_t free_element_fn)
 	for (size_t i = 0; i < array->len; i++) {
 		free_element_fn((uint8_t *)array->values + i * array->element_size);
 	}
-	free(array->values);
-	free(*arr);
+	tur_free(array->values);
+	tur_free(*arr);
 	*arr = NULL;
 }
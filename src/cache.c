@@ -38,9 +38,11 @@ uint32_t id_hash(void *key)
 	return *(uint32_t *)key;
 }
 
-static void print_commit_line(FILE *fp, const commit_t *commit)
+static void print_commit_line(FILE *fp, const commit_table_t *commits, uint32_t row)
 {
-	fprintf(fp, "%s\t%s\n", commit->hash.val, get_first_line(commit->msg).val);
+	const commit_t commit = commit_table_row(commits, row);
+	const str_t line = first_line_view(commit.msg);
+	fprintf(fp, "%s\t%.*s\n", commit.hash.val, (int)line.len, line.val);
 }
 
 static return_code_t parse_commit_file(table_t *repo_table)
@@ -72,7 +74,7 @@ static return_code_t parse_commit_file(table_t *repo_table)
 
 			/* Parsing the repo id from this line:  "+ <ID>) <NAME>" */
 			ret = parse_commit_id(&current_repo_id, line);
-			if (ret != OK) { return ret; }
+			if (ret != OK) { goto cleanup; }
 
 			cache_array_init(&current_commits);
 
@@ -80,7 +82,10 @@ static return_code_t parse_commit_file(table_t *repo_table)
 			if (strlen(line) == 0) { continue; }
 
 			char *end_of_hash = strchr(line, '\t');
-			if (!end_of_hash) { return COMMITS_FILE_HASH_CORRUPTED; }
+			if (!end_of_hash) {
+				ret = COMMITS_FILE_HASH_CORRUPTED;
+				goto cleanup;
+			}
 			
 			size_t hash_len = (size_t)(end_of_hash - line);
 			str_t hash = str_init(line, hash_len);
@@ -93,7 +98,9 @@ static return_code_t parse_commit_file(table_t *repo_table)
 				.is_favorite = strstr(end_of_hash, FAVORITE_STR),
 			};
 
+			/* The array holds a copy of the hash */
 			ret = cache_array_add(current_commits, &idx);
+			str_free(hash);
 			if (ret == RUNTIME_ARRAY_REALLOC_ERROR) {
 				(void)log_err("parse_commit_file: cannot allocate enough "
 							  "memory for the commit list in `%s`",
@@ -109,6 +116,9 @@ static return_code_t parse_commit_file(table_t *repo_table)
 	}
 
 cleanup:
+	if (current_commits) {
+		cache_array_free(&current_commits);
+	}
 	free(line);
 	fclose(fp);
 
@@ -122,17 +132,17 @@ static return_code_t repo_index(repository_t *repo, const cacheidx_arr_t *commit
 
 	for (size_t i = 0; i < commits->len; i++) {
 		cache_index_t *commit_idx = cache_array_get(commits, i);
-		commit_t *c = get_commit_with_id(history->commit_arr, commit_idx->hash);
-		if (!c) {
+		uint32_t row;
+		if (!commit_table_find(&history->commits, commit_idx->hash, &row)) {
 			(void)log_err("repo_index: cannot find commit `%s`\n",
 						  commit_idx->hash.val);
 			return COMMIT_NOT_FOUND;
 		}
 
-		if (c->responsability == AUTHORED) {
-			history->indexes.authored[authored_count++] = c;
+		if (history->commits.responsabilities[row] == AUTHORED) {
+			history->indexes.authored[authored_count++] = row;
 		} else {
-			history->indexes.co_authored[co_authored_count++] = c;
+			history->indexes.co_authored[co_authored_count++] = row;
 		}
 	}
 
@@ -181,15 +191,17 @@ return_code_t write_repos_on_file(const repository_array_t *repos)
 	for (size_t i = 0; i < repos->len; i++) {
 		repository_t *repo = repo_array_get(repos, i);
 		const work_history_t *history = repo->history;
-		commit_t **const authored = history->indexes.authored;
-		commit_t **const co_authored = history->indexes.co_authored;
+		uint32_t *const authored = history->indexes.authored;
+		uint32_t *const co_authored = history->indexes.co_authored;
 
-		fprintf(fp, "+ %u) %s\n", repo->id, repo->name.val);
+		/* The repository id is all that is parsed back (see parse_commit_id) */
+		fprintf(fp, "+ %u) %s%s\n", repo->id, repo->name.val,
+				truncation_note(history->truncated));
 		for (size_t j = 0; j < history->n_authored; j++) {
-			print_commit_line(fp, authored[j]);
+			print_commit_line(fp, &history->commits, authored[j]);
 		}
 		for (size_t j = 0; j < history->n_co_authored; j++) {
-			print_commit_line(fp, co_authored[j]);
+			print_commit_line(fp, &history->commits, co_authored[j]);
 		}
 	}
 
@@ -209,16 +221,18 @@ return_code_t rebuild_indexes(const repository_array_t *repos)
 
 	table_init(&repo_table, 10, 10, id_hash);
 	ret = parse_commit_file(&repo_table);
-	if (ret != OK) { return ret; }
+	if (ret != OK) { goto cleanup; }
 
 	for (size_t i = 0; i < repos->len; i++) {
 		cacheidx_arr_t *commits = table_get(&repo_table, i);
 		if (!commits) { continue; }
 		repository_t *repo = repo_array_get(repos, i);
 		ret = repo_index(repo, commits);
-		if (ret != OK) { return ret; }
+		if (ret != OK) { goto cleanup; }
 	}
 
+cleanup:
+	table_free(&repo_table);
 	return ret;
 }
 
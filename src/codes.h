@@ -50,7 +50,11 @@ typedef enum {
 	COMMIT_NOT_FOUND              = 0x16,
 	COMMITS_FILE_HASH_CORRUPTED   = 0x17,
 	COMMITS_FILE_INVALID_REPO_ID  = 0x18,
+	CANNOT_OPEN_OUTPUT            = 0x19,
+	CANNOT_WRITE_OUTPUT           = 0x1A,
+	CANNOT_OPEN_SOCKET            = 0x1B,
 
+	RUNTIME_PIPE_ERROR            = 0xFB,
 	RUNTIME_ARRAY_REALLOC_ERROR   = 0xFC,
 	RUNTIME_LOGGER_ERROR          = 0xFD,
 	RUNTIME_THREAD_CREATE_ERROR   = 0xFE,
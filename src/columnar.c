@@ -0,0 +1,245 @@
+/* columnar.c
+ * -----------------------------------------------------------------------
+ * Copyright (C) 2025  Matteo Nicoli
+ *
+ * This file is part of TUR.
+ *
+ * TUR is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "alloc.h"
+#include "columnar.h"
+#include "commit.h"
+#include "log.h"
+#include "repo.h"
+#include "settings.h"
+#include "sink.h"
+#include "timeline.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/* Position of a commit in the export: the rows are collected with a single
+ * pass over the timeline, then every column is written with its own pass
+ * over them. */
+typedef struct {
+	const repository_t *repo;
+	str_t msg;
+	uint32_t row;
+	uint8_t responsability;
+} columnar_ref_t;
+
+static uint64_t align_offset(uint64_t offset)
+{
+	return (offset + COLUMNAR_ALIGNMENT - 1) & ~(uint64_t)(COLUMNAR_ALIGNMENT - 1);
+}
+
+static void put_padding(sink_t *out, uint64_t offset)
+{
+	static const char zeros[COLUMNAR_ALIGNMENT] = { 0 };
+	sink_write(out, zeros, align_offset(offset) - offset);
+}
+
+static uint8_t hex_value(char c)
+{
+	if (c >= '0' && c <= '9') { return (uint8_t)(c - '0'); }
+	if (c >= 'a' && c <= 'f') { return (uint8_t)(c - 'a' + 10); }
+	if (c >= 'A' && c <= 'F') { return (uint8_t)(c - 'A' + 10); }
+	return 0;
+}
+
+static void put_oid(sink_t *out, str_t hash)
+{
+	char *oid = sink_reserve(out, COLUMNAR_OID_SIZE);
+	if (!oid) { return; }
+
+	for (size_t i = 0; i < COLUMNAR_OID_SIZE; i++) {
+		oid[i] = (char)(hex_value(hash.val[2 * i]) << 4 | hex_value(hash.val[2 * i + 1]));
+	}
+	sink_commit(out, COLUMNAR_OID_SIZE);
+}
+
+static columnar_ref_t *collect_refs(const repository_array_t *repos,
+									const settings_t *settings, size_t *n_refs)
+{
+	timeline_t timeline;
+	timeline_item_t item;
+	size_t n = 0;
+
+	for (size_t i = 0; i < repos->len; i++) {
+		const work_history_t *history = repo_array_get(repos, i)->history;
+		n += history->n_authored + history->n_co_authored;
+	}
+
+	columnar_ref_t *refs = tur_malloc((n ? n : 1) * sizeof(columnar_ref_t));
+	if (!refs) { return NULL; }
+
+	if (timeline_init(&timeline, repos, settings) != OK) {
+		tur_free(refs);
+		return NULL;
+	}
+
+	*n_refs = 0;
+	while (*n_refs < n && timeline_next(&timeline, &item)) {
+		refs[*n_refs] = (columnar_ref_t) {
+			.repo = item.repo,
+			.msg = item.commit.msg,
+			.row = item.row,
+			.responsability = (uint8_t)item.responsability
+		};
+		(*n_refs)++;
+	}
+	timeline_free(&timeline);
+
+	return refs;
+}
+
+static void compute_layout(columnar_header_t *header, const columnar_ref_t *refs,
+						   size_t n_refs, const repository_array_t *repos)
+{
+	const uint64_t n = n_refs;
+	const uint64_t widths[COLUMNAR_N_COLUMNS] = {
+		[COLUMNAR_REPO_ID] = n * sizeof(uint32_t),
+		[COLUMNAR_DATE] = n * sizeof(int64_t),
+		[COLUMNAR_RESPONSABILITY] = n * sizeof(uint8_t),
+		[COLUMNAR_FILES_CHANGED] = n * sizeof(uint32_t),
+		[COLUMNAR_LINES_ADDED] = n * sizeof(uint32_t),
+		[COLUMNAR_LINES_REMOVED] = n * sizeof(uint32_t),
+		[COLUMNAR_OID] = n * COLUMNAR_OID_SIZE,
+		[COLUMNAR_MSG_OFFSET] = (n + 1) * sizeof(uint64_t),
+		[COLUMNAR_REPO_NAME_OFFSET] = (repos->len + 1) * sizeof(uint64_t),
+	};
+	uint64_t heap_size = 0;
+
+	for (size_t i = 0; i < n_refs; i++) {
+		heap_size += refs[i].msg.len;
+	}
+	for (size_t i = 0; i < repos->len; i++) {
+		heap_size += repo_array_get(repos, i)->name.len;
+	}
+
+	*header = (columnar_header_t) {
+		.magic = COLUMNAR_MAGIC,
+		.version = COLUMNAR_VERSION,
+		.byte_order = COLUMNAR_BYTE_ORDER_MARK,
+		.n_commits = n,
+		.n_repos = repos->len,
+		.heap_size = heap_size,
+	};
+
+	uint64_t offset = align_offset(sizeof(columnar_header_t));
+	for (size_t col = 0; col < COLUMNAR_N_COLUMNS; col++) {
+		header->offsets[col] = offset;
+		offset = align_offset(offset + (col == COLUMNAR_HEAP ? heap_size : widths[col]));
+	}
+	header->file_size = offset;
+}
+
+static void write_column(sink_t *out, const columnar_ref_t *refs, size_t n_refs,
+						 columnar_column_t col)
+{
+	for (size_t i = 0; i < n_refs; i++) {
+		const commit_table_t *commits = &refs[i].repo->history->commits;
+		const uint32_t row = refs[i].row;
+		uint32_t u32;
+		int64_t i64;
+
+		switch (col) {
+		case COLUMNAR_REPO_ID:
+			u32 = refs[i].repo->id;
+			sink_write(out, (const char *)&u32, sizeof(u32));
+			break;
+		case COLUMNAR_DATE:
+			i64 = commits->dates[row];
+			sink_write(out, (const char *)&i64, sizeof(i64));
+			break;
+		case COLUMNAR_RESPONSABILITY:
+			sink_putc(out, (char)refs[i].responsability);
+			break;
+		case COLUMNAR_FILES_CHANGED:
+			sink_write(out, (const char *)(commits->files_changed + row), sizeof(uint32_t));
+			break;
+		case COLUMNAR_LINES_ADDED:
+			sink_write(out, (const char *)(commits->lines_added + row), sizeof(uint32_t));
+			break;
+		case COLUMNAR_LINES_REMOVED:
+			sink_write(out, (const char *)(commits->lines_removed + row), sizeof(uint32_t));
+			break;
+		case COLUMNAR_OID:
+			put_oid(out, commit_table_hash(commits, row));
+			break;
+		default:
+			return;
+		}
+	}
+}
+
+static void write_string_offsets(sink_t *out, const columnar_ref_t *refs, size_t n_refs,
+								 const repository_array_t *repos)
+{
+	uint64_t offset = 0;
+
+	for (size_t i = 0; i < n_refs; i++) {
+		sink_write(out, (const char *)&offset, sizeof(offset));
+		offset += refs[i].msg.len;
+	}
+	sink_write(out, (const char *)&offset, sizeof(offset));
+	put_padding(out, sink_size(out));
+
+	for (size_t i = 0; i < repos->len; i++) {
+		sink_write(out, (const char *)&offset, sizeof(offset));
+		offset += repo_array_get(repos, i)->name.len;
+	}
+	sink_write(out, (const char *)&offset, sizeof(offset));
+	put_padding(out, sink_size(out));
+}
+
+/* Rows follow the same order as the list outputs (see timeline_t); the
+ * columnar layout needs the row count up front, so this format is never
+ * rendered by sections and -g has no effect on it. */
+void generate_columnar_file(sink_t *out, const repository_array_t *repos,
+							const settings_t *settings, const sink_t *sections)
+{
+	columnar_header_t header;
+	size_t n_refs = 0;
+	(void)sections;
+
+	columnar_ref_t *refs = collect_refs(repos, settings, &n_refs);
+	if (!refs) {
+		(void)log_err("generate_columnar_file: cannot collect the commits\n");
+		return;
+	}
+
+	compute_layout(&header, refs, n_refs, repos);
+	sink_write(out, (const char *)&header, sizeof(header));
+	put_padding(out, sink_size(out));
+
+	for (columnar_column_t col = COLUMNAR_REPO_ID; col <= COLUMNAR_OID; col++) {
+		write_column(out, refs, n_refs, col);
+		put_padding(out, sink_size(out));
+	}
+
+	write_string_offsets(out, refs, n_refs, repos);
+
+	for (size_t i = 0; i < n_refs; i++) {
+		sink_put_str(out, refs[i].msg);
+	}
+	for (size_t i = 0; i < repos->len; i++) {
+		sink_put_str(out, repo_array_get(repos, i)->name);
+	}
+	put_padding(out, sink_size(out));
+
+	tur_free(refs);
+}
@@ -0,0 +1,74 @@
+/* columnar.h
+ * -----------------------------------------------------------------------
+ * Copyright (C) 2025  Matteo Nicoli
+ *
+ * This file is part of TUR.
+ *
+ * TUR is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __COLUMNAR_H__
+#define __COLUMNAR_H__
+
+#include <stdint.h>
+
+/* Binary columnar export (.turc). The file is meant to be mapped and
+ * scanned in place:
+ *
+ *     columnar_header_t
+ *     column 0 ... column COLUMNAR_N_COLUMNS - 1
+ *
+ * Every column starts at the offset stored in the header, aligned to
+ * COLUMNAR_ALIGNMENT bytes, and has one fixed-width value per commit
+ * (per repository for COLUMNAR_REPO_NAME_OFFSET). Strings live in the heap
+ * column and are addressed by [offsets[i], offsets[i + 1]). Integers are
+ * written in the byte order of the host that produced the file: readers
+ * check byte_order against COLUMNAR_BYTE_ORDER_MARK. */
+
+#define COLUMNAR_MAGIC "TURCOLS"
+#define COLUMNAR_MAGIC_SIZE 8
+#define COLUMNAR_VERSION 1
+#define COLUMNAR_BYTE_ORDER_MARK 0x01020304u
+#define COLUMNAR_ALIGNMENT 8
+#define COLUMNAR_OID_SIZE 20
+
+typedef enum {
+	COLUMNAR_REPO_ID = 0,       /* uint32_t, index of the repository */
+	COLUMNAR_DATE,              /* int64_t, seconds since the epoch */
+	COLUMNAR_RESPONSABILITY,    /* uint8_t, 0 authored, 1 co-authored */
+	COLUMNAR_FILES_CHANGED,     /* uint32_t */
+	COLUMNAR_LINES_ADDED,       /* uint32_t */
+	COLUMNAR_LINES_REMOVED,     /* uint32_t */
+	COLUMNAR_OID,               /* uint8_t[COLUMNAR_OID_SIZE], binary hash */
+	COLUMNAR_MSG_OFFSET,        /* uint64_t, n_commits + 1 entries */
+	COLUMNAR_REPO_NAME_OFFSET,  /* uint64_t, n_repos + 1 entries */
+	COLUMNAR_HEAP,              /* char, messages then repository names */
+	COLUMNAR_N_COLUMNS
+} columnar_column_t;
+
+typedef struct {
+	char magic[COLUMNAR_MAGIC_SIZE];
+	uint32_t version;
+	uint32_t byte_order;
+	uint64_t n_commits;
+	uint64_t n_repos;
+	uint64_t heap_size;
+	/* Offsets from the start of the file */
+	uint64_t offsets[COLUMNAR_N_COLUMNS];
+	/* Size of the whole file */
+	uint64_t file_size;
+} columnar_header_t;
+
+#endif /* __COLUMNAR_H__ */
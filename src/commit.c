@@ -19,10 +19,13 @@
  * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
  */
 
+#include "alloc.h"
 #include "codes.h"
 #include "commit.h"
 #include "log.h"
+#include "progress.h"
 #include "str.h"
+#include "trace.h"
 
 #include <stdbool.h>
 #include <stdint.h>
@@ -31,59 +34,228 @@
 
 #define COAUTHOR_PREFIX "Co-authored-by:"
 #define COAUTHOR_PREFIX_LEN 15
+#define HEADS_PREFIX "refs/heads/"
+#define HEADS_PREFIX_LEN 11
+#define REF_NAME_MAX_LEN 1024
+#define RANGE_SEP ".."
+#define SYMMETRIC_RANGE_SEP "..."
+#define HIDE_PREFIX '^'
+/* Must be a power of two */
+#define OWNER_MAP_DEFAULT_SIZE 1024
+#define COMMIT_TABLE_DEFAULT_SIZE 64
+#define OID_STACK_DEFAULT_SIZE 64
+#define MSG_HEAP_DEFAULT_SIZE 4096
+#define WALKED_COMMITS_BATCH 64
+#define NS_PER_SECOND 1000000000ull
 
-static void assign_commit(void *src, void *elem)
+/* Reallocates a single column: on failure the old column is left as it is,
+ * so the table can still be freed. */
+static bool grow_column(void **column, size_t elem_sz, size_t capacity)
 {
-	commit_t *tmp = commit_copy((commit_t *)elem);
-	*(commit_t *)src = *tmp;
-	free(tmp);
+	void *tmp = tur_realloc(*column, capacity * elem_sz);
+	if (!tmp) { return false; }
+	*column = tmp;
+	return true;
 }
 
-static int compare_commit(void *c1, void *c2)
+static return_code_t commit_table_reserve(commit_table_t *table, size_t capacity)
 {
-	commit_t *commit1 = (commit_t *)c1;
-	commit_t *commit2 = (commit_t *)c2;
-	return str_compare(commit1->hash, commit2->hash);
+	if (capacity <= table->capacity) { return OK; }
+
+	const bool ok =
+		grow_column((void **)&table->dates, sizeof(time_t), capacity)
+		&& grow_column((void **)&table->responsabilities, sizeof(uint8_t), capacity)
+		&& grow_column((void **)&table->files_changed, sizeof(uint32_t), capacity)
+		&& grow_column((void **)&table->lines_added, sizeof(uint32_t), capacity)
+		&& grow_column((void **)&table->lines_removed, sizeof(uint32_t), capacity)
+		&& grow_column((void **)&table->hashes, GIT_HASH_LEN + 1, capacity)
+		&& grow_column((void **)&table->msg_offsets, sizeof(size_t), capacity);
+	if (!ok) { return RUNTIME_ARRAY_REALLOC_ERROR; }
+
+	table->capacity = capacity;
+	return OK;
+}
+
+static return_code_t msg_heap_reserve(commit_table_t *table, size_t len)
+{
+	size_t capacity = table->msg_heap_capacity;
+
+	if (len <= capacity) { return OK; }
+	while (capacity < len) {
+		capacity = capacity ? capacity * 2 : MSG_HEAP_DEFAULT_SIZE;
+	}
+	if (!grow_column((void **)&table->msg_heap, sizeof(char), capacity)) {
+		return RUNTIME_ARRAY_REALLOC_ERROR;
+	}
+	table->msg_heap_capacity = capacity;
+	return OK;
 }
 
-static void free_commit(void *c)
+static inline uint32_t clamp_u32(size_t value)
 {
-	commit_t *commit = (commit_t *)c;
-	commit_free(commit);
+	return value > UINT32_MAX ? UINT32_MAX : (uint32_t)value;
+}
+
+return_code_t commit_table_init(commit_table_t *table, size_t capacity)
+{
+	*table = (commit_table_t) { 0 };
+	return commit_table_reserve(table, capacity ? capacity : COMMIT_TABLE_DEFAULT_SIZE);
+}
+
+return_code_t commit_table_add(commit_table_t *table, const char *hash,
+							   const char *msg, time_t date,
+							   responsability_t responsability,
+							   const commit_stats_t *stats)
+{
+	const size_t msg_len = strlen(msg);
+	return_code_t ret;
+
+	if (table->len == UINT32_MAX) { return RUNTIME_ARRAY_REALLOC_ERROR; }
+
+	if (table->len == table->capacity) {
+		ret = commit_table_reserve(table, table->capacity ? table->capacity * 2
+														  : COMMIT_TABLE_DEFAULT_SIZE);
+		if (ret != OK) { return ret; }
+	}
+	ret = msg_heap_reserve(table, table->msg_heap_len + msg_len + 1);
+	if (ret != OK) { return ret; }
+
+	const size_t row = table->len;
+	char *row_hash = table->hashes + row * (GIT_HASH_LEN + 1);
+
+	table->dates[row] = date;
+	table->responsabilities[row] = (uint8_t)responsability;
+	table->files_changed[row] = clamp_u32(stats->files_changed);
+	table->lines_added[row] = clamp_u32(stats->lines_added);
+	table->lines_removed[row] = clamp_u32(stats->lines_removed);
+
+	/* Hashes shorter than GIT_HASH_LEN are padded with NULs */
+	strncpy(row_hash, hash, GIT_HASH_LEN);
+	row_hash[GIT_HASH_LEN] = '\0';
+
+	table->msg_offsets[row] = table->msg_heap_len;
+	memcpy(table->msg_heap + table->msg_heap_len, msg, msg_len + 1);
+	table->msg_heap_len += msg_len + 1;
+
+	table->len++;
+	return OK;
 }
 
-void commit_array_init(commit_arr_t **arr)
+return_code_t commit_table_copy(commit_table_t *dst, const commit_table_t *src)
 {
-	return_code_t ret = array_init(arr, sizeof(commit_t));
-	if (ret == RUNTIME_MALLOC_ERROR) {
-		(void)log_err("get_commit_history: cannot allocate commits array. "
-					  "Capacity: %zu...\n", (*arr)->capacity);
+	return_code_t ret = commit_table_init(dst, src->len);
+	if (ret == OK) {
+		ret = msg_heap_reserve(dst, src->msg_heap_len);
 	}
+	if (ret != OK) {
+		commit_table_free(dst);
+		return ret;
+	}
+
+	const size_t n = src->len;
+	if (n > 0) {
+		memcpy(dst->dates, src->dates, n * sizeof(time_t));
+		memcpy(dst->responsabilities, src->responsabilities, n * sizeof(uint8_t));
+		memcpy(dst->files_changed, src->files_changed, n * sizeof(uint32_t));
+		memcpy(dst->lines_added, src->lines_added, n * sizeof(uint32_t));
+		memcpy(dst->lines_removed, src->lines_removed, n * sizeof(uint32_t));
+		memcpy(dst->hashes, src->hashes, n * (GIT_HASH_LEN + 1));
+		memcpy(dst->msg_offsets, src->msg_offsets, n * sizeof(size_t));
+	}
+	if (src->msg_heap_len > 0) {
+		memcpy(dst->msg_heap, src->msg_heap, src->msg_heap_len);
+	}
+	dst->len = n;
+	dst->msg_heap_len = src->msg_heap_len;
+
+	return OK;
 }
 
-commit_t *commit_array_get(const commit_arr_t *src, size_t i)
+bool commit_table_find(const commit_table_t *table, str_t hash, uint32_t *row)
 {
-	return (commit_t *)src->values + i;
+	if (hash.len == 0 || hash.len > GIT_HASH_LEN) { return false; }
+
+	for (size_t i = 0; i < table->len; i++) {
+		const char *current = table->hashes + i * (GIT_HASH_LEN + 1);
+		if (memcmp(current, hash.val, hash.len) == 0 && current[hash.len] == '\0') {
+			*row = (uint32_t)i;
+			return true;
+		}
+	}
+
+	return false;
 }
 
-return_code_t commit_array_add(commit_arr_t *src, commit_t *commit)
+/* Writes the ids of the rows with the given responsability, in table order.
+ * Only the responsability column is read. */
+size_t commit_table_select(const commit_table_t *table, responsability_t responsability,
+						   uint32_t *rows)
 {
-	return array_add(src, commit, assign_commit);
+	const uint8_t *resp = table->responsabilities;
+	const uint8_t wanted = (uint8_t)responsability;
+	size_t n = 0;
+
+	for (size_t i = 0; i < table->len; i++) {
+		if (resp[i] == wanted) {
+			rows[n++] = (uint32_t)i;
+		}
+	}
+
+	return n;
 }
 
-commit_arr_t *commit_array_copy(const commit_arr_t *src)
+void commit_table_sum_lines(const commit_table_t *table, size_t *added, size_t *removed)
 {
-	return array_copy(src, assign_commit);
+	size_t tot_added = 0, tot_removed = 0;
+
+	for (size_t i = 0; i < table->len; i++) {
+		tot_added += table->lines_added[i];
+		tot_removed += table->lines_removed[i];
+	}
+
+	*added = tot_added;
+	*removed = tot_removed;
 }
 
-bool commit_array_contains(const commit_arr_t *src, commit_t *commit)
+/* Returns a commit whose hash and message point into the table.
+ * !!! DO NOT FREE THEM !!!
+ * Messages are appended in row order, so the length of a message is the
+ * distance to the next one, minus its NUL: the message is not read.
+ */
+commit_t commit_table_row(const commit_table_t *table, uint32_t row)
 {
-	return array_contains(src, commit, compare_commit);
+	const size_t offset = table->msg_offsets[row];
+	const size_t end = row + 1 < table->len ? table->msg_offsets[row + 1] : table->msg_heap_len;
+	const char *msg = table->msg_heap + offset;
+	const size_t msg_len = end - offset - 1;
+
+	return (commit_t) {
+		.hash = commit_table_hash(table, row),
+		.responsability = (responsability_t)table->responsabilities[row],
+		.date = table->dates[row],
+		.msg = (str_t) {
+			.val = msg,
+			.len = msg_len > UINT16_MAX ? UINT16_MAX : (uint16_t)msg_len
+		},
+		.stats = (commit_stats_t) {
+			.files_changed = table->files_changed[row],
+			.lines_added = table->lines_added[row],
+			.lines_removed = table->lines_removed[row]
+		}
+	};
 }
 
-void commit_array_free(commit_arr_t **arr)
+void commit_table_free(commit_table_t *table)
 {
-	array_free(arr, free_commit);
+	tur_free(table->dates);
+	tur_free(table->responsabilities);
+	tur_free(table->files_changed);
+	tur_free(table->lines_added);
+	tur_free(table->lines_removed);
+	tur_free(table->hashes);
+	tur_free(table->msg_offsets);
+	tur_free(table->msg_heap);
+	*table = (commit_table_t) { 0 };
 }
 
 static bool is_author(const git_signature *author, str_array_t *emails)
@@ -115,7 +287,7 @@ static bool is_co_author(const char *message, str_array_t *emails)
 
 			if (email_start && email_end && email_start < email_end) {
 				size_t email_len = email_end - email_start - 1;
-				char *coauthor_email = malloc(email_len + 1);
+				char *coauthor_email = tur_malloc(email_len + 1);
 				if (coauthor_email) {
 					strncpy(coauthor_email, email_start + 1, email_len);
 					coauthor_email[email_len] = '\0';
@@ -123,11 +295,11 @@ static bool is_co_author(const char *message, str_array_t *emails)
 					for (size_t i = 0; i < emails->len; i++) {
 						str_t email = str_array_get(emails, i);
 						if (str_arr_equals(email, coauthor_email)) {
-							free(coauthor_email);
+							tur_free(coauthor_email);
 							return true;
 						}
 					}
-					free(coauthor_email);
+					tur_free(coauthor_email);
 				}
 			}
 		}
@@ -165,6 +337,7 @@ static void print_error(uint16_t return_code, const char *hash)
 
 static uint16_t get_commit_stats(commit_stats_t *stats, const git_commit *commit, const git_repository *repo)
 {
+	uint16_t ret = OK;
 	int res;
 	
 	if (git_commit_parentcount(commit) == 0) { return OK; }
@@ -174,16 +347,22 @@ static uint16_t get_commit_stats(commit_stats_t *stats, const git_commit *commit
 	if (res != 0) { return PARENT_COMMIT_UNAVAILBLE; }
 	
 	git_tree *commit_tree = NULL, *parent_tree = NULL;
+	git_diff *diff = NULL;
+	git_diff_stats *git_stats = NULL;
 	git_commit_tree(&commit_tree, commit);
 	git_commit_tree(&parent_tree, parent_commit);
 	
-	git_diff *diff = NULL;
 	res = git_diff_tree_to_tree(&diff, (git_repository *)repo, parent_tree, commit_tree, NULL); 
-	if (res != 0) { return COMPARE_TREES_ERROR; }
+	if (res != 0) {
+		ret = COMPARE_TREES_ERROR;
+		goto cleanup;
+	}
 	
-	git_diff_stats *git_stats = NULL;
 	res = git_diff_get_stats(&git_stats, diff);
-	if (res != 0) { return CANNOT_RETRIEVE_STATS; }
+	if (res != 0) {
+		ret = CANNOT_RETRIEVE_STATS;
+		goto cleanup;
+	}
 
 	*stats = (commit_stats_t) {
 		.files_changed = git_diff_stats_files_changed(git_stats),
@@ -191,66 +370,664 @@ static uint16_t get_commit_stats(commit_stats_t *stats, const git_commit *commit
 		.lines_removed = git_diff_stats_deletions(git_stats)
 	};
 
-	return OK;
+cleanup:
+	git_diff_stats_free(git_stats);
+	git_diff_free(diff);
+	git_tree_free(parent_tree);
+	git_tree_free(commit_tree);
+	git_commit_free(parent_commit);
+	return ret;
+}
+
+/* Maps every visited commit to the first ref (in walk order) that reaches it.
+ * Since the walk is topological, a commit is always visited before its
+ * parents, so the owner of a parent is known before the parent is visited. */
+typedef struct {
+	git_oid oid;
+	uint32_t ref;
+	bool used;
+} owner_slot_t;
+
+typedef struct {
+	owner_slot_t *slots;
+	size_t capacity;
+	size_t size;
+} owner_map_t;
+
+static inline size_t owner_slot_index(const git_oid *oid, size_t capacity)
+{
+	uint32_t h;
+	/* Object ids are already uniformly distributed */
+	memcpy(&h, oid->id, sizeof(h));
+	return h & (capacity - 1);
 }
 
-work_history_t *get_commit_history(str_t repo_path, const char *branch_name, const settings_t *settings)
+static bool owner_map_init(owner_map_t *map, size_t capacity)
+{
+	map->slots = tur_calloc(capacity, sizeof(owner_slot_t));
+	map->capacity = capacity;
+	map->size = 0;
+	return map->slots != NULL;
+}
+
+static uint32_t owner_map_get(const owner_map_t *map, const git_oid *oid)
+{
+	size_t i = owner_slot_index(oid, map->capacity);
+	while (map->slots[i].used) {
+		if (git_oid_equal(&map->slots[i].oid, oid)) { return map->slots[i].ref; }
+		i = (i + 1) & (map->capacity - 1);
+	}
+	return 0;
+}
+
+static bool owner_map_put(owner_map_t *map, const git_oid *oid, uint32_t ref);
+
+static bool owner_map_grow(owner_map_t *map)
+{
+	owner_map_t bigger;
+	if (!owner_map_init(&bigger, map->capacity * 2)) { return false; }
+	for (size_t i = 0; i < map->capacity; i++) {
+		if (map->slots[i].used) {
+			(void)owner_map_put(&bigger, &map->slots[i].oid, map->slots[i].ref);
+		}
+	}
+	tur_free(map->slots);
+	*map = bigger;
+	return true;
+}
+
+/* Keeps the first owner: it returns without changes if the oid is already mapped */
+static bool owner_map_put(owner_map_t *map, const git_oid *oid, uint32_t ref)
+{
+	if (map->size >= map->capacity / 2 && !owner_map_grow(map)) { return false; }
+
+	size_t i = owner_slot_index(oid, map->capacity);
+	while (map->slots[i].used) {
+		if (git_oid_equal(&map->slots[i].oid, oid)) { return true; }
+		i = (i + 1) & (map->capacity - 1);
+	}
+	map->slots[i] = (owner_slot_t) {
+		.oid = *oid,
+		.ref = ref,
+		.used = true
+	};
+	map->size++;
+	return true;
+}
+
+static void owner_map_free(owner_map_t *map)
+{
+	tur_free(map->slots);
+	map->slots = NULL;
+}
+
+static const char *short_ref_name(const char *ref_name)
+{
+	if (strncmp(ref_name, HEADS_PREFIX, HEADS_PREFIX_LEN) == 0) {
+		return ref_name + HEADS_PREFIX_LEN;
+	}
+	return ref_name;
+}
+
+static bool push_tip(git_revwalk *walker, owner_map_t *tips, const char *name,
+					 const git_oid *oid, uint32_t ref)
+{
+	if (git_revwalk_push(walker, oid) != 0) {
+		(void)log_err("Cannot push the initial commit of `%s`\n", name);
+		return false;
+	}
+	/* Two refs pointing to the same commit: the first one owns it */
+	return owner_map_put(tips, oid, ref);
+}
+
+static bool add_ref(str_array_t *refs, const char *name)
+{
+	str_t ref_name = str_init(name, (uint16_t)strlen(name));
+	return_code_t ret = str_array_add(refs, ref_name);
+	str_free(ref_name);
+
+	return ret == OK;
+}
+
+static bool add_tip(str_array_t *refs, owner_map_t *tips, git_revwalk *walker,
+					const char *name, const git_oid *oid)
+{
+	return push_tip(walker, tips, name, oid, (uint32_t)refs->len)
+		   && add_ref(refs, name);
+}
+
+static bool push_ref_glob(str_array_t *refs, owner_map_t *tips, git_revwalk *walker,
+						  git_repository *git_repo, str_t repo_path, const char *glob)
+{
+	git_reference_iterator *iter = NULL;
+	git_reference *ref = NULL;
+	bool ok = true;
+
+	if (git_reference_iterator_glob_new(&iter, git_repo, glob) != 0) {
+		(void)log_err("%s: Cannot iterate over refs matching `%s`\n", repo_path.val, glob);
+		return false;
+	}
+
+	while (ok && git_reference_next(&ref, iter) == 0) {
+		git_object *ref_commit = NULL;
+		/* Refs that do not point to a commit (e.g. tags of trees) are skipped */
+		if (git_reference_peel(&ref_commit, ref, GIT_OBJECT_COMMIT) == 0) {
+			ok = add_tip(refs, tips, walker, short_ref_name(git_reference_name(ref)),
+						 git_object_id(ref_commit));
+			git_object_free(ref_commit);
+		}
+		git_reference_free(ref);
+	}
+
+	git_reference_iterator_free(iter);
+
+	if (ok && refs->len == 0) {
+		(void)log_err("%s: No ref matches `%s`\n", repo_path.val, glob);
+		return false;
+	}
+	return ok;
+}
+
+static bool push_branch(str_array_t *refs, owner_map_t *tips, git_revwalk *walker,
+						git_repository *git_repo, str_t repo_path, const char *branch_name)
 {
-	git_repository *git_repo = NULL;
-	git_revwalk *walker = NULL;
-	git_commit *raw_commit = NULL;
 	git_reference *branch_ref = NULL;
 	git_object *branch_commit = NULL;
-	work_history_t *history = NULL;
-	size_t n_authored = 0, n_co_authored = 0;
-	git_oid oid;
 
-	if (git_repository_open(&git_repo, repo_path.val) != 0) {
-		(void)log_err("Failed to open repository `%s`\n", repo_path.val);
-		goto ret;
+	if (git_branch_lookup(&branch_ref, git_repo, branch_name, GIT_BRANCH_LOCAL) != 0) {
+		(void)log_err("%s: Cannot find a *local* branch named `%s`\n", repo_path.val, branch_name);
+		return false;
 	}
 
-	if (git_revwalk_new(&walker, git_repo) != 0) {
-		(void)log_err("An error occurred while reading from `%s`\n", repo_path.val);
+	if (git_reference_peel(&branch_commit, branch_ref, GIT_OBJECT_COMMIT) != 0) {
+		(void)log_err("%s: Cannot find the HEAD of `%s`\n", repo_path.val, branch_name);
+		git_reference_free(branch_ref);
+		return false;
+	}
+
+	bool ok = add_tip(refs, tips, walker, branch_name, git_object_id(branch_commit));
+	git_object_free(branch_commit);
+	git_reference_free(branch_ref);
+
+	return ok;
+}
+
+/* `A..B` walks the commits reachable from B but not from A. A range that
+ * cannot be resolved is reported and skipped: false only means that the
+ * walk cannot go on. */
+static bool push_range(str_array_t *refs, owner_map_t *tips, git_revwalk *walker,
+					   git_repository *git_repo, str_t repo_path, const char *range)
+{
+	git_revspec spec = { 0 };
+	git_object *tip = NULL;
+	bool ok = true;
+
+	if (strstr(range, SYMMETRIC_RANGE_SEP)) {
+		(void)log_err("%s: symmetric difference `%s` is not supported, skipped\n",
+					  repo_path.val, range);
+		return true;
+	}
+
+	if (git_revparse(&spec, git_repo, range) != 0 || !(spec.flags & GIT_REVSPEC_RANGE)) {
+		(void)log_err("%s: Cannot resolve the range `%s`, skipped\n", repo_path.val, range);
 		goto cleanup;
 	}
 
-	if (branch_name) {
-		if (git_branch_lookup(&branch_ref, git_repo, branch_name, GIT_BRANCH_LOCAL) != 0) {
-			(void)log_err("%s: Cannot find a *local* branch named `%s`\n", repo_path.val, branch_name);
-			git_revwalk_free(walker);
-			goto cleanup;
+	if (git_object_peel(&tip, spec.to, GIT_OBJECT_COMMIT) != 0) {
+		(void)log_err("%s: `%s` does not end with a commit, skipped\n", repo_path.val, range);
+		goto cleanup;
+	}
+
+	if (git_revwalk_push_range(walker, range) != 0) {
+		(void)log_err("%s: Cannot push the range `%s`, skipped\n", repo_path.val, range);
+		goto cleanup;
+	}
+
+	/* The tip is already in the walk: it is only registered as the range owner */
+	ok = owner_map_put(tips, git_object_id(tip), (uint32_t)refs->len)
+		 && add_ref(refs, range);
+
+cleanup:
+	git_object_free(tip);
+	git_object_free(spec.from);
+	git_object_free(spec.to);
+	return ok;
+}
+
+/* `^A` excludes every commit reachable from A, whichever tip of the walk
+ * reaches it. A revision that cannot be resolved is reported and skipped. */
+static void hide_revision(git_revwalk *walker, git_repository *git_repo,
+						  str_t repo_path, const char *revision)
+{
+	git_object *obj = NULL, *commit = NULL;
+
+	if (git_revparse_single(&obj, git_repo, revision) != 0
+		|| git_object_peel(&commit, obj, GIT_OBJECT_COMMIT) != 0) {
+		(void)log_err("%s: Cannot resolve `%s`, skipped\n", repo_path.val, revision);
+	} else if (git_revwalk_hide(walker, git_object_id(commit)) != 0) {
+		(void)log_err("%s: Cannot exclude `%s` from the walk, skipped\n",
+					  repo_path.val, revision);
+	}
+
+	git_object_free(commit);
+	git_object_free(obj);
+}
+
+static inline bool is_hidden_revision(const char *revision)
+{
+	return revision[0] == HIDE_PREFIX;
+}
+
+static inline bool is_revision_range(const char *revision)
+{
+	return strstr(revision, RANGE_SEP) != NULL;
+}
+
+/* Every entry of the branch list of a repository can be:
+ *     - the name of a local branch;
+ *     - a range `A..B`, where A and B are revisions (e.g. `v1.2..HEAD`);
+ *     - a revision prefixed with `^`, to exclude everything reachable from it.
+ */
+static bool push_revision(str_array_t *refs, owner_map_t *tips, git_revwalk *walker,
+						  git_repository *git_repo, str_t repo_path, const char *revision)
+{
+	if (is_hidden_revision(revision)) {
+		hide_revision(walker, git_repo, repo_path, revision + 1);
+		return true;
+	}
+	if (is_revision_range(revision)) {
+		return push_range(refs, tips, walker, git_repo, repo_path, revision);
+	}
+	return push_branch(refs, tips, walker, git_repo, repo_path, revision);
+}
+
+static bool push_branches(str_array_t *refs, owner_map_t *tips, git_revwalk *walker,
+						  git_repository *git_repo, str_t repo_path,
+						  const str_array_t *branches)
+{
+	for (size_t i = 0; i < branches->len; i++) {
+		const char *revision = str_array_get(branches, i).val;
+		if (!push_revision(refs, tips, walker, git_repo, repo_path, revision)) {
+			return false;
 		}
+	}
 
-		if (git_reference_peel(&branch_commit, branch_ref, GIT_OBJECT_COMMIT) != 0) {
-			(void)log_err("%s: Cannot find the HEAD of `%s`\n", repo_path.val, branch_name);
-			git_revwalk_free(walker);
-			git_reference_free(branch_ref);
-			goto cleanup;
+	if (refs->len == 0) {
+		(void)log_err("%s: no branch nor range is left to walk\n", repo_path.val);
+		return false;
+	}
+	return true;
+}
+
+static bool push_head(str_array_t *refs, owner_map_t *tips, git_revwalk *walker,
+					  git_repository *git_repo, str_t repo_path)
+{
+	git_oid head;
+
+	if (git_reference_name_to_id(&head, git_repo, "HEAD") != 0) {
+		(void)log_err("%s: Cannot resolve HEAD\n", repo_path.val);
+		return false;
+	}
+	return add_tip(refs, tips, walker, "HEAD", &head);
+}
+
+/* Commits whose parents are still to be bounded (see hide_before) */
+typedef struct {
+	git_oid *oids;
+	size_t len;
+	size_t capacity;
+} oid_stack_t;
+
+/* A commit committed before `since` is hidden from the walk, a later one is
+ * queued to bound its parents. Every commit is checked once. */
+static bool bound_commit(git_revwalk *walker, git_repository *git_repo, owner_map_t *seen,
+						 oid_stack_t *pending, const git_oid *oid, time_t since)
+{
+	git_commit *commit = NULL;
+
+	if (owner_map_get(seen, oid)) { return true; }
+	if (!owner_map_put(seen, oid, 1)) { return false; }
+	/* A missing commit (e.g. past the boundary of a shallow clone) has
+	 * nothing to hide */
+	if (git_commit_lookup(&commit, git_repo, oid) != 0) { return true; }
+	const bool before = git_commit_time(commit) < since;
+	git_commit_free(commit);
+
+	if (before) { return git_revwalk_hide(walker, oid) == 0; }
+
+	if (pending->len == pending->capacity) {
+		const size_t capacity = pending->capacity ? pending->capacity * 2 : OID_STACK_DEFAULT_SIZE;
+		if (!grow_column((void **)&pending->oids, sizeof(git_oid), capacity)) { return false; }
+		pending->capacity = capacity;
+	}
+	pending->oids[pending->len++] = *oid;
+	return true;
+}
+
+/* A tip with no state to hide (a ref without a reflog, or created in the
+ * time window) would be walked down to its root. Its history is explored
+ * first, without going past the commits made before `since`, which are
+ * hidden from the walk: the walk then stops where the window starts, even
+ * when it tracks many refs in topological order. Like the reflog boundaries,
+ * hidden commits stay hidden for every tip.
+ * The exploration is not a sorted revwalk: libgit2 prepares the whole
+ * history of a sorted walk before returning its first commit. */
+static bool hide_before(git_revwalk *walker, git_repository *git_repo, str_t repo_path,
+						const git_oid *tips, size_t n_tips, time_t since)
+{
+	owner_map_t seen;
+	oid_stack_t pending = { 0 };
+	git_commit *commit = NULL;
+	bool ok = owner_map_init(&seen, OWNER_MAP_DEFAULT_SIZE);
+
+	for (size_t i = 0; ok && i < n_tips; i++) {
+		ok = bound_commit(walker, git_repo, &seen, &pending, &tips[i], since);
+	}
+
+	while (ok && pending.len > 0) {
+		const git_oid oid = pending.oids[--pending.len];
+		if (git_commit_lookup(&commit, git_repo, &oid) != 0) { continue; }
+		for (unsigned p = 0; ok && p < git_commit_parentcount(commit); p++) {
+			ok = bound_commit(walker, git_repo, &seen, &pending,
+							  git_commit_parent_id(commit, p), since);
 		}
+		git_commit_free(commit);
+	}
+
+	if (!ok) {
+		(void)log_err("%s: Cannot bound the walk to the time window\n", repo_path.val);
 	}
+	owner_map_free(&seen);
+	tur_free(pending.oids);
+	return ok;
+}
 
-	git_revwalk_sorting(walker, GIT_SORT_TIME);
+/* Bounds the states of the first `n_entries` entries of `reflog` */
+static bool hide_reflog_before(git_revwalk *walker, git_repository *git_repo, str_t repo_path,
+							   const git_reflog *reflog, size_t n_entries, time_t since)
+{
+	git_oid *states = tur_malloc(n_entries * sizeof(git_oid));
+	size_t n_states = 0;
 
-	if (!branch_name) {
-		git_revwalk_push_head(walker);
-	} else {
-		if (git_revwalk_push(walker, git_object_id(branch_commit)) != 0) {
-			log_err("Cannot push the initial commit\n");
-			goto cleanup;
+	if (!states) {
+		(void)log_err("%s: Cannot allocate the states of a ref\n", repo_path.val);
+		return false;
+	}
+	for (size_t i = 0; i < n_entries; i++) {
+		const git_oid *new_id = git_reflog_entry_id_new(git_reflog_entry_byindex(reflog, i));
+		if (!git_oid_is_zero(new_id)) {
+			states[n_states++] = *new_id;
+		}
+	}
+
+	const bool ok = hide_before(walker, git_repo, repo_path, states, n_states, since);
+	tur_free(states);
+	return ok;
+}
+
+/* Pushes the states that a ref had after `since`, as recorded in its reflog,
+ * and hides the state it had at `since`: only the commits that reached the ref
+ * in the time window are walked. A ref without a reflog, or created in the
+ * window, is walked from its tips down to `since` (see hide_before). */
+static bool push_reflog(str_array_t *refs, owner_map_t *tips, git_revwalk *walker,
+						git_repository *git_repo, str_t repo_path,
+						const char *ref_name, time_t since)
+{
+	git_reflog *reflog = NULL;
+	const uint32_t ref = (uint32_t)refs->len;
+	size_t n_entries = 0, i;
+	bool ok = true, pushed = false;
+
+	if (git_reflog_read(&reflog, git_repo, ref_name) == 0) {
+		n_entries = git_reflog_entrycount(reflog);
+	}
+
+	if (n_entries == 0) {
+		git_oid tip;
+		git_reflog_free(reflog);
+		if (git_reference_name_to_id(&tip, git_repo, ref_name) != 0) {
+			(void)log_err("%s: Cannot resolve `%s`\n", repo_path.val, ref_name);
+			return false;
 		}
+		return add_tip(refs, tips, walker, short_ref_name(ref_name), &tip)
+			   && hide_before(walker, git_repo, repo_path, &tip, 1, since);
+	}
+
+	/* Entries are sorted from the most recent one */
+	for (i = 0; ok && i < n_entries; i++) {
+		const git_reflog_entry *entry = git_reflog_entry_byindex(reflog, i);
+		if (git_reflog_entry_committer(entry)->when.time < since) { break; }
+
+		const git_oid *new_id = git_reflog_entry_id_new(entry);
+		if (!git_oid_is_zero(new_id)) {
+			ok = push_tip(walker, tips, ref_name, new_id, ref);
+			pushed = true;
+		}
+	}
+
+	if (ok && pushed) {
+		const git_oid *boundary = i < n_entries
+								  ? git_reflog_entry_id_new(git_reflog_entry_byindex(reflog, i))
+								  : git_reflog_entry_id_old(git_reflog_entry_byindex(reflog, n_entries - 1));
+		/* A zero id means that the ref has been created in the time window */
+		if (git_oid_is_zero(boundary)) {
+			ok = hide_reflog_before(walker, git_repo, repo_path, reflog, i, since);
+		} else if (git_revwalk_hide(walker, boundary) != 0) {
+			(void)log_err("%s: Cannot hide the state of `%s` before the time window\n",
+						  repo_path.val, ref_name);
+			ok = false;
+		}
+	}
+
+	git_reflog_free(reflog);
+
+	return ok && pushed
+		   ? add_ref(refs, short_ref_name(ref_name))
+		   : ok;
+}
+
+static bool push_recent(str_array_t *refs, owner_map_t *tips, git_revwalk *walker,
+						git_repository *git_repo, str_t repo_path,
+						const str_array_t *branches, const settings_t *settings)
+{
+	if (!push_reflog(refs, tips, walker, git_repo, repo_path, "HEAD", settings->since)) {
+		return false;
+	}
+
+	if (settings->all_refs) {
+		git_reference_iterator *iter = NULL;
+		const char *ref_name = NULL;
+		bool ok = true;
+
+		if (git_reference_iterator_glob_new(&iter, git_repo, settings->refs_glob.val) != 0) {
+			(void)log_err("%s: Cannot iterate over refs matching `%s`\n",
+						  repo_path.val, settings->refs_glob.val);
+			return false;
+		}
+		while (ok && git_reference_next_name(&ref_name, iter) == 0) {
+			ok = push_reflog(refs, tips, walker, git_repo, repo_path,
+							 ref_name, settings->since);
+		}
+		git_reference_iterator_free(iter);
+		return ok;
+	}
+
+	for (size_t i = 0; branches && i < branches->len; i++) {
+		const char *revision = str_array_get(branches, i).val;
+		char ref_name[REF_NAME_MAX_LEN];
+		bool ok;
+
+		/* Ranges and exclusions have no reflog: they are applied as they are,
+		 * and their commits are still filtered by `since` */
+		if (is_hidden_revision(revision) || is_revision_range(revision)) {
+			ok = push_revision(refs, tips, walker, git_repo, repo_path, revision);
+		} else {
+			(void)snprintf(ref_name, sizeof(ref_name), HEADS_PREFIX "%s", revision);
+			ok = push_reflog(refs, tips, walker, git_repo, repo_path,
+							 ref_name, settings->since);
+		}
+		if (!ok) { return false; }
+	}
+
+	return true;
+}
+
+/* Monotonic time at which a walk started at `start` runs out of time, or 0
+ * when it has no time budget */
+static uint64_t budget_deadline(const walk_budget_t *budget, uint64_t start)
+{
+	if (!budget || budget->max_seconds == 0) { return 0; }
+	if (budget->max_seconds > (UINT64_MAX - start) / NS_PER_SECOND) { return 0; }
+	return start + (uint64_t)budget->max_seconds * NS_PER_SECOND;
+}
+
+const char *truncation_reason(truncation_t truncated)
+{
+	switch (truncated) {
+	case TRUNCATED_TIME:    return "time";
+	case TRUNCATED_COMMITS: return "commits";
+	case TRUNCATED_DIFFS:   return "diffs";
+	default:                return NULL;
+	}
+}
+
+const char *truncation_note(truncation_t truncated)
+{
+	switch (truncated) {
+	case TRUNCATED_TIME:    return " (truncated: time budget)";
+	case TRUNCATED_COMMITS: return " (truncated: commit budget)";
+	case TRUNCATED_DIFFS:   return " (truncated: diff budget)";
+	default:                return "";
+	}
+}
+
+work_history_t *get_repository_history(git_repository *git_repo, str_t repo_path,
+									   const str_array_t *branches,
+									   const settings_t *settings,
+									   const walk_budget_t *budget, profile_t *profile)
+{
+	git_revwalk *walker = NULL;
+	git_commit *raw_commit = NULL;
+	work_history_t *history = NULL;
+	str_array_t *refs = NULL;
+	owner_map_t owners = { 0 };
+	size_t n_authored = 0, n_co_authored = 0;
+	git_oid oid;
+	bool tips_pushed, walked = false;
+	/* Published every WALKED_COMMITS_BATCH visited commits */
+	size_t n_visited = 0, n_matched = 0, n_diffed = 0;
+	uint64_t timer = profile_start(profile);
+	const uint64_t open_start = trace_begin();
+	uint64_t batch_start = 0;
+	uint32_t batch_len = 0;
+	/* Budget: commits visited and diffed by this walk */
+	const uint64_t deadline = budget_deadline(budget, profile_clock());
+	const size_t max_commits = budget ? budget->max_commits : 0;
+	const size_t max_diffs = budget ? budget->max_diffs : 0;
+	size_t n_walked = 0, n_stats = 0;
+	bool check_clock = false;
+	truncation_t truncated = NOT_TRUNCATED;
+
+	if (git_revwalk_new(&walker, git_repo) != 0) {
+		(void)log_err("An error occurred while reading from `%s`\n", repo_path.val);
+		goto cleanup;
+	}
+
+	if (!owner_map_init(&owners, OWNER_MAP_DEFAULT_SIZE)) {
+		(void)log_err("get_commit_history: cannot allocate the ref owners map\n");
+		goto cleanup;
+	}
+
+	str_array_init(&refs);
+	if (!refs) {
+		(void)log_err("get_commit_history: cannot allocate the refs array\n");
+		goto cleanup;
+	}
+
+	/* Every tip is pushed into the same walker: a commit reachable from more
+	 * than one ref is visited (and diffed) only once. */
+	if (settings->since) {
+		tips_pushed = push_recent(refs, &owners, walker, git_repo, repo_path,
+								  branches, settings);
+	} else if (settings->all_refs) {
+		tips_pushed = push_ref_glob(refs, &owners, walker, git_repo, repo_path,
+									settings->refs_glob.val);
+	} else if (branches && branches->len > 0) {
+		tips_pushed = push_branches(refs, &owners, walker, git_repo, repo_path, branches);
+	} else {
+		tips_pushed = push_head(refs, &owners, walker, git_repo, repo_path);
 	}
 
-	history = malloc(sizeof(work_history_t));
-	commit_array_init(&history->commit_arr);
-	history->tot_lines_added = 0;
-	history->tot_lines_removed = 0;
+	if (!tips_pushed) { goto cleanup; }
+
+	/* With a single tip every commit belongs to it, so there is no need to
+	 * track owners nor to pay for a topological sort. */
+	const bool track_owners = refs->len > 1;
+	git_revwalk_sorting(walker, track_owners
+								? GIT_SORT_TOPOLOGICAL | GIT_SORT_TIME
+								: GIT_SORT_TIME);
+	profile_lap(profile, PROFILE_OPEN, &timer);
+	trace_end("open", open_start, NULL, 0);
+
+	history = tur_malloc(sizeof(work_history_t));
+	if (!history) {
+		(void)log_err("get_commit_history: cannot allocate the history\n");
+		goto cleanup;
+	}
+	/* From now on the history owns the refs, and history_free releases both */
+	*history = (work_history_t) { .refs = refs };
+	refs = NULL;
+	if (commit_table_init(&history->commits, 0) != OK) {
+		(void)log_err("get_commit_history: cannot allocate the commit table\n");
+		goto cleanup;
+	}
+	history->ref_commits = tur_calloc(history->refs->len, sizeof(size_t));
+	if (!history->ref_commits && history->refs->len > 0) {
+		(void)log_err("get_commit_history: cannot allocate the commit count of the refs\n");
+		goto cleanup;
+	}
 	
 	responsability_t res;
 
 	while (git_revwalk_next(&oid, walker) == 0) {
+		/* The clock is read after every batch of visited commits and after
+		 * every diff, the only steps that can take long */
+		if (deadline && check_clock && profile_clock() >= deadline) {
+			truncated = TRUNCATED_TIME;
+			break;
+		}
+		if (max_commits && n_walked == max_commits) {
+			truncated = TRUNCATED_COMMITS;
+			break;
+		}
+		check_clock = false;
+		n_walked++;
+
+		profile_lap(profile, PROFILE_REVWALK, &timer);
+		profile_count(profile, PROFILE_VISITED, 1);
+
+		if (++n_visited == WALKED_COMMITS_BATCH) {
+			progress_add(n_visited, n_matched, n_diffed);
+			n_visited = n_matched = n_diffed = 0;
+			check_clock = true;
+		}
 
 		if (git_commit_lookup(&raw_commit, git_repo, &oid) != 0) { continue; }
+
+		uint32_t owner = 0;
+		if (track_owners) {
+			owner = owner_map_get(&owners, &oid);
+			for (unsigned p = 0; p < git_commit_parentcount(raw_commit); p++) {
+				/* A parent left out of the map would be counted for the
+				 * first ref: the walk is not worth finishing */
+				if (!owner_map_put(&owners, git_commit_parent_id(raw_commit, p), owner)) {
+					(void)log_err("%s: cannot track the refs reaching `%s`\n", repo_path.val,
+								  git_oid_tostr_s(git_commit_id(raw_commit)));
+					git_commit_free(raw_commit);
+					goto cleanup;
+				}
+			}
+		}
 		
 		const char *hash = git_oid_tostr_s(git_commit_id(raw_commit));
 		const char *msg = git_commit_message(raw_commit);
@@ -258,57 +1035,116 @@ work_history_t *get_commit_history(str_t repo_path, const char *branch_name, con
 
 		if (!author || !msg) { goto clean_commit; }
 
+		/* Commits are dated by their author, as in the output. A rebased
+		 * or cherry-picked commit can be authored long before it was
+		 * committed, so it is skipped without ending the walk. */
+		if (settings->since && author->when.time < settings->since) {
+			/* With a single ref the walk is sorted by commit time alone: once
+			 * this one was committed before the window, so were the next
+			 * ones, and they were authored even earlier. With many refs the
+			 * topological order gives no such guarantee. */
+			if (!track_owners && git_commit_time(raw_commit) < settings->since) {
+				git_commit_free(raw_commit);
+				break;
+			}
+			goto clean_commit;
+		}
+
 		if (settings->no_merge && is_merge_commit(msg)) { goto clean_commit; }
 
 		if (is_author(author, settings->emails)) {
 			res = AUTHORED;
-			n_authored++;
 		} else if (is_co_author(msg, settings->emails)) {
 			res = CO_AUTHORED;
-			n_co_authored++;
 		} else {
 			goto clean_commit;
 		}
 
+		if (max_diffs && n_stats == max_diffs) {
+			truncated = TRUNCATED_DIFFS;
+			git_commit_free(raw_commit);
+			break;
+		}
+
 		commit_stats_t stats = { 0 };
+		profile_lap(profile, PROFILE_LOOKUP, &timer);
+		if (batch_len == 0) { batch_start = trace_begin(); }
 		const uint16_t return_code = get_commit_stats(&stats, raw_commit, git_repo);
 		if (return_code != OK) {
 			print_error(return_code, hash);
-			return NULL;
+			git_commit_free(raw_commit);
+			goto cleanup;
+		}
+		profile_lap(profile, PROFILE_DIFF, &timer);
+		n_stats++;
+		check_clock = true;
+		profile_count(profile, PROFILE_DIFFS, git_commit_parentcount(raw_commit) > 0);
+		n_diffed += git_commit_parentcount(raw_commit) > 0;
+		if (++batch_len == TRACE_DIFF_BATCH) {
+			trace_end("diff batch", batch_start, NULL, batch_len);
+			batch_len = 0;
 		}
 
-		commit_t commit = (commit_t) {
-			.hash = str_init(hash, GIT_HASH_LEN),
-			.date = (time_t) author->when.time,
-			.msg = str_init(msg, (uint16_t)strlen(msg)),
-			.responsability = res,
-			.stats = stats
-		};
-		commit_array_add(history->commit_arr, &commit);
-
-		history->tot_lines_added += stats.lines_added;
-		history->tot_lines_removed += stats.lines_removed;
+		if (commit_table_add(&history->commits, hash, msg,
+							 (time_t) author->when.time, res, &stats) != OK) {
+			(void)log_err("get_commit_history: cannot add commit `%s`\n", hash);
+			goto clean_commit;
+		}
+		if (res == AUTHORED) {
+			n_authored++;
+		} else {
+			n_co_authored++;
+		}
+		history->ref_commits[owner]++;
+		profile_count(profile, PROFILE_MATCHED, 1);
+		n_matched++;
 
 	clean_commit:
 		git_commit_free(raw_commit);
+		profile_lap(profile, PROFILE_LOOKUP, &timer);
 	}
+	profile_lap(profile, PROFILE_REVWALK, &timer);
+	if (batch_len > 0) { trace_end("diff batch", batch_start, NULL, batch_len); }
 
-	git_revwalk_free(walker);
-	git_object_free(branch_commit);
-	git_reference_free(branch_ref);
+	progress_add(n_visited, n_matched, n_diffed);
 
 	history->n_authored = n_authored;
 	history->n_co_authored = n_co_authored;
+	history->truncated = truncated;
+	commit_table_sum_lines(&history->commits, &history->tot_lines_added,
+						   &history->tot_lines_removed);
 
 	/* Indexes are built in walk procedure (see walk.c) */
 	history->indexes = (indexes_t) {
 		.authored = NULL,
 		.co_authored = NULL
 	};
+	walked = true;
 
 cleanup:
+	git_revwalk_free(walker);
+	owner_map_free(&owners);
+	if (refs) { str_array_free(&refs); }
+	if (!walked) { history_free(&history); }
+	return history;
+}
+
+work_history_t *get_commit_history(str_t repo_path, const str_array_t *branches,
+								   const settings_t *settings, const walk_budget_t *budget,
+								   profile_t *profile)
+{
+	git_repository *git_repo = NULL;
+	uint64_t timer = profile_start(profile);
+
+	if (git_repository_open(&git_repo, repo_path.val) != 0) {
+		(void)log_err("Failed to open repository `%s`\n", repo_path.val);
+		return NULL;
+	}
+	profile_lap(profile, PROFILE_OPEN, &timer);
+
+	work_history_t *history = get_repository_history(git_repo, repo_path, branches,
+													 settings, budget, profile);
 	git_repository_free(git_repo);
-ret:
 	return history;
 }
 
@@ -316,30 +1152,43 @@ work_history_t *history_copy(const work_history_t *src)
 {
 	if (!src) return NULL;
 
-	work_history_t *copy = malloc(sizeof(work_history_t));
+	work_history_t *copy = tur_malloc(sizeof(work_history_t));
 	if (!copy) return NULL;
 
-	copy->commit_arr = commit_array_copy(src->commit_arr);
+	if (commit_table_copy(&copy->commits, &src->commits) != OK) {
+		tur_free(copy);
+		return NULL;
+	}
 
 	copy->tot_lines_added = src->tot_lines_added;
 	copy->tot_lines_removed = src->tot_lines_removed;
 	copy->n_authored = src->n_authored;
 	copy->n_co_authored = src->n_co_authored;
+	copy->truncated = src->truncated;
+
+	copy->refs = str_array_copy(src->refs);
+	copy->ref_commits = NULL;
+	if (src->refs && src->ref_commits) {
+		copy->ref_commits = tur_malloc(src->refs->len * sizeof(size_t));
+		if (copy->ref_commits) {
+			memcpy(copy->ref_commits, src->ref_commits, src->refs->len * sizeof(size_t));
+		}
+	}
 
 	copy->indexes.authored = NULL;
 	copy->indexes.co_authored = NULL;
 	if (src->indexes.authored) {
 		size_t n = src->n_authored;
-		copy->indexes.authored = malloc(n * sizeof(size_t));
+		copy->indexes.authored = tur_malloc(n * sizeof(uint32_t));
 		if (copy->indexes.authored) {
-			memcpy(copy->indexes.authored, src->indexes.authored, n * sizeof(size_t));
+			memcpy(copy->indexes.authored, src->indexes.authored, n * sizeof(uint32_t));
 		}
 	}
 	if (src->indexes.co_authored) {
 		size_t n = src->n_co_authored;
-		copy->indexes.co_authored = malloc(n * sizeof(size_t));
+		copy->indexes.co_authored = tur_malloc(n * sizeof(uint32_t));
 		if (copy->indexes.co_authored) {
-			memcpy(copy->indexes.co_authored, src->indexes.co_authored, n * sizeof(size_t));
+			memcpy(copy->indexes.co_authored, src->indexes.co_authored, n * sizeof(uint32_t));
 		}
 	}
 
@@ -350,46 +1199,19 @@ void history_free(work_history_t **history)
 {
 	if (!history || !*history) return;
 	work_history_t *h = *history;
-	if (h->commit_arr) {
-		commit_array_free(&h->commit_arr);
-		h->commit_arr = NULL;
+	commit_table_free(&h->commits);
+	if (h->refs) {
+		str_array_free(&h->refs);
 	}
+	tur_free(h->ref_commits);
 	if (h->indexes.authored) {
-		free(h->indexes.authored);
+		tur_free(h->indexes.authored);
 		h->indexes.authored = NULL;
 	}
 	if (h->indexes.co_authored) {
-		free(h->indexes.co_authored);
+		tur_free(h->indexes.co_authored);
 		h->indexes.co_authored = NULL;
 	}
-	free(h);
+	tur_free(h);
 	*history = NULL;
 }
-
-commit_t *get_commit_with_id(const commit_arr_t* commit_arr, str_t id)
-{
-	commit_t *current;
-	for (size_t i = 0; i < commit_arr->len; i++) {
-		current = commit_array_get(commit_arr, i);
-		if (str_equals(current->hash, id)) { return current; }
-	}
-
-	return NULL;
-}
-
-commit_t *commit_copy(const commit_t *src)
-{
-	commit_t *new = malloc(sizeof(commit_t));
-	new->hash = str_copy(src->hash);
-	new->responsability = src->responsability;
-	new->date = src->date;
-	new->msg = str_copy(src->msg);
-	new->stats = src->stats;
-	return new;
-}
-
-void commit_free(commit_t *commit)
-{
-	str_free(commit->hash);
-	str_free(commit->msg);
-}
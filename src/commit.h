@@ -23,6 +23,7 @@
 #define __COMMIT_H__
 
 #include "array.h"
+#include "profile.h"
 #include "settings.h"
 #include "str.h"
 
@@ -31,7 +32,8 @@
 
 #define GIT_HASH_LEN 40
 
-typedef array_t  commit_arr_t;
+/* As declared by libgit2, so that this header does not need git2.h */
+typedef struct git_repository git_repository;
 
 typedef enum {
 	AUTHORED,
@@ -52,38 +54,97 @@ typedef struct {
 	commit_stats_t stats;
 } commit_t;
 
-/* Commits in the indexes are just pointers to the commits in commit_arr.
- * !!! DO NOT FREE THEM !!!
- */
+/* Columnar storage of the commits of a history: row `i` of every column
+ * describes the same commit. Sort, filter and aggregate passes only read
+ * the small hot columns (dates, responsabilities, stats) and never stride
+ * over hashes and messages. Messages are stored NUL-terminated in a single
+ * heap and addressed by offset. */
+typedef struct {
+	size_t len;
+	size_t capacity;
+	/* Hot columns */
+	time_t *dates;
+	uint8_t *responsabilities;
+	uint32_t *files_changed;
+	uint32_t *lines_added;
+	uint32_t *lines_removed;
+	/* Cold columns */
+	char *hashes;
+	size_t *msg_offsets;
+	char *msg_heap;
+	size_t msg_heap_len;
+	size_t msg_heap_capacity;
+} commit_table_t;
+
+/* Budget that stopped the walk of a repository before its end */
+typedef enum {
+	NOT_TRUNCATED = 0,
+	TRUNCATED_TIME,
+	TRUNCATED_COMMITS,
+	TRUNCATED_DIFFS
+} truncation_t;
+
+/* Indexes are row ids in the commit table of the same history */
 typedef struct {
-	commit_t **authored;
-	commit_t **co_authored;
+	uint32_t *authored;
+	uint32_t *co_authored;
 } indexes_t;
 
 typedef struct {
-	commit_arr_t *commit_arr;
+	commit_table_t commits;
 	size_t n_authored;
 	size_t n_co_authored;
 	indexes_t indexes;
 	size_t tot_lines_added;
 	size_t tot_lines_removed;
+	/* Refs pushed into the walk. Each commit is counted once in ref_commits,
+	 * for the ref through which the walk reached it first. */
+	str_array_t *refs;
+	size_t *ref_commits;
+	/* The commits are the newest ones found before the budget ran out */
+	truncation_t truncated;
 } work_history_t;
 
-work_history_t *get_commit_history(str_t repo_path, const char *branch_name, const settings_t *settings);
-commit_t *get_commit_with_id(const commit_arr_t* commit_arr, str_t id);
-commit_t *commit_copy(const commit_t *source);
+/* `profile` may be NULL. In `budget`, zero fields are unlimited: the walk
+ * stops as soon as one of the others is exhausted. */
+work_history_t *get_commit_history(str_t repo_path, const str_array_t *branches,
+								   const settings_t *settings, const walk_budget_t *budget,
+								   profile_t *profile);
+/* Same walk on a repository that is already open, e.g. kept by --serve
+ * across queries. The repository is not freed. */
+work_history_t *get_repository_history(git_repository *git_repo, str_t repo_path,
+									   const str_array_t *branches,
+									   const settings_t *settings,
+									   const walk_budget_t *budget, profile_t *profile);
+/* "time", "commits" or "diffs", or NULL for a complete walk */
+const char *truncation_reason(truncation_t truncated);
+/* " (truncated: time budget)", or an empty string for a complete walk */
+const char *truncation_note(truncation_t truncated);
 work_history_t *history_copy(const work_history_t *src);
-void commit_free(commit_t *commit);
 void history_free(work_history_t **history);
 
 /*
- * Commit arrays
+ * Commit tables
  */
-void commit_array_init(commit_arr_t **arr);
-commit_t *commit_array_get(const commit_arr_t *src, size_t i);
-return_code_t commit_array_add(commit_arr_t *src, commit_t *commit);
-commit_arr_t *commit_array_copy(const commit_arr_t *src);
-bool commit_array_contains(const commit_arr_t *src, commit_t *commit);
-void commit_array_free(commit_arr_t **arr);
+return_code_t commit_table_init(commit_table_t *table, size_t capacity);
+return_code_t commit_table_add(commit_table_t *table, const char *hash,
+							   const char *msg, time_t date,
+							   responsability_t responsability,
+							   const commit_stats_t *stats);
+return_code_t commit_table_copy(commit_table_t *dst, const commit_table_t *src);
+bool commit_table_find(const commit_table_t *table, str_t hash, uint32_t *row);
+size_t commit_table_select(const commit_table_t *table, responsability_t responsability,
+						   uint32_t *rows);
+void commit_table_sum_lines(const commit_table_t *table, size_t *added, size_t *removed);
+commit_t commit_table_row(const commit_table_t *table, uint32_t row);
+void commit_table_free(commit_table_t *table);
+
+static inline str_t commit_table_hash(const commit_table_t *table, uint32_t row)
+{
+	return (str_t) {
+		.val = table->hashes + (size_t)row * (GIT_HASH_LEN + 1),
+		.len = GIT_HASH_LEN
+	};
+}
 
 #endif /* __COMMIT_H__ */
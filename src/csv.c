@@ -0,0 +1,124 @@
+/* csv.c
+ * -----------------------------------------------------------------------
+ * Copyright (C) 2025  Matteo Nicoli
+ *
+ * This file is part of TUR.
+ *
+ * TUR is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "commit.h"
+#include "repo.h"
+#include "settings.h"
+#include "sink.h"
+#include "timeline.h"
+
+/* The same renderer writes both CSV (RFC 4180) and TSV, depending on the
+ * output mode. Like JSON, every row carries all the fields. Strings are
+ * quoted or escaped straight from the commit table into the sink. */
+
+#define CSV_COLUMNS(sep) "repo_id" sep "repo" sep "hash" sep "date" sep       \
+						 "responsibility" sep "files_changed" sep             \
+						 "lines_added" sep "lines_removed" sep "message\n"
+
+static void put_field(sink_t *out, str_t str, bool tsv)
+{
+	if (tsv) {
+		sink_put_tsv_str(out, str);
+	} else {
+		sink_put_csv_str(out, str);
+	}
+}
+
+static void generate_csv_row(sink_t *out, const repository_t *repo, const commit_t *commit,
+							 responsability_t responsability, bool tsv)
+{
+	const char sep = tsv ? '\t' : ',';
+
+	sink_put_uint(out, repo->id);
+	sink_putc(out, sep);
+	put_field(out, repo->name, tsv);
+	sink_putc(out, sep);
+	sink_put_str(out, commit->hash);
+	sink_putc(out, sep);
+	sink_put_iso_date(out, commit->date);
+	sink_putc(out, sep);
+	sink_puts(out, responsability == AUTHORED ? "authored" : "co-authored");
+	sink_putc(out, sep);
+	sink_put_uint(out, commit->stats.files_changed);
+	sink_putc(out, sep);
+	sink_put_uint(out, commit->stats.lines_added);
+	sink_putc(out, sep);
+	sink_put_uint(out, commit->stats.lines_removed);
+	sink_putc(out, sep);
+	put_field(out, commit->msg, tsv);
+	/* RFC 4180 wants CRLF, but every consumer we care about takes LF */
+	sink_putc(out, '\n');
+}
+
+void generate_csv_header(sink_t *out, const settings_t *settings)
+{
+	sink_puts(out, settings->output_mode == TSV ? CSV_COLUMNS("\t") : CSV_COLUMNS(","));
+}
+
+void generate_csv_section(sink_t *out, const repository_t *repo, const settings_t *settings)
+{
+	const work_history_t *history = repo->history;
+	const bool tsv = settings->output_mode == TSV;
+
+	for (size_t n_c = 0; n_c < history->n_authored; n_c++) {
+		const commit_t commit = commit_table_row(&history->commits, history->indexes.authored[n_c]);
+		generate_csv_row(out, repo, &commit, AUTHORED, tsv);
+	}
+
+	for (size_t n_c = 0; n_c < history->n_co_authored; n_c++) {
+		const commit_t commit = commit_table_row(&history->commits, history->indexes.co_authored[n_c]);
+		generate_csv_row(out, repo, &commit, CO_AUTHORED, tsv);
+	}
+}
+
+static void generate_csv_list(sink_t *out, const repository_array_t *repos, const settings_t *settings)
+{
+	timeline_t timeline;
+	timeline_item_t item;
+	const bool tsv = settings->output_mode == TSV;
+
+	if (timeline_init(&timeline, repos, settings) != OK) { return; }
+
+	while (timeline_next(&timeline, &item)) {
+		generate_csv_row(out, item.repo, &item.commit, item.responsability, tsv);
+	}
+
+	timeline_free(&timeline);
+}
+
+void generate_csv_file(sink_t *out, const repository_array_t *repos,
+					   const settings_t *settings, const sink_t *sections)
+{
+	generate_csv_header(out, settings);
+
+	if (!settings->grouped) {
+		generate_csv_list(out, repos, settings);
+		return;
+	}
+
+	for (size_t i = 0; i < repos->len; i++) {
+		if (sections) {
+			sink_write(out, sections[i].buf, sections[i].len);
+			continue;
+		}
+		generate_csv_section(out, repo_array_get(repos, i), settings);
+	}
+}
@@ -22,164 +22,185 @@
 #include "commit.h"
 #include "repo.h"
 #include "settings.h"
+#include "sink.h"
+#include "timeline.h"
 #include "utils.h"
 
-#include <stdio.h>
-
 #define COMMITS_DIV_STYLE "'display: flex; flex-direction: column; " \
 						  "row-gap: 10px; padding-left: 2em;'"
 #define COMMIT_ITEM_BORDER_STYLE "'border-left: black; "      \
 								 "border-left-style: solid; " \
 								 "border-left-width: 1px; "   \
 								 "padding-left: 5px;'"
-#define H3 "<h3 style='margin: 5px 0px;'><i>%s</i></h3>\n"
-#define H2 "<h2 style='margin-bottom: 0px;'>%s</h2>\n"
+#define H3_OPEN "<h3 style='margin: 5px 0px;'><i>"
+#define H3_CLOSE "</i></h3>\n"
+#define H2_OPEN "<h2 style='margin-bottom: 0px;'>"
+#define H2_CLOSE "</h2>\n"
+
+static void print_commit_diffs(sink_t *out, const commit_t * commit)
+{
+	sink_put_uint(out, commit->stats.files_changed);
+	sink_puts(out, commit->stats.files_changed > 1 ? " files changed " : " file changed ");
+	sink_puts(out, "<span style='color:green;'>+");
+	sink_put_uint(out, commit->stats.lines_added);
+	sink_puts(out, "</span> |  <span style='color:red;'>-");
+	sink_put_uint(out, commit->stats.lines_removed);
+	sink_puts(out, "</span>\n");
+}
+
+static void print_commit_message(sink_t *out, const commit_t * commit)
+{
+	sink_puts(out, "<span>");
+	sink_put_str(out, first_line_view(commit->msg));
+	sink_puts(out, "</span>\n");
+}
 
-static void print_commit_diffs(FILE *out, const commit_t * commit)
+static void print_commit_link(sink_t *out, const repository_t *repo, const commit_t *commit)
 {
-	fprintf(out, "%zu file%c changed "
-				 "<span style='color:green;'>+%zu</span> "
-				 "|  <span style='color:red;'>-%zu</span>\n",
-			commit->stats.files_changed,
-			(commit->stats.files_changed > 1 ? 's': 0),
-			commit->stats.lines_added,
-			commit->stats.lines_removed);
+	sink_puts(out, "<a href='");
+	sink_put_str(out, repo->url);
+	sink_put_str(out, repo->format.commit_path);
+	sink_put_str(out, commit->hash);
+	sink_puts(out, "' target='_blank'>");
+	sink_put_str(out, commit->hash);
+	sink_puts(out, "</a>");
 }
 
-static void print_commit_message(FILE *out, const commit_t * commit)
+static void generate_html_commit(sink_t *out, const repository_t *repo,
+								 const commit_t *commit, const settings_t *settings)
 {
-	fprintf(out, "<span>%s</span>\n", get_first_line(commit->msg).val);
+	sink_puts(out, "<div>\n");
+	if (settings->print_msg) {
+		print_commit_message(out, commit);
+	}
+	sink_puts(out, settings->print_msg
+				   ? "<div style='font-size: 11pt;'>("
+				   : "<div style='font-size: unset;'>(");
+	sink_put_date(out, commit->date, settings->date_only);
+	sink_puts(out, ") ");
+	print_commit_link(out, repo, commit);
+	sink_putc(out, ' ');
+	if (settings->show_diffs) {
+		print_commit_diffs(out, commit);
+	}
+	sink_puts(out, "</div>");
+	sink_puts(out, "</div>\n");
 }
 
-static void generate_html_file_grouped(FILE *out,
+static void generate_html_file_grouped(sink_t *out,
 									   const repository_t *repo,
 									   const indexes_t *indexes,
 									   const settings_t *settings)
 {
-	commit_t **const authored = indexes->authored;
-	commit_t **const co_authored = indexes->co_authored;
+	const uint32_t *authored = indexes->authored;
+	const uint32_t *co_authored = indexes->co_authored;
 
 	if (repo->history->n_authored == 0 && repo->history->n_co_authored == 0) { return; }
 
-	fprintf(out, H2, repo->name.val);
+	sink_puts(out, H2_OPEN);
+	sink_put_str(out, repo->name);
+	sink_puts(out, truncation_note(repo->history->truncated));
+	sink_puts(out, H2_CLOSE);
 	
 	if (repo->history->n_authored == 0) { goto co_authored; }
 
-	fprintf(out, H3 "\n\n<div style=" COMMITS_DIV_STYLE ">\n",
-			"Authored");
+	sink_puts(out, H3_OPEN "Authored" H3_CLOSE "\n\n<div style=" COMMITS_DIV_STYLE ">\n");
 	
 	for (size_t n_c = 0; n_c < repo->history->n_authored; n_c++) {
-		fprintf(out, "<div>\n");
-		if (settings->print_msg) {
-			print_commit_message(out, authored[n_c]);
-		}
-		fprintf(out, "<div style='font-size: %s;'>(%s) <a href='%s' target='_blank'>%s</a> ",
-				settings->print_msg ? "11pt" : "unset",
-				format_date(authored[n_c]->date, settings->date_only).val,
-				repo->format.commit_url(repo->url, authored[n_c]->hash).val,
-				authored[n_c]->hash.val);
-		if (settings->show_diffs) {
-			print_commit_diffs(out, authored[n_c]);
-		}
-		fprintf(out, "</div>");
-		fprintf(out, "</div>\n");
+		const commit_t commit = commit_table_row(&repo->history->commits, authored[n_c]);
+		generate_html_commit(out, repo, &commit, settings);
 	}
 
-	fprintf(out, "</div>\n");
+	sink_puts(out, "</div>\n");
 
 co_authored:
 	
 	if (repo->history->n_co_authored == 0) { return; }
 
-	fprintf(out, H3 "\n\n<div style=" COMMITS_DIV_STYLE ">\n",
-			"Co-authored");
+	sink_puts(out, H3_OPEN "Co-authored" H3_CLOSE "\n\n<div style=" COMMITS_DIV_STYLE ">\n");
 	
 	for (size_t n_c = 0; n_c < repo->history->n_co_authored; n_c++) {
-		fprintf(out, "<div>\n");
-		if (settings->print_msg) {
-			print_commit_message(out, co_authored[n_c]);
-		}
-		fprintf(out, "<div style='font-size: %s;'>(%s) <a href='%s' target='_blank'>%s</a> ",
-				settings->print_msg ? "11pt" : "unset",
-				format_date(co_authored[n_c]->date, settings->date_only).val,
-				repo->format.commit_url(repo->url, co_authored[n_c]->hash).val,
-				co_authored[n_c]->hash.val);
-		if (settings->show_diffs) {
-			print_commit_diffs(out, co_authored[n_c]);
-		}
-		fprintf(out, "</div>");
-		fprintf(out, "</div>\n");
+		const commit_t commit = commit_table_row(&repo->history->commits, co_authored[n_c]);
+		generate_html_commit(out, repo, &commit, settings);
 	}
 
-	fprintf(out, "</div>\n");
+	sink_puts(out, "</div>\n");
 }
 
-static void generate_html_file_list(FILE *out,
-									const repository_t *repo,
-									const indexes_t *indexes,
-									const settings_t *settings)
+static void generate_html_file_list_item(sink_t *out,
+										 const timeline_item_t *item,
+										 const settings_t *settings)
 {
-	commit_t **const authored = indexes->authored;
-	commit_t **const co_authored = indexes->co_authored;
+	const repository_t *repo = item->repo;
+	const commit_t *commit = &item->commit;
 
-	for (size_t n_c = 0; n_c < repo->history->n_authored; n_c++) {
-		fprintf(out, "<div style=" COMMIT_ITEM_BORDER_STYLE ">\n");
-		if (settings->print_msg) {
-			print_commit_message(out, authored[n_c]);
-		}
-		fprintf(out, "<div>%s: <a href='%s' target='_blank'>%s</a> (%s) [A] ",
-				repo->name.val,
-				repo->format.commit_url(repo->url, authored[n_c]->hash).val,
-				authored[n_c]->hash.val,
-				format_date(authored[n_c]->date, settings->date_only).val);
-		if (settings->show_diffs) {
-			print_commit_diffs(out, authored[n_c]);
-		}
-		fprintf(out, "</div>");
-		fprintf(out, "</div>\n");
+	sink_puts(out, "<div style=" COMMIT_ITEM_BORDER_STYLE ">\n");
+	if (settings->print_msg) {
+		print_commit_message(out, commit);
 	}
+	sink_puts(out, "<div>");
+	sink_put_str(out, repo->name);
+	sink_puts(out, ": ");
+	print_commit_link(out, repo, commit);
+	sink_puts(out, " (");
+	sink_put_date(out, commit->date, settings->date_only);
+	sink_puts(out, item->responsability == AUTHORED ? ") [A] " : ") [C] ");
+	if (settings->show_diffs) {
+		print_commit_diffs(out, commit);
+	}
+	sink_puts(out, "</div>");
+	sink_puts(out, "</div>\n");
+}
 
-	for (size_t n_c = 0; n_c < repo->history->n_co_authored; n_c++) {
-		fprintf(out, "<div style=" COMMIT_ITEM_BORDER_STYLE ">\n");
-		if (settings->print_msg) {
-			print_commit_message(out, co_authored[n_c]);
-		}
-		fprintf(out, "<div>%s: <a href='%s' target='_blank'>%s</a> (%s) [C] ",
-				repo->name.val,
-				repo->format.commit_url(repo->url, co_authored[n_c]->hash).val,
-				co_authored[n_c]->hash.val,
-				format_date(co_authored[n_c]->date, settings->date_only).val);
-		if (settings->show_diffs) {
-			print_commit_diffs(out, co_authored[n_c]);
-		}
-		fprintf(out, "</div>");
-		fprintf(out, "</div>\n");
+static void generate_html_file_list(sink_t *out,
+									const repository_array_t *repos,
+									const settings_t *settings)
+{
+	timeline_t timeline;
+	timeline_item_t item;
+
+	if (timeline_init(&timeline, repos, settings) != OK) { return; }
+
+	sink_puts(out, "<div style=" COMMITS_DIV_STYLE ">\n");
+	while (timeline_next(&timeline, &item)) {
+		generate_html_file_list_item(out, &item, settings);
 	}
+	sink_puts(out, "</div>\n");
+
+	timeline_free(&timeline);
+}
+
+void generate_html_section(sink_t *out, const repository_t *repo, const settings_t *settings)
+{
+	generate_html_file_grouped(out, repo, &repo->history->indexes, settings);
 }
 
-void generate_html_file(FILE *out, const repository_array_t *repos, const settings_t *settings)
+void generate_html_header(sink_t *out, const settings_t *settings)
 {
-	fprintf(out, "<!-- This file is automatically generated by TUR -->\n\n");
+	sink_puts(out, "<!-- This file is automatically generated by TUR -->\n\n");
 
 	if (str_not_empty(settings->title)) {
-		fprintf(out, "<center><h1>%s</h1></center>\n", settings->title.val);
+		sink_puts(out, "<center><h1>");
+		sink_put_str(out, settings->title);
+		sink_puts(out, "</h1></center>\n");
 	}
+}
+
+void generate_html_file(sink_t *out, const repository_array_t *repos,
+						const settings_t *settings, const sink_t *sections)
+{
+	generate_html_header(out, settings);
 
 	if (!settings->grouped) {
-		fprintf(out, "<div style=" COMMITS_DIV_STYLE ">\n");
+		generate_html_file_list(out, repos, settings);
+		return;
 	}
 
 	for (size_t i = 0; i < repos->len; i++) {
-		repository_t *repo = repo_array_get(repos, i);
-
-		if (settings->grouped) {
-			generate_html_file_grouped(out, repo, &repo->history->indexes, settings);
-		} else {
-			generate_html_file_list(out, repo, &repo->history->indexes, settings);
+		if (sections) {
+			sink_write(out, sections[i].buf, sections[i].len);
+			continue;
 		}
-	}
-
-	if (!settings->grouped) {
-		fprintf(out, "</div>\n");
+		generate_html_section(out, repo_array_get(repos, i), settings);
 	}
 }
@@ -0,0 +1,211 @@
+/* json.c
+ * -----------------------------------------------------------------------
+ * Copyright (C) 2025  Matteo Nicoli
+ *
+ * This file is part of TUR.
+ *
+ * TUR is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "commit.h"
+#include "repo.h"
+#include "settings.h"
+#include "sink.h"
+#include "timeline.h"
+
+/* Both formats always carry every field: --message, --diffs and --date-only
+ * only affect the human readable outputs. */
+
+static void generate_json_commit(sink_t *out, const repository_t *repo,
+								 const commit_t *commit, responsability_t responsability)
+{
+	sink_puts(out, "{\"repo_id\":");
+	sink_put_uint(out, repo->id);
+	sink_puts(out, ",\"repo\":");
+	sink_put_json_str(out, repo->name);
+	sink_puts(out, ",\"hash\":\"");
+	sink_put_str(out, commit->hash);
+	sink_puts(out, "\",\"date\":");
+	sink_put_int(out, commit->date);
+	sink_puts(out, responsability == AUTHORED
+				   ? ",\"responsibility\":\"authored\""
+				   : ",\"responsibility\":\"co-authored\"");
+	sink_puts(out, ",\"files_changed\":");
+	sink_put_uint(out, commit->stats.files_changed);
+	sink_puts(out, ",\"lines_added\":");
+	sink_put_uint(out, commit->stats.lines_added);
+	sink_puts(out, ",\"lines_removed\":");
+	sink_put_uint(out, commit->stats.lines_removed);
+	sink_puts(out, ",\"message\":");
+	sink_put_json_str(out, commit->msg);
+	sink_putc(out, '}');
+}
+
+/* Writes the authored and then the co-authored commits of `repo`, each one
+ * preceded by `separator` but the first */
+static void generate_json_repo_commits(sink_t *out, const repository_t *repo,
+									   const char *separator)
+{
+	const work_history_t *history = repo->history;
+	bool first = true;
+
+	for (size_t n_c = 0; n_c < history->n_authored; n_c++, first = false) {
+		const commit_t commit = commit_table_row(&history->commits, history->indexes.authored[n_c]);
+		if (!first) { sink_puts(out, separator); }
+		generate_json_commit(out, repo, &commit, AUTHORED);
+	}
+
+	for (size_t n_c = 0; n_c < history->n_co_authored; n_c++, first = false) {
+		const commit_t commit = commit_table_row(&history->commits, history->indexes.co_authored[n_c]);
+		if (!first) { sink_puts(out, separator); }
+		generate_json_commit(out, repo, &commit, CO_AUTHORED);
+	}
+}
+
+void generate_json_header(sink_t *out, const settings_t *settings)
+{
+	sink_putc(out, '{');
+	if (str_not_empty(settings->title)) {
+		sink_puts(out, "\"title\":");
+		sink_put_json_str(out, settings->title);
+		sink_putc(out, ',');
+	}
+	sink_puts(out, settings->grouped ? "\"repositories\":[\n" : "\"commits\":[\n");
+}
+
+void generate_json_footer(sink_t *out, const settings_t *settings)
+{
+	(void)settings;
+	sink_puts(out, "\n]}\n");
+}
+
+/* Without -g, the repositories whose walk ran out of budget are listed
+ * after the commits: the field is only there when there is one */
+static void generate_json_truncated(sink_t *out, const repository_array_t *repos)
+{
+	bool first = true;
+
+	for (size_t i = 0; i < repos->len; i++) {
+		const repository_t *repo = repo_array_get(repos, i);
+		if (!repo->history->truncated) { continue; }
+
+		sink_puts(out, first ? ",\"truncated\":[\n" : ",\n");
+		sink_puts(out, "{\"id\":");
+		sink_put_uint(out, repo->id);
+		sink_puts(out, ",\"name\":");
+		sink_put_json_str(out, repo->name);
+		sink_puts(out, ",\"reason\":\"");
+		sink_puts(out, truncation_reason(repo->history->truncated));
+		sink_puts(out, "\"}");
+		first = false;
+	}
+	if (!first) { sink_puts(out, "\n]"); }
+}
+
+/* Repository ids are their positions in the .rlist, so every section but
+ * the first one opens with the separator, even when rendered on its own.
+ * Repositories without commits are kept, with an empty list. */
+void generate_json_section(sink_t *out, const repository_t *repo, const settings_t *settings)
+{
+	(void)settings;
+
+	if (repo->id > 0) { sink_puts(out, ",\n"); }
+
+	sink_puts(out, "{\"id\":");
+	sink_put_uint(out, repo->id);
+	sink_puts(out, ",\"name\":");
+	sink_put_json_str(out, repo->name);
+	sink_puts(out, ",\"url\":");
+	sink_put_json_str(out, repo->url);
+	if (repo->history->truncated) {
+		sink_puts(out, ",\"truncated\":\"");
+		sink_puts(out, truncation_reason(repo->history->truncated));
+		sink_putc(out, '"');
+	}
+	sink_puts(out, ",\"commits\":[\n");
+	generate_json_repo_commits(out, repo, ",\n");
+	sink_puts(out, "\n]}");
+}
+
+void generate_ndjson_section(sink_t *out, const repository_t *repo, const settings_t *settings)
+{
+	(void)settings;
+
+	if (repo->history->n_authored == 0 && repo->history->n_co_authored == 0) { return; }
+
+	generate_json_repo_commits(out, repo, "\n");
+	sink_putc(out, '\n');
+}
+
+/* JSON separates the commits with commas, NDJSON ends each one with a
+ * newline */
+static void generate_json_list(sink_t *out, const repository_array_t *repos,
+							   const settings_t *settings, bool ndjson)
+{
+	timeline_t timeline;
+	timeline_item_t item;
+	bool first = true;
+
+	if (timeline_init(&timeline, repos, settings) != OK) { return; }
+
+	while (timeline_next(&timeline, &item)) {
+		if (!first && !ndjson) { sink_puts(out, ",\n"); }
+		generate_json_commit(out, item.repo, &item.commit, item.responsability);
+		if (ndjson) { sink_putc(out, '\n'); }
+		first = false;
+	}
+
+	timeline_free(&timeline);
+}
+
+void generate_json_file(sink_t *out, const repository_array_t *repos,
+						const settings_t *settings, const sink_t *sections)
+{
+	generate_json_header(out, settings);
+
+	if (!settings->grouped) {
+		generate_json_list(out, repos, settings, false);
+		sink_puts(out, "\n]");
+		generate_json_truncated(out, repos);
+		sink_puts(out, "}\n");
+		return;
+	}
+
+	for (size_t i = 0; i < repos->len; i++) {
+		if (sections) {
+			sink_write(out, sections[i].buf, sections[i].len);
+			continue;
+		}
+		generate_json_section(out, repo_array_get(repos, i), settings);
+	}
+	generate_json_footer(out, settings);
+}
+
+void generate_ndjson_file(sink_t *out, const repository_array_t *repos,
+						  const settings_t *settings, const sink_t *sections)
+{
+	if (!settings->grouped) {
+		generate_json_list(out, repos, settings, true);
+		return;
+	}
+
+	for (size_t i = 0; i < repos->len; i++) {
+		if (sections) {
+			sink_write(out, sections[i].buf, sections[i].len);
+			continue;
+		}
+		generate_ndjson_section(out, repo_array_get(repos, i), settings);
+	}
+}
@@ -22,162 +22,201 @@
 #include "commit.h"
 #include "repo.h"
 #include "settings.h"
+#include "sink.h"
+#include "timeline.h"
 #include "utils.h"
 
-#include <stdio.h>
-
 #define LIST_ITEMS_SPACING "\\setlength\\itemsep{1em}"
 
-static void print_commit_diffs(FILE *out, const commit_t * commit)
+static void print_commit_diffs(sink_t *out, const commit_t * commit)
+{
+	sink_puts(out, "\\\\");
+	sink_put_uint(out, commit->stats.files_changed);
+	sink_puts(out, commit->stats.files_changed > 1 ? " files changed " : " file  changed ");
+	sink_puts(out, "\\textcolor{teal}{+");
+	sink_put_uint(out, commit->stats.lines_added);
+	sink_puts(out, "} $~\\vert{}~$ \\textcolor{red}{-");
+	sink_put_uint(out, commit->stats.lines_removed);
+	sink_puts(out, "}\n");
+}
+
+static void print_commit_message(sink_t *out, const commit_t * commit, render_buf_t *buf)
+{
+	sink_put_str(out, render_escaped(buf, first_line_view(commit->msg)));
+	sink_puts(out, "\\\\ \n");
+}
+
+static void print_commit_label(sink_t *out, const repository_t *repo, const commit_t *commit)
+{
+	sink_puts(out, "\t\\item \\label{");
+	sink_put_str(out, repo->name);
+	sink_puts(out, ":item:");
+	sink_put_str(out, commit->hash);
+	sink_puts(out, "} ");
+}
+
+static void print_commit_link(sink_t *out, const repository_t *repo, const commit_t *commit)
+{
+	sink_puts(out, "\\href{");
+	sink_put_str(out, repo->url);
+	sink_put_str(out, repo->format.commit_path);
+	sink_put_str(out, commit->hash);
+	sink_puts(out, "}{");
+	sink_put_str(out, commit->hash);
+	sink_putc(out, '}');
+}
+
+static void generate_latex_commit(sink_t *out, const repository_t *repo,
+								  const commit_t *commit, const settings_t *settings,
+								  render_buf_t *buf)
 {
-	fprintf(out, "\\\\%zu file%c changed "
-				 "\\textcolor{teal}{+%zu} "
-				 "$~\\vert{}~$ \\textcolor{red}{-%zu}\n",
-			commit->stats.files_changed,
-			(commit->stats.files_changed > 1 ? 's': ASCII_SPACE),
-			commit->stats.lines_added,
-			commit->stats.lines_removed);
+	print_commit_label(out, repo, commit);
+	if (settings->print_msg) {
+		print_commit_message(out, commit, buf);
+	}
+	print_commit_link(out, repo, commit);
+	sink_puts(out, " (");
+	sink_put_date(out, commit->date, settings->date_only);
+	sink_puts(out, ") ");
+	if (settings->show_diffs) {
+		print_commit_diffs(out, commit);
+	}
 }
 
-static void print_commit_message(FILE *out, const commit_t * commit)
+static void print_paragraph(sink_t *out, const repository_t *repo,
+							const char *title, const char *label)
 {
-	fprintf(out, "%s\\\\ \n", escape_special_chars(get_first_line(commit->msg)).val);
+	sink_puts(out, "\n\\turtexpar{");
+	sink_puts(out, title);
+	sink_puts(out, "}\n\\label{par:");
+	sink_put_str(out, repo->name);
+	sink_puts(out, label);
+	sink_puts(out, "}\n\n\\begin{enumerate}\n" LIST_ITEMS_SPACING "\n");
 }
 
-static void generate_latex_file_grouped(FILE *out,
+static void generate_latex_file_grouped(sink_t *out,
 										const repository_t *repo,
 										const indexes_t *indexes,
-										const settings_t *settings)
+										const settings_t *settings,
+										render_buf_t *buf)
 {
-	commit_t **const authored = indexes->authored;
-	commit_t **const co_authored = indexes->co_authored;
+	const uint32_t *authored = indexes->authored;
+	const uint32_t *co_authored = indexes->co_authored;
 
 	if (repo->history->n_authored == 0 && repo->history->n_co_authored == 0) { return; }
 
-	fprintf(out, "\n\n\\subsection{%s}\n\\label{subsec:%s}\n", repo->name.val, repo->name.val);
+	sink_puts(out, "\n\n\\subsection{");
+	sink_put_str(out, repo->name);
+	sink_puts(out, truncation_note(repo->history->truncated));
+	sink_puts(out, "}\n\\label{subsec:");
+	sink_put_str(out, repo->name);
+	sink_puts(out, "}\n");
 		
 	if (repo->history->n_authored == 0) { goto co_authored; }
 
-	fprintf(out, "\n\\turtexpar{Authored}\n\\label{par:%s-authored}\n\n"
-				 "\\begin{enumerate}\n" LIST_ITEMS_SPACING "\n",
-				 repo->name.val);
+	print_paragraph(out, repo, "Authored", "-authored");
 	
 	for (size_t n_c = 0; n_c < repo->history->n_authored; n_c++) {
-		fprintf(out, "\t\\item \\label{%s:item:%s} ",
-				repo->name.val,
-				authored[n_c]->hash.val);
-		if (settings->print_msg) {
-			print_commit_message(out, authored[n_c]);
-		}
-		fprintf(out, "\\href{%s}{%s} (%s) ",
-				repo->format.commit_url(repo->url, authored[n_c]->hash).val,
-				authored[n_c]->hash.val,
-				format_date(authored[n_c]->date, settings->date_only).val);
-		if (settings->show_diffs) {
-			print_commit_diffs(out, authored[n_c]);
-		}
+		const commit_t commit = commit_table_row(&repo->history->commits, authored[n_c]);
+		generate_latex_commit(out, repo, &commit, settings, buf);
 	}
 
-	fprintf(out, "\\end{enumerate}\n");
+	sink_puts(out, "\\end{enumerate}\n");
 
 co_authored:
 	
 	if (repo->history->n_co_authored == 0) { return; }
 
-	fprintf(out, "\n\\turtexpar{Co-authored}\n\\label{par:%s-co-authored}\n\n"
-				 "\\begin{enumerate}\n" LIST_ITEMS_SPACING "\n",
-				 repo->name.val);
+	print_paragraph(out, repo, "Co-authored", "-co-authored");
 	
 	for (size_t n_c = 0; n_c < repo->history->n_co_authored; n_c++) {
-		fprintf(out, "\t\\item \\label{%s:item:%s} ",
-				repo->name.val,
-				authored[n_c]->hash.val);
-		if (settings->print_msg) {
-			print_commit_message(out, co_authored[n_c]);
-		}
-		fprintf(out, "\\href{%s}{%s} (%s) ",
-				repo->format.commit_url(repo->url, authored[n_c]->hash).val,
-				co_authored[n_c]->hash.val,
-				format_date(co_authored[n_c]->date, settings->date_only).val);
-		if (settings->show_diffs) {
-			print_commit_diffs(out, authored[n_c]);
-		}
+		const commit_t commit = commit_table_row(&repo->history->commits, co_authored[n_c]);
+		generate_latex_commit(out, repo, &commit, settings, buf);
 	}
 
-	fprintf(out, "\\end{enumerate}\n");
+	sink_puts(out, "\\end{enumerate}\n");
 }
 
-static void generate_latex_file_list(FILE *out, const
-									 repository_t *repo,
-									 const indexes_t *indexes,
-									 const settings_t *settings)
+static void generate_latex_file_list_item(sink_t *out,
+										  const timeline_item_t *item,
+										  const settings_t *settings,
+										  render_buf_t *buf)
 {
-	commit_t **const authored = indexes->authored;
-	commit_t **const co_authored = indexes->co_authored;
+	const repository_t *repo = item->repo;
+	const commit_t *commit = &item->commit;
 
-	for (size_t n_c = 0; n_c < repo->history->n_authored; n_c++) {
-		fprintf(out, "\t\\item \\label{%s:item:%s}",
-				repo->name.val,
-				authored[n_c]->hash.val);
-		if (settings->print_msg) {
-			print_commit_message(out, authored[n_c]);
-		}
-		fprintf(out, "%s: [A] \\href{%s}{%s} %s\n",
-				repo->name.val,
-				repo->format.commit_url(repo->url, authored[n_c]->hash).val,
-				authored[n_c]->hash.val,
-				format_date(authored[n_c]->date, settings->date_only).val);
-		if (settings->show_diffs) {
-			print_commit_diffs(out, authored[n_c]);
-		}
+	print_commit_label(out, repo, commit);
+	if (settings->print_msg) {
+		print_commit_message(out, commit, buf);
+	}
+	sink_put_str(out, repo->name);
+	sink_puts(out, item->responsability == AUTHORED ? ": [A] " : ": [C] ");
+	print_commit_link(out, repo, commit);
+	sink_putc(out, ' ');
+	sink_put_date(out, commit->date, settings->date_only);
+	sink_putc(out, '\n');
+	if (settings->show_diffs) {
+		print_commit_diffs(out, commit);
 	}
+}
 
-	for (size_t n_c = 0; n_c < repo->history->n_co_authored; n_c++) {
-		fprintf(out, "\t\\item \\label{%s:item:%s} ",
-				repo->name.val,
-				authored[n_c]->hash.val);
-		if (settings->print_msg) {
-			print_commit_message(out, co_authored[n_c]);
-		}
-		fprintf(out, "%s: [C] \\href{%s}{%s} %s\n",
-				repo->name.val,
-				repo->format.commit_url(repo->url, authored[n_c]->hash).val,
-				co_authored[n_c]->hash.val,
-				format_date(co_authored[n_c]->date, settings->date_only).val);
-		if (settings->show_diffs) {
-			print_commit_diffs(out, authored[n_c]);
-		}
+static void generate_latex_file_list(sink_t *out,
+									 const repository_array_t *repos,
+									 const settings_t *settings)
+{
+	timeline_t timeline;
+	timeline_item_t item;
+	render_buf_t buf;
+
+	if (timeline_init(&timeline, repos, settings) != OK) { return; }
+
+	sink_puts(out, "\n\n\\begin{enumerate}\n" LIST_ITEMS_SPACING "\n");
+	while (timeline_next(&timeline, &item)) {
+		generate_latex_file_list_item(out, &item, settings, &buf);
 	}
+	sink_puts(out, "\\end{enumerate}\n");
+
+	timeline_free(&timeline);
 }
 
-void generate_latex_file(FILE *out, const repository_array_t *repos, const settings_t *settings)
+void generate_latex_section(sink_t *out, const repository_t *repo, const settings_t *settings)
 {
-	fprintf(out, "%% This file is automatically generated by TUR.\n"
-				 "%% This file is not standalone, you have to "
-				 "include it in a LaTeX document with both "
-				 "*xcolor* and *hyperref* packages.\n\n"
-				 "%% Commands definition\n"
-				 "\\newcommand{\\turtexpar}[1]{\\textbf{#1}}");
+	render_buf_t buf;
+
+	generate_latex_file_grouped(out, repo, &repo->history->indexes, settings, &buf);
+}
+
+void generate_latex_header(sink_t *out, const settings_t *settings)
+{
+	sink_puts(out, "% This file is automatically generated by TUR.\n"
+				   "% This file is not standalone, you have to "
+				   "include it in a LaTeX document with both "
+				   "*xcolor* and *hyperref* packages.\n\n"
+				   "% Commands definition\n"
+				   "\\newcommand{\\turtexpar}[1]{\\textbf{#1}}");
 
 	if (str_not_empty(settings->title)) {
-		fprintf(out, "\n\n\\section{%s}", settings->title.val);
+		sink_puts(out, "\n\n\\section{");
+		sink_put_str(out, settings->title);
+		sink_putc(out, '}');
 	}
+}
+
+void generate_latex_file(sink_t *out, const repository_array_t *repos,
+						 const settings_t *settings, const sink_t *sections)
+{
+	generate_latex_header(out, settings);
 
 	if (!settings->grouped) {
-		fprintf(out, "\n\n\\begin{enumerate}\n" LIST_ITEMS_SPACING "\n");
+		generate_latex_file_list(out, repos, settings);
+		return;
 	}
 
 	for (size_t i = 0; i < repos->len; i++) {
-		repository_t *repo = repo_array_get(repos, i);
-
-		if (settings->grouped) {
-			generate_latex_file_grouped(out, repo, &repo->history->indexes, settings);
-		} else {
-			generate_latex_file_list(out, repo, &repo->history->indexes, settings);
+		if (sections) {
+			sink_write(out, sections[i].buf, sections[i].len);
+			continue;
 		}
-	}
-
-	if (!settings->grouped) {
-		fprintf(out, "\\end{enumerate}\n");
+		generate_latex_section(out, repo_array_get(repos, i), settings);
 	}
 }
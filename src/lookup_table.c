@@ -19,6 +19,7 @@
  * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
  */
 
+#include "alloc.h"
 #include "codes.h"
 #include "log.h"
 #include "lookup_table.h"
@@ -33,7 +34,7 @@ static table_status_t increase_table_size(table_t *table)
 
 	if (new_size <= old_size) { return LM_MAP_SIZE_OVERFLOW; }
 	
-	table->pairs = realloc(table->pairs, new_size * sizeof(pair_t));
+	table->pairs = tur_realloc(table->pairs, new_size * sizeof(pair_t));
 	if (!table->pairs) { return LM_FAILED_EXPANDING_MAP_SIZE; }
 
 	for (size_t i = old_size; i < new_size; i++) {
@@ -58,7 +59,7 @@ table_status_t table_init(table_t *table, size_t capacity, size_t increment,
 	table->size = 0;
 	table->max_size = capacity;
 	table->increment = increment;
-	table->pairs = malloc(capacity * sizeof(pair_t));
+	table->pairs = tur_malloc(capacity * sizeof(pair_t));
 	table->hash = hash;
 	if (table->pairs == NULL) { return LM_CANNOT_INIT_TABLE_PAIRS; }
 
@@ -182,7 +183,7 @@ void table_free(table_t *table)
 	for (size_t i = 0; i < table->max_size; i++) {
 		free_pair(table->pairs + i);
 	}
-	free(table->pairs);
+	tur_free(table->pairs);
 	table->pairs = NULL;
 	table->increment = 0;
 	table->max_size = 0;
@@ -22,139 +22,168 @@
 #include "commit.h"
 #include "repo.h"
 #include "settings.h"
+#include "sink.h"
+#include "timeline.h"
 #include "utils.h"
 
-#include <stdio.h>
+static void print_commit_diffs(sink_t *out, const commit_t *commit)
+{
+	sink_put_uint(out, commit->stats.files_changed);
+	sink_puts(out, commit->stats.files_changed > 1 ? " files changed " : " file  changed ");
+	sink_puts(out, "<span style='color:green;'>+");
+	sink_put_uint(out, commit->stats.lines_added);
+	sink_puts(out, "</span> | <span style='color:red;'>-");
+	sink_put_uint(out, commit->stats.lines_removed);
+	sink_puts(out, "</span>\n");
+}
+
+static void print_commit_message(sink_t *out, const commit_t * commit)
+{
+	sink_put_str(out, first_line_view(commit->msg));
+	sink_putc(out, '\n');
+}
 
-static void print_commit_diffs(FILE *out, const commit_t *commit)
+static void print_commit_link(sink_t *out, const repository_t *repo, const commit_t *commit)
 {
-	fprintf(out, "%zu file%c changed "
-				 "<span style='color:green;'>+%zu</span> "
-				 "| <span style='color:red;'>-%zu</span>\n",
-			commit->stats.files_changed,
-			(commit->stats.files_changed > 1 ? 's': ASCII_SPACE),
-			commit->stats.lines_added,
-			commit->stats.lines_removed);
+	sink_putc(out, '[');
+	sink_put_str(out, commit->hash);
+	sink_puts(out, "](");
+	sink_put_str(out, repo->url);
+	sink_put_str(out, repo->format.commit_path);
+	sink_put_str(out, commit->hash);
+	sink_putc(out, ')');
 }
 
-static void print_commit_message(FILE *out, const commit_t * commit)
+static void generate_md_commit(sink_t *out, const repository_t *repo,
+							   const commit_t *commit, size_t n_commit,
+							   const settings_t *settings)
 {
-	fprintf(out, "%s\n", get_first_line(commit->msg).val);
+	sink_put_uint(out, n_commit);
+	sink_puts(out, ". ");
+	if (settings->print_msg) {
+		print_commit_message(out, commit);
+	}
+	print_commit_link(out, repo, commit);
+	sink_putc(out, ' ');
+	sink_put_date(out, commit->date, settings->date_only);
+	sink_putc(out, '\n');
+	if (settings->show_diffs) {
+		print_commit_diffs(out, commit);
+	}
 }
 
-static void generate_md_file_grouped(FILE *out,
+static void generate_md_file_grouped(sink_t *out,
 									 const repository_t *repo,
 									 const indexes_t *indexes,
 									 const settings_t *settings)
 {
-	commit_t **const authored = indexes->authored;
-	commit_t **const co_authored = indexes->co_authored;
+	const uint32_t *authored = indexes->authored;
+	const uint32_t *co_authored = indexes->co_authored;
 
 	if (repo->history->n_authored == 0 && repo->history->n_co_authored == 0) { return; }
 
-	fprintf(out, "## %s\n", repo->name.val);
+	sink_puts(out, "## ");
+	sink_put_str(out, repo->name);
+	sink_puts(out, truncation_note(repo->history->truncated));
+	sink_putc(out, '\n');
 		
 	if (repo->history->n_authored == 0) { goto co_authored; }
 
-	fprintf(out, "#### Authored\n");
+	sink_puts(out, "#### Authored\n");
 	
 	for (size_t n_c = 0; n_c < repo->history->n_authored; n_c++) {
-		fprintf(out, "%zu. ", n_c + 1);
-		if (settings->print_msg) {
-			print_commit_message(out, authored[n_c]);
-		}
-		fprintf(out, "[%s](%s) %s\n",
-				authored[n_c]->hash.val,
-				repo->format.commit_url(repo->url, authored[n_c]->hash).val,
-				format_date(authored[n_c]->date, settings->date_only).val);
-		if (settings->show_diffs) {
-			print_commit_diffs(out, authored[n_c]);
-		}
+		const commit_t commit = commit_table_row(&repo->history->commits, authored[n_c]);
+		generate_md_commit(out, repo, &commit, n_c + 1, settings);
 	}
 
 co_authored:
 	
 	if (repo->history->n_co_authored == 0) { return; }
 
-	fprintf(out, "#### Coauthored\n");
+	sink_puts(out, "#### Coauthored\n");
 	
 	for (size_t n_c = 0; n_c < repo->history->n_co_authored; n_c++) {
-		fprintf(out, "%zu. ", n_c + 1);
-		if (settings->print_msg) {
-			print_commit_message(out, co_authored[n_c]);
-		}
-		fprintf(out, "[%s](%s) %s\n",
-				co_authored[n_c]->hash.val,
-				repo->format.commit_url(repo->url, co_authored[n_c]->hash).val,
-				format_date(co_authored[n_c]->date, settings->date_only).val);
-		if (settings->show_diffs) {
-			print_commit_diffs(out, co_authored[n_c]);
-		}
+		const commit_t commit = commit_table_row(&repo->history->commits, co_authored[n_c]);
+		generate_md_commit(out, repo, &commit, n_c + 1, settings);
 	}
 }
 
-static void generate_md_file_list(FILE *out,
-								  const repository_t *repo,
-								  const indexes_t *indexes,
-								  const settings_t *settings)
+static void generate_md_file_list_item(sink_t *out,
+									   const timeline_item_t *item,
+									   size_t n_commit,
+									   const settings_t *settings)
 {
-	commit_t **const authored = indexes->authored;
-	commit_t **const co_authored = indexes->co_authored;
+	const repository_t *repo = item->repo;
+	const commit_t *commit = &item->commit;
 
-	size_t n_commit = 1;
-	for (size_t n_c = 0; n_c < repo->history->n_authored; n_c++) {
-		fprintf(out, "%zu. ", n_commit);
-		if (settings->print_msg) {
-			print_commit_message(out, authored[n_c]);
-		}
-		fprintf(out, "%s: [%s](%s) [A] %s\n",
-				repo->name.val,
-				authored[n_c]->hash.val,
-				repo->format.commit_url(repo->url, authored[n_c]->hash).val,
-				format_date(authored[n_c]->date, settings->date_only).val);
-		if (settings->show_diffs) {
-			print_commit_diffs(out, authored[n_c]);
-		}
-		fprintf(out, "\n");
-		n_commit++;
+	sink_put_uint(out, n_commit);
+	sink_puts(out, ". ");
+	if (settings->print_msg) {
+		print_commit_message(out, commit);
 	}
+	sink_put_str(out, repo->name);
+	sink_puts(out, ": ");
+	print_commit_link(out, repo, commit);
+	sink_puts(out, item->responsability == AUTHORED ? " [A] " : " [C] ");
+	sink_put_date(out, commit->date, settings->date_only);
+	sink_putc(out, '\n');
+	if (settings->show_diffs) {
+		print_commit_diffs(out, commit);
+	}
+	sink_putc(out, '\n');
+}
 
-	for (size_t n_c = 0; n_c < repo->history->n_co_authored; n_c++) {
-		fprintf(out, "%zu. ", n_commit);
-		if (settings->print_msg) {
-			print_commit_message(out, co_authored[n_c]);
-		}
-		fprintf(out, "%zu. %s: [%s](%s) [C] %s\n",
-				n_commit,
-				repo->name.val,
-				co_authored[n_c]->hash.val,
-				repo->format.commit_url(repo->url, co_authored[n_c]->hash).val,
-				format_date(co_authored[n_c]->date, settings->date_only).val);
-		if (settings->show_diffs) {
-			print_commit_diffs(out, co_authored[n_c]);
-		}
-		fprintf(out, "\n");
+static void generate_md_file_list(sink_t *out,
+								  const repository_array_t *repos,
+								  const settings_t *settings)
+{
+	timeline_t timeline;
+	timeline_item_t item;
+	size_t n_commit = 1;
+
+	if (timeline_init(&timeline, repos, settings) != OK) { return; }
+
+	while (timeline_next(&timeline, &item)) {
+		generate_md_file_list_item(out, &item, n_commit, settings);
 		n_commit++;
 	}
+
+	timeline_free(&timeline);
 }
 
-void generate_markdown_file(FILE *out, const repository_array_t *repos, const settings_t *settings)
+void generate_markdown_section(sink_t *out, const repository_t *repo, const settings_t *settings)
 {
-	fprintf(out, "{::comment}\n"
-				 "This file is automatically generated by TUR.\n"
-				 "{:/comment}\n\n");
+	generate_md_file_grouped(out, repo, &repo->history->indexes, settings);
+}
+
+void generate_markdown_header(sink_t *out, const settings_t *settings)
+{
+	sink_puts(out, "{::comment}\n"
+				   "This file is automatically generated by TUR.\n"
+				   "{:/comment}\n\n");
 	
 	if (str_not_empty(settings->title)) {
-		fprintf(out, "# %s\n", settings->title.val);
+		sink_puts(out, "# ");
+		sink_put_str(out, settings->title);
+		sink_putc(out, '\n');
 	}
+}
 
-	for (size_t i = 0; i < repos->len; i++) {
-		repository_t *repo = repo_array_get(repos, i);
+void generate_markdown_file(sink_t *out, const repository_array_t *repos,
+							const settings_t *settings, const sink_t *sections)
+{
+	generate_markdown_header(out, settings);
+
+	if (!settings->grouped) {
+		generate_md_file_list(out, repos, settings);
+		return;
+	}
 
-		if (settings->grouped) {
-			generate_md_file_grouped(out, repo, &repo->history->indexes, settings);
-		} else {
-			generate_md_file_list(out, repo, &repo->history->indexes, settings);
+	for (size_t i = 0; i < repos->len; i++) {
+		if (sections) {
+			sink_write(out, sections[i].buf, sections[i].len);
+			continue;
 		}
+		generate_markdown_section(out, repo_array_get(repos, i), settings);
 	}
 }
@@ -19,6 +19,7 @@
  * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
  */
 
+#include "alloc.h"
 #include "codes.h"
 #include "log.h"
 #include "opts_args.h"
@@ -47,6 +48,16 @@ tur_output_t parse_output_file_ext(const char *arg)
 		return HTML;
 	} else if (strcasecmp(dot, "md") == 0) {
 		return JEKYLL;
+	} else if (strcasecmp(dot, "json") == 0) {
+		return JSON;
+	} else if (strcasecmp(dot, "ndjson") == 0 || strcasecmp(dot, "jsonl") == 0) {
+		return NDJSON;
+	} else if (strcasecmp(dot, "csv") == 0) {
+		return CSV;
+	} else if (strcasecmp(dot, "tsv") == 0) {
+		return TSV;
+	} else if (strcasecmp(dot, "turc") == 0) {
+		return COLUMNAR;
 	}
 
 default_ret:
@@ -96,7 +107,7 @@ str_array_t *parse_emails(const char *input)
 	}
 
 cleanup_and_exit:
-	free(trimmed_str);
+	tur_free(trimmed_str);
 	return emails;
 }
 
@@ -115,6 +126,44 @@ uint16_t parse_optarg_to_int(const char *optarg, unsigned *out_value)
 	return OK;
 }
 
+/* Parses the argument of -j: either a number of threads between 1 and
+ * MAX_THREADS, or "auto" for the adaptive controller. In the latter case
+ * n_threads is left as it is, and it is used as the starting point. */
+uint16_t parse_jobs(const char *optarg, size_t *n_threads, bool *adaptive)
+{
+	unsigned value;
+
+	if (!optarg) { return REQUIRED_ARG_NULL; }
+	if (!n_threads || !adaptive) { return NULL_PARAMETER; }
+
+	if (strcasecmp(optarg, "auto") == 0) {
+		*adaptive = true;
+		return OK;
+	}
+
+	const uint16_t ret = parse_optarg_to_int(optarg, &value);
+	if (ret != OK) { return ret; }
+	if (value == 0 || value > MAX_THREADS) { return UNSUPPORTED_VALUE; }
+
+	*n_threads = value;
+	*adaptive = false;
+	return OK;
+}
+
+uint16_t parse_progress(const char *optarg, progress_mode_t *mode)
+{
+	if (!mode) { return NULL_PARAMETER; }
+
+	if (!optarg || *optarg == '\0' || strcasecmp(optarg, "text") == 0) {
+		*mode = PROGRESS_TEXT;
+	} else if (strcasecmp(optarg, "json") == 0) {
+		*mode = PROGRESS_JSON;
+	} else {
+		return UNSUPPORTED_VALUE;
+	}
+	return OK;
+}
+
 uint16_t parse_sort_order(const char *opt_str, size_t len, sort_ordering_t *order)
 {
 	uint16_t ret;
@@ -159,6 +208,6 @@ uint16_t parse_sort_order(const char *opt_str, size_t len, sort_ordering_t *orde
 	ret = UNKONWN_SORT_ORDER;
 
 cleanup_and_exit:
-	free(str);
+	tur_free(str);
 	return ret;
 }
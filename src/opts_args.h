@@ -29,5 +29,8 @@ tur_output_t parse_output_file_ext(const char *arg);
 str_array_t *parse_emails(const char *input);
 uint16_t parse_optarg_to_int(const char *optarg, unsigned *out_value);
 uint16_t parse_sort_order(const char *opt_str, size_t len, sort_ordering_t *order);
+uint16_t parse_jobs(const char *optarg, size_t *n_threads, bool *adaptive);
+/* --progress[=text|json]: without an argument the reports are text */
+uint16_t parse_progress(const char *optarg, progress_mode_t *mode);
 
 #endif /* __OPTS_ARGS__ */
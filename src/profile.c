@@ -0,0 +1,349 @@
+/* profile.c
+ * -----------------------------------------------------------------------
+ * Copyright (C) 2025  Matteo Nicoli
+ *
+ * This file is part of TUR.
+ *
+ * TUR is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "codes.h"
+#include "log.h"
+#include "profile.h"
+#include "repo.h"
+#include "sink.h"
+
+#include <limits.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+
+#define NS_PER_MS 1e6
+#define N_REPO_PHASES (PROFILE_RENDER + 1)
+
+static const char *phase_names[PROFILE_N_PHASES] = {
+	"open", "revwalk", "lookup", "diff", "index", "render",
+	"cache", "output", "total"
+};
+
+static const char *counter_names[PROFILE_N_COUNTERS] = {
+	"visited", "matched", "diffs", "bytes"
+};
+
+static void print_row(const char *name, int name_width, const profile_t *profile)
+{
+	(void)log_info("%-*s", name_width, name);
+	for (size_t p = 0; p < N_REPO_PHASES; p++) {
+		(void)log_info(" %9.2f", (double)profile->ns[p] / NS_PER_MS);
+	}
+	for (size_t c = 0; c < PROFILE_N_COUNTERS; c++) {
+		(void)log_info(" %9lu", (unsigned long)profile->counters[c]);
+	}
+	(void)log_info("\n");
+}
+
+void profile_print_table(const array_t *repos, const profile_t *profiles,
+						 const profile_t *run)
+{
+	profile_t sum = { 0 };
+	int name_width = (int)sizeof("repository") - 1;
+
+	for (size_t i = 0; i < repos->len; i++) {
+		const int len = (int)repo_array_get(repos, i)->name.len;
+		if (len > name_width) { name_width = len; }
+	}
+
+	(void)log_info("\nProfile (times in ms)\n%-*s", name_width, "repository");
+	for (size_t p = 0; p < N_REPO_PHASES; p++) {
+		(void)log_info(" %9s", phase_names[p]);
+	}
+	for (size_t c = 0; c < PROFILE_N_COUNTERS; c++) {
+		(void)log_info(" %9s", counter_names[c]);
+	}
+	(void)log_info("\n");
+
+	for (size_t i = 0; i < repos->len; i++) {
+		print_row(repo_array_get(repos, i)->name.val, name_width, profiles + i);
+		for (size_t p = 0; p < N_REPO_PHASES; p++) {
+			sum.ns[p] += profiles[i].ns[p];
+		}
+		for (size_t c = 0; c < PROFILE_N_COUNTERS; c++) {
+			sum.counters[c] += profiles[i].counters[c];
+		}
+	}
+	/* Summed over the threads, so it can exceed the wall time */
+	print_row("sum", name_width, &sum);
+
+	(void)log_info("cache %.2f ms, output %.2f ms (%lu bytes), total %.2f ms\n",
+				   (double)run->ns[PROFILE_CACHE] / NS_PER_MS,
+				   (double)run->ns[PROFILE_OUTPUT] / NS_PER_MS,
+				   (unsigned long)run->counters[PROFILE_BYTES],
+				   (double)run->ns[PROFILE_TOTAL] / NS_PER_MS);
+}
+
+static void put_profile(sink_t *out, const profile_t *profile, size_t first, size_t last)
+{
+	sink_puts(out, "{\"ns\":{");
+	for (size_t p = first; p < last; p++) {
+		sink_printf(out, "%s\"%s\":", p > first ? "," : "", phase_names[p]);
+		sink_put_uint(out, profile->ns[p]);
+	}
+	sink_puts(out, "}");
+	for (size_t c = 0; c < PROFILE_N_COUNTERS; c++) {
+		sink_printf(out, ",\"%s\":", counter_names[c]);
+		sink_put_uint(out, profile->counters[c]);
+	}
+	sink_putc(out, '}');
+}
+
+return_code_t profile_write_json(const char *path, const array_t *repos,
+								 const profile_t *profiles, const profile_t *run)
+{
+	sink_t out;
+
+	if (sink_init_file(&out, path, false) != OK) {
+		(void)log_err("profile_write_json: cannot open file: %s\n", path);
+		return CANNOT_OPEN_OUTPUT;
+	}
+
+	sink_puts(&out, "{\"run\":");
+	put_profile(&out, run, N_REPO_PHASES, PROFILE_N_PHASES);
+	sink_puts(&out, ",\"repositories\":[");
+	for (size_t i = 0; i < repos->len; i++) {
+		if (i) { sink_putc(&out, ','); }
+		sink_puts(&out, "{\"name\":");
+		sink_put_json_str(&out, repo_array_get(repos, i)->name);
+		sink_puts(&out, ",\"profile\":");
+		put_profile(&out, profiles + i, 0, N_REPO_PHASES);
+		sink_putc(&out, '}');
+	}
+	sink_puts(&out, "]}\n");
+
+	const return_code_t ret = sink_close(&out);
+	if (ret != OK) {
+		(void)log_err("profile_write_json: cannot write file: %s\n", path);
+	}
+	return ret;
+}
+
+/*
+ * OpenMetrics text export (--metrics). Every value describes the last run,
+ * so all the metrics are gauges.
+ */
+
+static void put_family(sink_t *out, const char *name, const char *help)
+{
+	sink_printf(out, "# HELP %s %s\n# TYPE %s gauge\n", name, help, name);
+}
+
+static void put_label_value(sink_t *out, str_t value)
+{
+	sink_putc(out, '"');
+	for (size_t i = 0; i < value.len; i++) {
+		const char c = value.val[i];
+		if (c == '\\' || c == '"') {
+			sink_putc(out, '\\');
+			sink_putc(out, c);
+		} else if (c == '\n') {
+			sink_puts(out, "\\n");
+		} else {
+			sink_putc(out, c);
+		}
+	}
+	sink_putc(out, '"');
+}
+
+/* Two repositories can share a name, so the id keeps the series apart */
+static void put_repo_sample(sink_t *out, const char *name, const repository_t *repo,
+							const char *phase)
+{
+	sink_printf(out, "%s{repo=", name);
+	put_label_value(out, repo->name);
+	sink_printf(out, ",id=\"%u\"", repo->id);
+	if (phase) {
+		sink_printf(out, ",phase=\"%s\"", phase);
+	}
+	sink_puts(out, "} ");
+}
+
+static void put_seconds(sink_t *out, uint64_t ns)
+{
+	sink_put_uint(out, ns / 1000000000ull);
+	sink_printf(out, ".%09u\n", (unsigned)(ns % 1000000000ull));
+}
+
+static void put_uint_line(sink_t *out, uint64_t value)
+{
+	sink_put_uint(out, value);
+	sink_putc(out, '\n');
+}
+
+static uint64_t walk_ns(const profile_t *profile)
+{
+	uint64_t ns = 0;
+	for (size_t p = PROFILE_OPEN; p <= PROFILE_INDEX; p++) {
+		ns += profile->ns[p];
+	}
+	return ns;
+}
+
+static void put_repo_counter(sink_t *out, const array_t *repos, const profile_t *profiles,
+							 const char *name, const char *help, profile_counter_t counter)
+{
+	put_family(out, name, help);
+	for (size_t i = 0; i < repos->len; i++) {
+		put_repo_sample(out, name, repo_array_get(repos, i), NULL);
+		put_uint_line(out, profiles[i].counters[counter]);
+	}
+}
+
+static void put_run_value(sink_t *out, const char *name, const char *help, uint64_t value)
+{
+	put_family(out, name, help);
+	sink_printf(out, "%s ", name);
+	put_uint_line(out, value);
+}
+
+return_code_t profile_write_metrics(const char *path, const array_t *repos,
+									const profile_t *profiles, const profile_t *run,
+									const return_code_t *errors)
+{
+	sink_t out;
+	profile_t sum = { 0 };
+	uint64_t lines_added = 0, lines_removed = 0, n_failed = 0, n_truncated = 0;
+	char tmp_path[PATH_MAX];
+
+	/* The textfile collectors may read the file at any time: it is written
+	 * aside and renamed once complete */
+	if (snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path) >= (int)sizeof(tmp_path)) {
+		(void)log_err("profile_write_metrics: path too long: %s\n", path);
+		return CANNOT_OPEN_OUTPUT;
+	}
+	if (sink_init_file(&out, tmp_path, false) != OK) {
+		(void)log_err("profile_write_metrics: cannot open file: %s\n", tmp_path);
+		return CANNOT_OPEN_OUTPUT;
+	}
+
+	put_repo_counter(&out, repos, profiles, "tur_repo_commits_visited",
+					 "Commits returned by the revwalk", PROFILE_VISITED);
+	put_repo_counter(&out, repos, profiles, "tur_repo_commits_matched",
+					 "Commits (co-)authored by the given emails", PROFILE_MATCHED);
+	put_repo_counter(&out, repos, profiles, "tur_repo_commit_diffs",
+					 "Trees diffed to compute the commit stats", PROFILE_DIFFS);
+
+	put_family(&out, "tur_repo_lines_added", "Lines added by the matched commits");
+	for (size_t i = 0; i < repos->len; i++) {
+		const repository_t *repo = repo_array_get(repos, i);
+		put_repo_sample(&out, "tur_repo_lines_added", repo, NULL);
+		put_uint_line(&out, repo->history ? repo->history->tot_lines_added : 0);
+	}
+	put_family(&out, "tur_repo_lines_removed", "Lines removed by the matched commits");
+	for (size_t i = 0; i < repos->len; i++) {
+		const repository_t *repo = repo_array_get(repos, i);
+		put_repo_sample(&out, "tur_repo_lines_removed", repo, NULL);
+		put_uint_line(&out, repo->history ? repo->history->tot_lines_removed : 0);
+	}
+
+	put_family(&out, "tur_repo_walk_seconds",
+			   "Time spent opening, walking, diffing and indexing the repository");
+	for (size_t i = 0; i < repos->len; i++) {
+		put_repo_sample(&out, "tur_repo_walk_seconds", repo_array_get(repos, i), NULL);
+		put_seconds(&out, walk_ns(profiles + i));
+	}
+	put_family(&out, "tur_repo_phase_seconds", "Time spent in each phase of the repository");
+	for (size_t i = 0; i < repos->len; i++) {
+		for (size_t p = 0; p < N_REPO_PHASES; p++) {
+			put_repo_sample(&out, "tur_repo_phase_seconds", repo_array_get(repos, i),
+							phase_names[p]);
+			put_seconds(&out, profiles[i].ns[p]);
+		}
+	}
+
+	put_family(&out, "tur_repo_error", "1 if the repository could not be walked");
+	for (size_t i = 0; i < repos->len; i++) {
+		const repository_t *repo = repo_array_get(repos, i);
+		const bool failed = errors && errors[i] != OK;
+		put_repo_sample(&out, "tur_repo_error", repo, NULL);
+		put_uint_line(&out, failed);
+
+		n_failed += failed;
+		if (repo->history) {
+			lines_added += repo->history->tot_lines_added;
+			lines_removed += repo->history->tot_lines_removed;
+		}
+		for (size_t p = 0; p < N_REPO_PHASES; p++) {
+			sum.ns[p] += profiles[i].ns[p];
+		}
+		for (size_t c = 0; c < PROFILE_N_COUNTERS; c++) {
+			sum.counters[c] += profiles[i].counters[c];
+		}
+	}
+
+	put_family(&out, "tur_repo_truncated",
+			   "1 if the walk of the repository stopped when its budget ran out");
+	for (size_t i = 0; i < repos->len; i++) {
+		const repository_t *repo = repo_array_get(repos, i);
+		const bool truncated = repo->history && repo->history->truncated;
+		put_repo_sample(&out, "tur_repo_truncated", repo, NULL);
+		put_uint_line(&out, truncated);
+		n_truncated += truncated;
+	}
+
+	put_run_value(&out, "tur_repositories", "Repositories in the list", repos->len);
+	put_run_value(&out, "tur_repositories_failed", "Repositories that could not be walked",
+				  n_failed);
+	put_run_value(&out, "tur_repositories_truncated",
+				  "Repositories whose walk stopped when its budget ran out", n_truncated);
+	put_run_value(&out, "tur_commits_visited", "Commits returned by the revwalks",
+				  sum.counters[PROFILE_VISITED]);
+	put_run_value(&out, "tur_commits_matched", "Commits (co-)authored by the given emails",
+				  sum.counters[PROFILE_MATCHED]);
+	put_run_value(&out, "tur_commit_diffs", "Trees diffed to compute the commit stats",
+				  sum.counters[PROFILE_DIFFS]);
+	put_run_value(&out, "tur_lines_added", "Lines added by the matched commits", lines_added);
+	put_run_value(&out, "tur_lines_removed", "Lines removed by the matched commits",
+				  lines_removed);
+	put_run_value(&out, "tur_output_bytes", "Bytes written to the outputs",
+				  run->counters[PROFILE_BYTES]);
+
+	/* The repository phases are summed over the threads */
+	put_family(&out, "tur_phase_seconds",
+			   "Time spent in each phase, summed over the repositories");
+	for (size_t p = 0; p < PROFILE_TOTAL; p++) {
+		sink_printf(&out, "tur_phase_seconds{phase=\"%s\"} ", phase_names[p]);
+		put_seconds(&out, p < N_REPO_PHASES ? sum.ns[p] : run->ns[p]);
+	}
+	put_family(&out, "tur_run_duration_seconds", "Wall time of the run");
+	sink_puts(&out, "tur_run_duration_seconds ");
+	put_seconds(&out, run->ns[PROFILE_TOTAL]);
+	put_run_value(&out, "tur_last_run_timestamp_seconds", "Unix time at the end of the run",
+				  (uint64_t)time(NULL));
+	sink_puts(&out, "# EOF\n");
+
+	return_code_t ret = sink_close(&out);
+	if (ret != OK) {
+		(void)log_err("profile_write_metrics: cannot write file: %s\n", tmp_path);
+		(void)unlink(tmp_path);
+		return ret;
+	}
+	if (rename(tmp_path, path) != 0) {
+		(void)log_err("profile_write_metrics: cannot rename %s to %s\n", tmp_path, path);
+		(void)unlink(tmp_path);
+		ret = CANNOT_OPEN_OUTPUT;
+	}
+	return ret;
+}
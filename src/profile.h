@@ -0,0 +1,104 @@
+/* profile.h
+ * -----------------------------------------------------------------------
+ * Copyright (C) 2025  Matteo Nicoli
+ *
+ * This file is part of TUR.
+ *
+ * TUR is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __PROFILE_H__
+#define __PROFILE_H__
+
+#include "array.h"
+#include "codes.h"
+
+#include <stdint.h>
+#include <time.h>
+
+/* Built-in instrumentation enabled by --stats, --profile and --metrics. Every
+ * repository has its own profile, filled only by the thread working on it,
+ * so no synchronization is needed; the phases that are not tied to a
+ * repository are recorded in the run profile. A NULL profile disables the
+ * timers, so the walk pays nothing when profiling is off. */
+
+typedef enum {
+	/* Per repository */
+	PROFILE_OPEN = 0,	/* git_repository_open and pushing the tips */
+	PROFILE_REVWALK,	/* git_revwalk_next */
+	PROFILE_LOOKUP,		/* Commit lookup, filtering and storage */
+	PROFILE_DIFF,		/* get_commit_stats */
+	PROFILE_INDEX,		/* build_indexes */
+	PROFILE_RENDER,		/* Rendering the -g section ahead of the output */
+	/* Per run */
+	PROFILE_CACHE,		/* .tur/commits I/O and index rebuild */
+	PROFILE_OUTPUT,		/* Writing the output files */
+	PROFILE_TOTAL,		/* The whole walk_through_repos */
+	PROFILE_N_PHASES
+} profile_phase_t;
+
+typedef enum {
+	PROFILE_VISITED = 0,	/* Commits returned by the revwalk */
+	PROFILE_MATCHED,		/* Commits (co-)authored by the given emails */
+	PROFILE_DIFFS,			/* Trees diffed to compute the stats */
+	PROFILE_BYTES,			/* Section bytes, or output bytes for the run */
+	PROFILE_N_COUNTERS
+} profile_counter_t;
+
+typedef struct {
+	uint64_t ns[PROFILE_N_PHASES];
+	uint64_t counters[PROFILE_N_COUNTERS];
+} profile_t;
+
+static inline uint64_t profile_clock(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static inline uint64_t profile_start(const profile_t *profile)
+{
+	return profile ? profile_clock() : 0;
+}
+
+/* Adds the time elapsed since *start to `phase`, and restarts the timer
+ * so that consecutive phases can be chained */
+static inline void profile_lap(profile_t *profile, profile_phase_t phase, uint64_t *start)
+{
+	if (!profile) { return; }
+	const uint64_t now = profile_clock();
+	profile->ns[phase] += now - *start;
+	*start = now;
+}
+
+static inline void profile_count(profile_t *profile, profile_counter_t counter, uint64_t n)
+{
+	if (profile) { profile->counters[counter] += n; }
+}
+
+/* `repos` is a repository array (repo.h includes this header through
+ * commit.h) and `profiles` has one entry per repository, in .rlist order */
+void profile_print_table(const array_t *repos, const profile_t *profiles,
+						 const profile_t *run);
+return_code_t profile_write_json(const char *path, const array_t *repos,
+								 const profile_t *profiles, const profile_t *run);
+/* OpenMetrics text file for the textfile collectors (--metrics). `errors`
+ * has the return code of the walk of each repository, or is NULL */
+return_code_t profile_write_metrics(const char *path, const array_t *repos,
+									const profile_t *profiles, const profile_t *run,
+									const return_code_t *errors);
+
+#endif /* __PROFILE_H__ */
@@ -0,0 +1,346 @@
+/* progress.c
+ * -----------------------------------------------------------------------
+ * Copyright (C) 2025  Matteo Nicoli
+ *
+ * This file is part of TUR.
+ *
+ * TUR is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "alloc.h"
+#include "codes.h"
+#include "log.h"
+#include "profile.h"
+#include "progress.h"
+#include "sink.h"
+#include "str.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define NS_PER_MS 1000000ull
+#define NS_PER_S 1e9
+#define CACHE_LINE_SIZE 64
+
+/* Written only by the thread bound to it, read by the reporter */
+typedef struct {
+	_Alignas(CACHE_LINE_SIZE) size_t visited;
+	size_t matched;
+	size_t diffed;
+	const char *repo;
+	uint64_t repo_start;
+	/* Reporter only: visited at the previous report */
+	size_t last_visited;
+} progress_slot_t;
+
+static progress_slot_t *slots = NULL;
+static size_t n_slots = 0;
+static size_t total_repos = 0;
+static size_t repos_done = 0;
+static progress_mode_t report_mode = PROGRESS_OFF;
+static bool running = false;
+static pthread_t reporter;
+static uint64_t start = 0;
+static uint64_t last_report = 0;
+static size_t last_visited = 0;
+static sink_t out;
+static struct sigaction previous_action;
+/* Set from the signal handler: lock-free atomics are async-signal-safe */
+static int dump_requested = 0;
+/* Self-pipe: SIGUSR1 and progress_stop write a byte to wake the reporter,
+ * which otherwise sleeps until the next report is due, or indefinitely
+ * without --progress */
+static int wake_pipe[2] = { -1, -1 };
+static _Thread_local progress_slot_t *local_slot = NULL;
+
+static void wake_reporter(void)
+{
+	/* Non-blocking: a full pipe already wakes the reporter */
+	const ssize_t written = write(wake_pipe[1], "", 1);
+	(void)written;
+}
+
+static void request_dump(int signal)
+{
+	const int saved_errno = errno;
+	(void)signal;
+	__atomic_store_n(&dump_requested, 1, __ATOMIC_RELAXED);
+	wake_reporter();
+	errno = saved_errno;
+}
+
+static void close_wake_pipe(void)
+{
+	for (size_t i = 0; i < 2; i++) {
+		if (wake_pipe[i] >= 0) { (void)close(wake_pipe[i]); }
+		wake_pipe[i] = -1;
+	}
+}
+
+static bool open_wake_pipe(void)
+{
+	if (pipe(wake_pipe) != 0) { return false; }
+	for (size_t i = 0; i < 2; i++) {
+		const int flags = fcntl(wake_pipe[i], F_GETFL);
+		if (flags < 0 || fcntl(wake_pipe[i], F_SETFL, flags | O_NONBLOCK) != 0) {
+			close_wake_pipe();
+			return false;
+		}
+	}
+	return true;
+}
+
+void progress_attach(size_t n_thread)
+{
+	local_slot = slots && n_thread < n_slots ? slots + n_thread : NULL;
+}
+
+void progress_begin_repo(const char *name)
+{
+	if (!local_slot) { return; }
+	__atomic_store_n(&local_slot->repo_start, profile_clock(), __ATOMIC_RELAXED);
+	__atomic_store_n(&local_slot->repo, name, __ATOMIC_RELEASE);
+}
+
+void progress_end_repo(void)
+{
+	if (!local_slot) { return; }
+	__atomic_store_n(&local_slot->repo, NULL, __ATOMIC_RELEASE);
+	(void)__atomic_add_fetch(&repos_done, 1, __ATOMIC_RELAXED);
+}
+
+void progress_add(size_t visited, size_t matched, size_t diffed)
+{
+	if (!local_slot) { return; }
+	(void)__atomic_add_fetch(&local_slot->visited, visited, __ATOMIC_RELAXED);
+	(void)__atomic_add_fetch(&local_slot->matched, matched, __ATOMIC_RELAXED);
+	(void)__atomic_add_fetch(&local_slot->diffed, diffed, __ATOMIC_RELAXED);
+}
+
+size_t progress_visited(void)
+{
+	size_t visited = 0;
+	for (size_t i = 0; slots && i < n_slots; i++) {
+		visited += __atomic_load_n(&slots[i].visited, __ATOMIC_RELAXED);
+	}
+	return visited;
+}
+
+static double per_second(size_t count, uint64_t ns)
+{
+	return ns ? (double)count * NS_PER_S / (double)ns : 0.0;
+}
+
+/* Extrapolated from the repositories done so far: negative when there is
+ * nothing to extrapolate from yet */
+static double eta_seconds(size_t done, uint64_t elapsed)
+{
+	if (done == 0) { return -1.0; }
+	if (done >= total_repos) { return 0.0; }
+	return (double)elapsed / NS_PER_S * (double)(total_repos - done) / (double)done;
+}
+
+static void put_duration(sink_t *sink, double seconds)
+{
+	const unsigned long s = (unsigned long)(seconds + 0.5);
+	if (s >= 3600) {
+		sink_printf(sink, "%luh%02lum%02lus", s / 3600, s / 60 % 60, s % 60);
+	} else if (s >= 60) {
+		sink_printf(sink, "%lum%02lus", s / 60, s % 60);
+	} else {
+		sink_printf(sink, "%lus", s);
+	}
+}
+
+static void report(void)
+{
+	const uint64_t now = profile_clock();
+	const uint64_t elapsed = now - start;
+	const uint64_t interval = now - last_report;
+	const size_t done = __atomic_load_n(&repos_done, __ATOMIC_RELAXED);
+	size_t visited = 0, matched = 0, diffed = 0;
+
+	for (size_t i = 0; i < n_slots; i++) {
+		visited += __atomic_load_n(&slots[i].visited, __ATOMIC_RELAXED);
+		matched += __atomic_load_n(&slots[i].matched, __ATOMIC_RELAXED);
+		diffed += __atomic_load_n(&slots[i].diffed, __ATOMIC_RELAXED);
+	}
+	const double rate = per_second(visited - last_visited, interval);
+	const double eta = eta_seconds(done, elapsed);
+
+	if (report_mode == PROGRESS_JSON) {
+		sink_printf(&out, "{\"elapsed_s\":%.3f,\"repos_done\":%zu,\"repos\":%zu,"
+					"\"visited\":%zu,\"matched\":%zu,\"diffed\":%zu,\"commits_per_s\":%.1f,",
+					(double)elapsed / NS_PER_S, done, total_repos, visited, matched, diffed, rate);
+		if (eta < 0) {
+			sink_puts(&out, "\"eta_s\":null");
+		} else {
+			sink_printf(&out, "\"eta_s\":%.1f", eta);
+		}
+		sink_puts(&out, ",\"threads\":[");
+	} else {
+		sink_puts(&out, "[progress ");
+		put_duration(&out, (double)elapsed / NS_PER_S);
+		sink_printf(&out, "] %zu/%zu repos, %zu commits visited (%.0f/s), %zu matched, "
+					"%zu diffed, ETA ", done, total_repos, visited, rate, matched, diffed);
+		if (eta < 0) {
+			sink_puts(&out, "unknown\n");
+		} else {
+			put_duration(&out, eta);
+			sink_putc(&out, '\n');
+		}
+	}
+
+	for (size_t i = 0; i < n_slots; i++) {
+		progress_slot_t *slot = slots + i;
+		const char *repo = __atomic_load_n(&slot->repo, __ATOMIC_ACQUIRE);
+		const size_t slot_visited = __atomic_load_n(&slot->visited, __ATOMIC_RELAXED);
+		const double slot_rate = per_second(slot_visited - slot->last_visited, interval);
+		const double repo_s = repo
+							  ? (double)(now - __atomic_load_n(&slot->repo_start,
+															   __ATOMIC_RELAXED)) / NS_PER_S
+							  : 0.0;
+
+		slot->last_visited = slot_visited;
+		if (report_mode == PROGRESS_JSON) {
+			sink_printf(&out, "%s{\"thread\":%zu,\"repo\":", i ? "," : "", i);
+			if (repo) {
+				sink_put_json_str(&out, (str_t) { .val = repo, .len = (uint16_t)strlen(repo) });
+			} else {
+				sink_puts(&out, "null");
+			}
+			sink_printf(&out, ",\"repo_s\":%.3f,\"visited\":%zu,\"commits_per_s\":%.1f}",
+						repo_s, slot_visited, slot_rate);
+		} else if (repo) {
+			sink_printf(&out, "  #%zu %s for ", i, repo);
+			put_duration(&out, repo_s);
+			sink_printf(&out, ", %.0f commits/s\n", slot_rate);
+		} else {
+			sink_printf(&out, "  #%zu idle\n", i);
+		}
+	}
+	if (report_mode == PROGRESS_JSON) {
+		sink_puts(&out, "]}\n");
+	}
+	/* A single write per report, so that it is not interleaved with the
+	 * log of the workers */
+	(void)sink_flush(&out);
+
+	last_report = now;
+	last_visited = visited;
+}
+
+/* Milliseconds until the next periodic report, or -1 without --progress */
+static int next_report_timeout(void)
+{
+	if (report_mode == PROGRESS_OFF) { return -1; }
+
+	const uint64_t interval = PROGRESS_INTERVAL_MS * NS_PER_MS;
+	const uint64_t elapsed = profile_clock() - last_report;
+	return elapsed >= interval ? 0 : (int)((interval - elapsed + NS_PER_MS - 1) / NS_PER_MS);
+}
+
+static void *run_reporter(void *arg)
+{
+	struct pollfd wake = { .fd = wake_pipe[0], .events = POLLIN };
+	char drain[64];
+	(void)arg;
+
+	while (__atomic_load_n(&running, __ATOMIC_ACQUIRE)) {
+		if (poll(&wake, 1, next_report_timeout()) > 0) {
+			while (read(wake_pipe[0], drain, sizeof(drain)) > 0) { }
+		}
+		if (!__atomic_load_n(&running, __ATOMIC_ACQUIRE)) { break; }
+
+		if (__atomic_exchange_n(&dump_requested, 0, __ATOMIC_RELAXED)) {
+			report();
+		} else if (report_mode != PROGRESS_OFF && next_report_timeout() == 0) {
+			report();
+		}
+	}
+	return NULL;
+}
+
+return_code_t progress_start(size_t n_threads, size_t n_repos, progress_mode_t mode)
+{
+	struct sigaction action = { 0 };
+
+	slots = tur_calloc(n_threads, sizeof(progress_slot_t));
+	if (!slots) { return RUNTIME_MALLOC_ERROR; }
+	if (sink_init_fd(&out, STDERR_FILENO) != OK) {
+		tur_free(slots);
+		slots = NULL;
+		return RUNTIME_MALLOC_ERROR;
+	}
+	if (!open_wake_pipe()) {
+		(void)log_err("progress_start: cannot create the wake-up pipe\n");
+		(void)sink_close(&out);
+		tur_free(slots);
+		slots = NULL;
+		return RUNTIME_PIPE_ERROR;
+	}
+	n_slots = n_threads;
+	total_repos = n_repos;
+	repos_done = 0;
+	report_mode = mode;
+	start = last_report = profile_clock();
+	last_visited = 0;
+	__atomic_store_n(&dump_requested, 0, __ATOMIC_RELAXED);
+
+	/* SA_RESTART: the signal must not interrupt the I/O of libgit2 */
+	action.sa_handler = request_dump;
+	action.sa_flags = SA_RESTART;
+	sigemptyset(&action.sa_mask);
+	(void)sigaction(SIGUSR1, &action, &previous_action);
+
+	__atomic_store_n(&running, true, __ATOMIC_RELEASE);
+	if (pthread_create(&reporter, NULL, run_reporter, NULL) != 0) {
+		(void)log_err("progress_start: cannot create the reporter thread\n");
+		__atomic_store_n(&running, false, __ATOMIC_RELEASE);
+		(void)sigaction(SIGUSR1, &previous_action, NULL);
+		close_wake_pipe();
+		(void)sink_close(&out);
+		tur_free(slots);
+		slots = NULL;
+		return RUNTIME_THREAD_CREATE_ERROR;
+	}
+	return OK;
+}
+
+void progress_stop(void)
+{
+	if (!slots) { return; }
+
+	__atomic_store_n(&running, false, __ATOMIC_RELEASE);
+	wake_reporter();
+	pthread_join(reporter, NULL);
+	(void)sigaction(SIGUSR1, &previous_action, NULL);
+	close_wake_pipe();
+	if (report_mode != PROGRESS_OFF) {
+		report();
+	}
+	(void)sink_close(&out);
+	tur_free(slots);
+	slots = NULL;
+	n_slots = 0;
+}
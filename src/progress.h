@@ -0,0 +1,61 @@
+/* progress.h
+ * -----------------------------------------------------------------------
+ * Copyright (C) 2025  Matteo Nicoli
+ *
+ * This file is part of TUR.
+ *
+ * TUR is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __PROGRESS_H__
+#define __PROGRESS_H__
+
+#include "codes.h"
+#include "settings.h"
+
+#include <stddef.h>
+
+/* Live progress of the walk. Every pool thread owns a slot, where it
+ * publishes the commits visited, matched and diffed in batches, from
+ * get_commit_history: they are the only counters of the walk, also read
+ * by the adaptive pool. A reporter thread reads the slots and prints the
+ * overall rate, the ETA and what each thread is walking:
+ *     - every PROGRESS_INTERVAL_MS with --progress;
+ *     - whenever the process receives SIGUSR1, with or without it.
+ * Without --progress the reporter sleeps until it receives SIGUSR1. */
+
+#define PROGRESS_INTERVAL_MS 1000
+
+/* Starts the reporter for a pool of `n_threads` threads walking `n_repos`
+ * repositories. The reports are written to stderr as text or, with
+ * PROGRESS_JSON, as one JSON object per line. */
+return_code_t progress_start(size_t n_threads, size_t n_repos, progress_mode_t mode);
+/* Stops the reporter and prints the last report with --progress */
+void progress_stop(void);
+
+/* Binds the calling thread to the slot of pool thread #n_thread */
+void progress_attach(size_t n_thread);
+/* The name must live until progress_stop */
+void progress_begin_repo(const char *name);
+void progress_end_repo(void);
+/* Publishes the counts since the previous call. It is meant to be called
+ * every few dozen commits: it costs three relaxed atomic additions on a
+ * cache line owned by the calling thread. */
+void progress_add(size_t visited, size_t matched, size_t diffed);
+/* Commits visited so far by every pool thread, matching or not. It can be
+ * sampled cheaply while the walk is running. */
+size_t progress_visited(void);
+
+#endif /* __PROGRESS_H__ */
@@ -0,0 +1,200 @@
+/* query.c
+ * -----------------------------------------------------------------------
+ * Copyright (C) 2025  Matteo Nicoli
+ *
+ * This file is part of TUR.
+ *
+ * TUR is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "alloc.h"
+#include "codes.h"
+#include "commit.h"
+#include "opts_args.h"
+#include "query.h"
+#include "settings.h"
+#include "sort.h"
+#include "str.h"
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include <unistd.h>
+
+static const struct {
+	const char *name;
+	tur_output_t mode;
+} formats[] = {
+	{ "text",   STDOUT },
+	{ "tex",    LATEX },
+	{ "html",   HTML },
+	{ "md",     JEKYLL },
+	{ "json",   JSON },
+	{ "ndjson", NDJSON },
+	{ "csv",    CSV },
+	{ "tsv",    TSV },
+	{ "turc",   COLUMNAR },
+};
+
+void query_init(query_t *query, const settings_t *settings)
+{
+	*query = (query_t) {
+		.settings = *settings,
+		.owns_emails = false,
+	};
+	/* The options that only make sense for files do not apply */
+	query->settings.output_mode = STDOUT;
+	query->settings.no_ansi = true;
+}
+
+void query_free(query_t *query)
+{
+	if (query->owns_emails) {
+		str_array_free(&query->settings.emails);
+		query->owns_emails = false;
+	}
+}
+
+static bool parse_format(const char *name, tur_output_t *mode)
+{
+	for (size_t i = 0; i < sizeof(formats) / sizeof(formats[0]); i++) {
+		if (strcasecmp(name, formats[i].name) == 0) {
+			*mode = formats[i].mode;
+			return true;
+		}
+	}
+	return false;
+}
+
+static bool parse_timestamp(const char *value, time_t *timestamp)
+{
+	char *end;
+	const long long parsed = strtoll(value, &end, 10);
+
+	if (end == value || *end != '\0' || parsed < 0) { return false; }
+	*timestamp = (time_t)parsed;
+	return true;
+}
+
+static bool parse_flag(const char *arg, settings_t *settings)
+{
+	if (strcmp(arg, "group") == 0) {
+		settings->grouped = true;
+	} else if (strcmp(arg, "diffs") == 0) {
+		settings->show_diffs = true;
+	} else if (strcmp(arg, "message") == 0) {
+		settings->print_msg = true;
+	} else if (strcmp(arg, "date-only") == 0) {
+		settings->date_only = true;
+	} else {
+		return false;
+	}
+	return true;
+}
+
+bool parse_query(char *request, query_t *query, char *error, size_t size)
+{
+	char *save = NULL;
+
+	for (char *arg = strtok_r(request, " \t\r", &save); arg;
+		 arg = strtok_r(NULL, " \t\r", &save)) {
+		char *value = strchr(arg, '=');
+		bool valid;
+
+		if (!value) {
+			valid = parse_flag(arg, &query->settings);
+		} else {
+			*value++ = '\0';
+			if (strcmp(arg, "emails") == 0) {
+				if (query->owns_emails) { str_array_free(&query->settings.emails); }
+				query->settings.emails = parse_emails(value);
+				query->owns_emails = query->settings.emails != NULL;
+				valid = query->owns_emails;
+			} else if (strcmp(arg, "format") == 0) {
+				valid = parse_format(value, &query->settings.output_mode);
+			} else if (strcmp(arg, "since") == 0) {
+				valid = parse_timestamp(value, &query->since);
+			} else if (strcmp(arg, "until") == 0) {
+				valid = parse_timestamp(value, &query->until);
+			} else if (strcmp(arg, "sort") == 0) {
+				valid = parse_sort_order(value, strlen(value), &query->settings.sort_order) == OK;
+				if (valid) { query->settings.sorted = true; }
+			} else {
+				valid = false;
+			}
+		}
+
+		if (!valid) {
+			(void)snprintf(error, size, "invalid argument `%s%s%s`",
+						   arg, value ? "=" : "", value ? value : "");
+			return false;
+		}
+	}
+
+	if (!query->settings.emails || query->settings.emails->len == 0) {
+		(void)snprintf(error, size, "no emails: pass `emails=...` or start tur with -e");
+		return false;
+	}
+	return true;
+}
+
+uint32_t *select_rows(const work_history_t *history, responsability_t resp,
+					  const query_t *query, size_t *n_rows)
+{
+	const commit_table_t *commits = &history->commits;
+	uint32_t *rows = tur_malloc((commits->len ? commits->len : 1) * sizeof(uint32_t));
+	size_t n = 0;
+
+	if (!rows) { return NULL; }
+
+	for (uint32_t row = 0; row < commits->len; row++) {
+		const time_t date = commits->dates[row];
+		if (commits->responsabilities[row] != resp) { continue; }
+		if (date < query->since || (query->until && date >= query->until)) { continue; }
+		rows[n++] = row;
+	}
+	if (query->settings.sorted) {
+		(void)sort_rows_by_date(rows, n, commits->dates, query->settings.sort_order);
+	}
+
+	*n_rows = n;
+	return rows;
+}
+
+bool read_request(int fd, char *buf, size_t size, bool (*stopping)(void))
+{
+	size_t len = 0;
+
+	while (len < size - 1) {
+		const ssize_t n = read(fd, buf + len, size - 1 - len);
+		if (n < 0 && errno == EINTR && !(stopping && stopping())) { continue; }
+		if (n <= 0) { break; }
+
+		char *newline = memchr(buf + len, '\n', (size_t)n);
+		len += (size_t)n;
+		if (newline) {
+			len = (size_t)(newline - buf);
+			break;
+		}
+	}
+
+	buf[len] = '\0';
+	return len > 0 && len < size - 1;
+}
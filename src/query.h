@@ -0,0 +1,70 @@
+/* query.h
+ * -----------------------------------------------------------------------
+ * Copyright (C) 2025  Matteo Nicoli
+ *
+ * This file is part of TUR.
+ *
+ * TUR is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __QUERY_H__
+#define __QUERY_H__
+
+#include "commit.h"
+#include "settings.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+/* Queries of --serve (see serve.h). A request is a single line of space
+ * separated arguments:
+ *     - emails=a@b.c,d@e.f   the authors, instead of the ones given with -e;
+ *     - format=NAME          text, tex, html, md, json, ndjson, csv, tsv or turc;
+ *     - since=T, until=T     commits dated in [since, until), in Unix time;
+ *     - sort=asc|desc        sort the commits by date;
+ *     - group, diffs, message, date-only, as -g, -d, -m and --date-only. */
+
+typedef struct {
+	/* The options given to tur, overridden by the arguments of the query */
+	settings_t settings;
+	bool owns_emails;
+	/* Commits dated in [since, until); until = 0 has no upper bound */
+	time_t since;
+	time_t until;
+} query_t;
+
+/* A query with the options of tur, before its arguments are parsed */
+void query_init(query_t *query, const settings_t *settings);
+void query_free(query_t *query);
+
+/* Reads the request line from `fd`, up to its newline or to the end of the
+ * stream. It fails on an empty request, or on one that does not fit in
+ * `size` - 1 bytes. `stopping`, which may be NULL, tells whether a read
+ * interrupted by a signal must give up. */
+bool read_request(int fd, char *buf, size_t size, bool (*stopping)(void));
+
+/* Parses the request line in place. On error, it writes the reason into
+ * `error` and returns false. */
+bool parse_query(char *request, query_t *query, char *error, size_t size);
+
+/* Row ids of the commits of the query with the given responsability, in
+ * the order of the walk or sorted by date. The array must be freed with
+ * tur_free. */
+uint32_t *select_rows(const work_history_t *history, responsability_t resp,
+					  const query_t *query, size_t *n_rows);
+
+#endif /* __QUERY_H__ */
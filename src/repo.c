@@ -19,6 +19,7 @@
  * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
  */
 
+#include "alloc.h"
 #include "codes.h"
 #include "log.h"
 #include "repo.h"
@@ -51,6 +52,20 @@ static repository_t init_repo(str_t path, unsigned id)
 	};
 }
 
+static void free_repo(void *r)
+{
+	repository_t *repo = (repository_t *)r;
+	str_free(repo->url);
+	str_free(repo->path);
+	str_free(repo->name);
+	if (repo->history) {
+		history_free(&repo->history);
+	}
+	if (repo->branches) {
+		str_array_free(&repo->branches);
+	}
+}
+
 static fmt_commit_url select_function(str_t url)
 {
 	if (str_contains_chars(url, "github.com")) { return &get_github_commit_url; }
@@ -62,7 +77,7 @@ static str_array_t *get_branches(const char *line, size_t len)
 {
 	str_array_t *result = NULL;
 
-	char *to_parse = malloc(len + 1);
+	char *to_parse = tur_malloc(len + 1);
 	if (!to_parse) {
 		(void)log_err("get_branches: cannot allocate to_parse string\n");
 		exit(1);
@@ -80,24 +95,50 @@ static str_array_t *get_branches(const char *line, size_t len)
 			(void)log_err("get_branches: an error occurred while adding a "
 						  "branch in branches array...");
 			str_array_free(&result);
-			free(to_parse);
+			tur_free(to_parse);
 			return NULL;
 		}
 		str_free(branch_str);
 		token = strtok(NULL, ",");
 	}
 
-	free(to_parse);
+	tur_free(to_parse);
 	return result;
 }
 
+/* Parses the trailing budget of an entry, e.g. `{time=60,commits=100000}`,
+ * and returns the length of the line without it */
+static ssize_t parse_entry_budget(const char *line, ssize_t len, walk_budget_t *budget)
+{
+	ssize_t open = len - 1;
+
+	if (len == 0 || line[len - 1] != '}') { return len; }
+
+	while (open >= 0 && line[open] != '{') { open--; }
+	if (open < 0) { return len; }
+
+	if (parse_budget(budget, line + open + 1, (size_t)(len - open - 2)) != OK) {
+		(void)log_err("Invalid budget `%.*s`: it has been ignored\n",
+					  (int)(len - open), line + open);
+	}
+
+	while (open > 0 && isspace((unsigned char)line[open - 1])) { open--; }
+	return open;
+}
+
 repository_t parse_repository(const char *line, ssize_t len, unsigned id)
 {
 	repository_t repo = { 0 };
-	const char *bracket_open = strchr(line, '[');
+	walk_budget_t budget = { 0 };
+
+	len = parse_entry_budget(line, (ssize_t)strnlen(line, (size_t)len), &budget);
+
+	const char *bracket_open = memchr(line, '[', (size_t)len);
 	
 	if (bracket_open == NULL) {
-		return init_repo(str_init(line, len), id);
+		repo = init_repo(str_init(line, len), id);
+		repo.budget = budget;
+		return repo;
 	}
 
 	size_t path_and_banches_len = bracket_open - line;
@@ -123,6 +164,7 @@ repository_t parse_repository(const char *line, ssize_t len, unsigned id)
 	repo.branches = branches_str
 					? get_branches(branches_str, branches_len)
 					: NULL;
+	repo.budget = budget;
 
 	int nesting = 1;
 	const char *bracket_close = NULL;
@@ -158,6 +200,7 @@ repository_t parse_repository(const char *line, ssize_t len, unsigned id)
 	}
 	repo.format = (fmt_t) {
 		.commit_url = select_function(repo.url),
+		.commit_path = get_commit_path(repo.url),
 	};
 
 	return repo;
@@ -188,7 +231,9 @@ return_code_t get_repos_array(repository_array_t *repos, const settings_t *setti
 		if (*trimmed == '\0') { continue; } 
 
 		repository_t repo = parse_repository(line, read, id);
+		/* The array holds a copy */
 		ret = repo_array_add(repos, &repo);
+		free_repo(&repo);
 		if (ret != OK) {
 			(void)log_err("get_repos_array: cannot create a repository "
 						  "list [%d]\n", ret);
@@ -225,12 +270,13 @@ repository_stats_t get_repos_stats(const repository_array_t *repos)
 
 repository_t *repository_copy(const repository_t *src)
 {
-	repository_t *new = malloc(sizeof(repository_t));
+	repository_t *new = tur_malloc(sizeof(repository_t));
 	new->url = str_copy(src->url);
 	new->path = str_copy(src->path);
 	new->name = str_copy(src->name);
 	new->id = src->id;
 	new->format = src->format;
+	new->budget = src->budget;
 	new->branches = str_array_copy(src->branches);
 	new->history = history_copy(src->history);
 	return new;
@@ -243,7 +289,7 @@ static void assign_repo(void *src, void *elem)
 {
 	repository_t *repo = repository_copy((repository_t *)elem);
 	*(repository_t *)src = *repo;
-	free(repo);
+	tur_free(repo);
 }
 
 static int compare_repo(void *r1, void *r2)
@@ -255,20 +301,6 @@ static int compare_repo(void *r1, void *r2)
 		   : repo1->id != repo2->id;
 }
 
-static void free_repo(void *r)
-{
-	repository_t *repo = (repository_t *)r;
-	str_free(repo->url);
-	str_free(repo->path);
-	str_free(repo->name);
-	if (repo->history) {
-		history_free(&repo->history);
-	}
-	if (repo->branches) {
-		str_array_free(&repo->branches);
-	}
-}
-
 void repo_array_init(repository_array_t **arr)
 {
 	array_init(arr, sizeof(repository_t));
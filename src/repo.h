@@ -34,6 +34,9 @@ typedef str_t (*fmt_commit_url) (str_t, str_t);
 
 typedef struct {
 	fmt_commit_url commit_url;
+	/* Provider specific path between the repository URL and the commit hash,
+	 * used by the renderers to build URLs without allocating */
+	str_t commit_path;
 } fmt_t;
 
 typedef struct {
@@ -43,6 +46,8 @@ typedef struct {
 	str_t name;
 	str_array_t *branches;
 	fmt_t format;
+	/* Trailing `{...}` of the .rlist entry; zero fields are not set */
+	walk_budget_t budget;
 	work_history_t *history;
 } repository_t;
 
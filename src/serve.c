@@ -0,0 +1,611 @@
+/* serve.c
+ * -----------------------------------------------------------------------
+ * Copyright (C) 2025  Matteo Nicoli
+ *
+ * This file is part of TUR.
+ *
+ * TUR is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "alloc.h"
+#include "codes.h"
+#include "commit.h"
+#include "log.h"
+#include "profile.h"
+#include "query.h"
+#include "repo.h"
+#include "serve.h"
+#include "settings.h"
+#include "sink.h"
+#include "str.h"
+#include "utils.h"
+#include "walk.h"
+
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+#include <git2.h>
+
+/* How often the accept loop checks for SIGINT and SIGTERM */
+#define SERVE_TICK_MS 500
+/* A client has this long for each read of its request and for each write
+ * of the reply */
+#define SERVE_IO_TIMEOUT_S 2
+#define SERVE_BACKLOG 16
+#define SERVE_ERROR_SIZE 256
+#define FNV_OFFSET 14695981039346656037ull
+#define FNV_PRIME 1099511628211ull
+
+typedef struct {
+	/* Emails of the walk, joined by commas */
+	char *emails;
+	work_history_t *history;
+	uint64_t last_used;
+} served_history_t;
+
+typedef struct {
+	git_repository *git;
+	/* Fingerprint of the refs the histories have been walked from */
+	uint64_t refs;
+	served_history_t histories[SERVE_MAX_HISTORIES];
+	size_t n_histories;
+	/* A walk failed on these refs: the repository is not walked again
+	 * until they change */
+	bool failed;
+} served_repo_t;
+
+/* History of a repository for a query */
+typedef struct {
+	/* NULL if the repository cannot be walked */
+	const work_history_t *history;
+	/* Walked for the query and not kept: released after the reply */
+	work_history_t *walked;
+	/* No warm history: the repository is walked for the query */
+	bool cold;
+} query_history_t;
+
+/* Cold walks of a query: the walking threads take the next cold
+ * repository until there is none left */
+typedef struct {
+	served_repo_t *served;
+	const repository_array_t *repos;
+	const query_t *query;
+	query_history_t *histories;
+	size_t next;
+	pthread_mutex_t lock;
+} cold_walks_t;
+
+/* Set from the signal handler: lock-free atomics are async-signal-safe */
+static int stop_requested = 0;
+static size_t n_queries = 0;
+
+static void request_stop(int signal)
+{
+	const int saved_errno = errno;
+	(void)signal;
+	__atomic_store_n(&stop_requested, 1, __ATOMIC_RELAXED);
+	errno = saved_errno;
+}
+
+static bool stopping(void)
+{
+	return __atomic_load_n(&stop_requested, __ATOMIC_RELAXED);
+}
+
+static uint64_t fnv1a(uint64_t hash, const void *data, size_t len)
+{
+	const unsigned char *bytes = data;
+	for (size_t i = 0; i < len; i++) {
+		hash = (hash ^ bytes[i]) * FNV_PRIME;
+	}
+	return hash;
+}
+
+/* The hashes of the refs are summed, so that the fingerprint does not
+ * depend on the order of the iteration. Symbolic refs only count through
+ * their name, HEAD through the commit it resolves to. */
+static bool refs_fingerprint(git_repository *git, uint64_t *fingerprint)
+{
+	git_reference_iterator *iter = NULL;
+	git_reference *ref = NULL;
+	git_oid head;
+	uint64_t sum = 0;
+
+	if (git_reference_iterator_new(&iter, git) != 0) { return false; }
+	while (git_reference_next(&ref, iter) == 0) {
+		const char *name = git_reference_name(ref);
+		const git_oid *target = git_reference_target(ref);
+		uint64_t hash = fnv1a(FNV_OFFSET, name, strlen(name) + 1);
+		if (target) {
+			hash = fnv1a(hash, target->id, sizeof(target->id));
+		}
+		sum += hash;
+		git_reference_free(ref);
+	}
+	git_reference_iterator_free(iter);
+
+	if (git_reference_name_to_id(&head, git, "HEAD") == 0) {
+		sum += fnv1a(FNV_OFFSET, head.id, sizeof(head.id));
+	}
+	*fingerprint = sum;
+	return true;
+}
+
+static char *join_emails(const str_array_t *emails)
+{
+	size_t len = 0, used = 0;
+
+	for (size_t i = 0; i < emails->len; i++) {
+		len += str_array_get(emails, i).len + 1;
+	}
+
+	char *joined = tur_malloc(len + 1);
+	if (!joined) { return NULL; }
+
+	for (size_t i = 0; i < emails->len; i++) {
+		const str_t email = str_array_get(emails, i);
+		if (i > 0) { joined[used++] = ','; }
+		memcpy(joined + used, email.val, email.len);
+		used += email.len;
+	}
+	joined[used] = '\0';
+	return joined;
+}
+
+static void drop_history(served_history_t *slot)
+{
+	tur_free(slot->emails);
+	history_free(&slot->history);
+	*slot = (served_history_t) { 0 };
+}
+
+static void drop_histories(served_repo_t *served)
+{
+	for (size_t i = 0; i < served->n_histories; i++) {
+		drop_history(served->histories + i);
+	}
+	served->n_histories = 0;
+}
+
+/* Slot for a new history: a free one, or the least recently used */
+static served_history_t *history_slot(served_repo_t *served)
+{
+	served_history_t *slot = served->histories;
+
+	if (served->n_histories < SERVE_MAX_HISTORIES) {
+		return served->histories + served->n_histories++;
+	}
+	for (size_t i = 1; i < SERVE_MAX_HISTORIES; i++) {
+		if (served->histories[i].last_used < slot->last_used) {
+			slot = served->histories + i;
+		}
+	}
+	drop_history(slot);
+	return slot;
+}
+
+/* Looks for the history of `repo` for the emails of the query. False when
+ * the repository has to be walked: there is no history for these emails,
+ * or its refs moved since the walk (or since a walk failed). Otherwise
+ * `history` is the cached one, or NULL if the repository cannot be walked. */
+static bool find_history(served_repo_t *served, const repository_t *repo, const char *emails,
+						 const work_history_t **history)
+{
+	uint64_t refs;
+
+	*history = NULL;
+	if (!served->git && git_repository_open(&served->git, repo->path.val) != 0) {
+		(void)log_err("serve: cannot open repository `%s`\n", repo->path.val);
+		served->git = NULL;
+		return true;
+	}
+	if (!refs_fingerprint(served->git, &refs)) {
+		(void)log_err("serve: cannot read the refs of `%s`\n", repo->path.val);
+		return true;
+	}
+	if (refs != served->refs) {
+		drop_histories(served);
+		served->refs = refs;
+		served->failed = false;
+	}
+	if (served->failed) { return true; }
+
+	for (size_t i = 0; i < served->n_histories; i++) {
+		if (strcmp(served->histories[i].emails, emails) == 0) {
+			served->histories[i].last_used = n_queries;
+			*history = served->histories[i].history;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/* Keeps the history walked for a query. A walk cut by the time budget is
+ * not kept: it would stand for the repository until its refs change, so
+ * the next query walks it again. */
+static void keep_history(served_repo_t *served, const repository_t *repo, const char *emails,
+						 query_history_t *result)
+{
+	result->history = result->walked;
+	if (!result->walked) {
+		(void)log_err("serve: cannot walk `%s`, it will be walked again when its refs "
+					  "change\n", repo->path.val);
+		served->failed = true;
+		return;
+	}
+	if (result->walked->truncated == TRUNCATED_TIME) {
+		(void)log_info("serve: the walk of `%s` ran out of time, it will be walked again "
+					   "by the next query\n", repo->path.val);
+		return;
+	}
+
+	char *key = tur_malloc(strlen(emails) + 1);
+	if (!key) { return; }
+	memcpy(key, emails, strlen(emails) + 1);
+	*history_slot(served) = (served_history_t) {
+		.emails = key,
+		.history = result->walked,
+		.last_used = n_queries
+	};
+	result->walked = NULL;
+}
+
+static void *walk_cold_histories(void *arg)
+{
+	cold_walks_t *walks = arg;
+	const size_t n_repos = walks->repos->len;
+
+	while (1) {
+		pthread_mutex_lock(&walks->lock);
+		while (walks->next < n_repos && !walks->histories[walks->next].cold) {
+			walks->next++;
+		}
+		const size_t i = walks->next++;
+		pthread_mutex_unlock(&walks->lock);
+
+		if (i >= n_repos) { break; }
+		if (stopping()) {
+			walks->histories[i].cold = false;
+			continue;
+		}
+
+		const repository_t *repo = repo_array_get(walks->repos, i);
+		const settings_t *settings = &walks->query->settings;
+		const walk_budget_t budget = merge_budgets(&settings->budget, &repo->budget);
+		walks->histories[i].walked = get_repository_history(walks->served[i].git, repo->path,
+															repo->branches, settings,
+															&budget, NULL);
+	}
+
+	return NULL;
+}
+
+/* Fills `histories` with the history of every repository for the emails of
+ * the query. The repositories without a warm history are walked in
+ * parallel, by up to -j threads including the calling one; each open
+ * repository is only used by the thread walking it. */
+static void get_histories(served_repo_t *served, const repository_array_t *repos,
+						  const query_t *query, const char *emails, query_history_t *histories)
+{
+	cold_walks_t walks = {
+		.served = served,
+		.repos = repos,
+		.query = query,
+		.histories = histories
+	};
+	pthread_t threads[MAX_THREADS];
+	size_t n_cold = 0, started = 0;
+
+	for (size_t i = 0; i < repos->len; i++) {
+		histories[i] = (query_history_t) { 0 };
+		histories[i].cold = !find_history(served + i, repo_array_get(repos, i), emails,
+										  &histories[i].history);
+		n_cold += histories[i].cold;
+	}
+	if (n_cold == 0) { return; }
+
+	size_t n_threads = query->settings.n_threads < n_cold ? query->settings.n_threads : n_cold;
+	if (n_threads > MAX_THREADS) { n_threads = MAX_THREADS; }
+
+	pthread_mutex_init(&walks.lock, NULL);
+	for (; started + 1 < n_threads; started++) {
+		if (pthread_create(threads + started, NULL, walk_cold_histories, &walks) != 0) {
+			(void)log_err("serve: cannot create walk thread #%zu\n", started);
+			break;
+		}
+	}
+	(void)walk_cold_histories(&walks);
+	for (size_t i = 0; i < started; i++) {
+		pthread_join(threads[i], NULL);
+	}
+	pthread_mutex_destroy(&walks.lock);
+
+	for (size_t i = 0; i < repos->len; i++) {
+		if (histories[i].cold) {
+			keep_history(served + i, repo_array_get(repos, i), emails, histories + i);
+		}
+	}
+}
+
+static void release_histories(query_history_t *histories, size_t n_repos)
+{
+	for (size_t i = 0; histories && i < n_repos; i++) {
+		history_free(&histories[i].walked);
+	}
+	tur_free(histories);
+}
+
+static void reply_error(int client, const char *reason)
+{
+	sink_t reply;
+
+	if (sink_init_fd(&reply, client) != OK) { return; }
+	sink_printf(&reply, "ERR %s\n", reason);
+	(void)sink_close(&reply);
+}
+
+/* The output is rendered from views of the histories of the query: they
+ * share the commit tables, and only have their own indexes, restricted to
+ * the dates of the query. A repository that cannot be walked is rendered
+ * empty and listed in the status line. */
+static void answer_query(int client, served_repo_t *served, const repository_array_t *repos,
+						 const query_t *query, repository_stats_t stats)
+{
+	const size_t n_repos = repos->len;
+	repository_t *views = tur_calloc(n_repos ? n_repos : 1, sizeof(repository_t));
+	work_history_t *histories = tur_calloc(n_repos ? n_repos : 1, sizeof(work_history_t));
+	bool *failed = tur_calloc(n_repos ? n_repos : 1, sizeof(bool));
+	query_history_t *found = tur_calloc(n_repos ? n_repos : 1, sizeof(query_history_t));
+	char *emails = join_emails(query->settings.emails);
+	sink_t body, reply;
+
+	if (!views || !histories || !failed || !found || !emails
+		|| sink_init_memory(&body) != OK) {
+		reply_error(client, "out of memory");
+		goto cleanup;
+	}
+
+	get_histories(served, repos, query, emails, found);
+	for (size_t i = 0; i < n_repos; i++) {
+		const repository_t *repo = repo_array_get(repos, i);
+		const work_history_t *history = found[i].history;
+
+		views[i] = *repo;
+		views[i].history = histories + i;
+		if (!history) {
+			failed[i] = true;
+			continue;
+		}
+		histories[i] = *history;
+		histories[i].indexes.authored = select_rows(history, AUTHORED, query,
+													&histories[i].n_authored);
+		histories[i].indexes.co_authored = select_rows(history, CO_AUTHORED, query,
+													   &histories[i].n_co_authored);
+		if (!histories[i].indexes.authored || !histories[i].indexes.co_authored) {
+			histories[i].n_authored = histories[i].n_co_authored = 0;
+		}
+	}
+
+	const array_t view = {
+		.values = views,
+		.len = n_repos,
+		.capacity = n_repos,
+		.element_size = sizeof(repository_t)
+	};
+	render_output(&body, &view, &query->settings, stats, NULL);
+
+	if (body.ret != OK) {
+		reply_error(client, "cannot render the output");
+	} else if (sink_init_fd(&reply, client) == OK) {
+		sink_printf(&reply, "OK %zu", body.len);
+		for (size_t i = 0, n = 0; i < n_repos; i++) {
+			if (failed[i]) {
+				sink_printf(&reply, "%s%u", n++ ? "," : " failed=", views[i].id);
+			}
+		}
+		sink_putc(&reply, '\n');
+		sink_write(&reply, body.buf, body.len);
+		if (sink_close(&reply) != OK) {
+			(void)log_err("serve: cannot send the reply of query #%zu\n", n_queries);
+		}
+	}
+	(void)sink_close(&body);
+
+cleanup:
+	for (size_t i = 0; histories && i < n_repos; i++) {
+		tur_free(histories[i].indexes.authored);
+		tur_free(histories[i].indexes.co_authored);
+	}
+	tur_free(histories);
+	release_histories(found, n_repos);
+	tur_free(failed);
+	tur_free(views);
+	tur_free(emails);
+}
+
+/* A socket left behind by a server that is gone refuses connections */
+static bool remove_stale_socket(const struct sockaddr_un *addr)
+{
+	struct stat st;
+	bool stale;
+
+	if (stat(addr->sun_path, &st) != 0 || !S_ISSOCK(st.st_mode)) { return false; }
+
+	const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (fd < 0) { return false; }
+	stale = connect(fd, (const struct sockaddr *)addr, sizeof(*addr)) != 0
+			&& errno == ECONNREFUSED;
+	close(fd);
+
+	return stale && unlink(addr->sun_path) == 0;
+}
+
+static int open_socket(const char *path)
+{
+	struct sockaddr_un addr = { .sun_family = AF_UNIX };
+	const size_t len = strlen(path);
+
+	if (len >= sizeof(addr.sun_path)) {
+		(void)log_err("serve: socket path too long: %s\n", path);
+		return -1;
+	}
+	memcpy(addr.sun_path, path, len + 1);
+
+	const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (fd < 0) {
+		(void)log_err("serve: cannot create a socket: %s\n", strerror(errno));
+		return -1;
+	}
+
+	if (bind(fd, (const struct sockaddr *)&addr, sizeof(addr)) != 0
+		&& !(errno == EADDRINUSE && remove_stale_socket(&addr)
+			 && bind(fd, (const struct sockaddr *)&addr, sizeof(addr)) == 0)) {
+		(void)log_err("serve: cannot bind `%s`: %s\n", path, strerror(errno));
+		close(fd);
+		return -1;
+	}
+	/* Queries are answered with the commits of every repository: only the
+	 * owner can connect */
+	if (chmod(path, 0600) != 0 || listen(fd, SERVE_BACKLOG) != 0) {
+		(void)log_err("serve: cannot listen on `%s`: %s\n", path, strerror(errno));
+		close(fd);
+		(void)unlink(path);
+		return -1;
+	}
+
+	return fd;
+}
+
+static void serve_client(int client, served_repo_t *served, const repository_array_t *repos,
+						 const settings_t *settings, repository_stats_t stats)
+{
+	const struct timeval timeout = { .tv_sec = SERVE_IO_TIMEOUT_S };
+	char request[SERVE_REQUEST_MAX];
+	char line[SERVE_REQUEST_MAX];
+	char error[SERVE_ERROR_SIZE];
+	query_t query;
+	const uint64_t start = profile_clock();
+
+	query_init(&query, settings);
+
+	(void)setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+	(void)setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+	if (!read_request(client, request, sizeof(request), stopping)) {
+		reply_error(client, "cannot read the request");
+		return;
+	}
+	/* The request is parsed in place */
+	memcpy(line, request, sizeof(request));
+
+	if (!parse_query(request, &query, error, sizeof(error))) {
+		(void)log_err("query #%zu rejected, %s: %s\n", n_queries, error, line);
+		reply_error(client, error);
+	} else {
+		answer_query(client, served, repos, &query, stats);
+		(void)log_info("query #%zu answered in %.3f ms: %s\n", n_queries,
+					   (double)(profile_clock() - start) / 1e6, line);
+	}
+
+	query_free(&query);
+}
+
+return_code_t serve_queries(repository_array_t *repos, const settings_t *settings,
+							repository_stats_t stats)
+{
+	struct sigaction action = { 0 }, ignore = { 0 };
+	struct sigaction previous_int, previous_term, previous_pipe;
+	/* The memory of every query would never be given back: it is only
+	 * released at exit */
+	if (alloc_backend() == BACKEND_ARENA) {
+		(void)log_err("serve: the arena allocator cannot be used with --serve, "
+					  "unset TUR_ALLOC or set it to libc or count\n");
+		return UNSUPPORTED_VALUE;
+	}
+
+	served_repo_t *served = tur_calloc(repos->len ? repos->len : 1, sizeof(served_repo_t));
+	if (!served) { return RUNTIME_MALLOC_ERROR; }
+
+	const int listener = open_socket(settings->serve_path.val);
+	if (listener < 0) {
+		tur_free(served);
+		return CANNOT_OPEN_SOCKET;
+	}
+
+	/* No SA_RESTART: the signals must wake up poll */
+	__atomic_store_n(&stop_requested, 0, __ATOMIC_RELAXED);
+	action.sa_handler = request_stop;
+	sigemptyset(&action.sa_mask);
+	(void)sigaction(SIGINT, &action, &previous_int);
+	(void)sigaction(SIGTERM, &action, &previous_term);
+	/* A client that goes away must not kill the server */
+	ignore.sa_handler = SIG_IGN;
+	sigemptyset(&ignore.sa_mask);
+	(void)sigaction(SIGPIPE, &ignore, &previous_pipe);
+
+	/* Open and walk every repository for the emails given with -e, so that
+	 * the first queries find warm histories */
+	if (settings->emails && settings->emails->len > 0) {
+		const query_t warm_up = { .settings = *settings };
+		char *emails = join_emails(settings->emails);
+		query_history_t *found = tur_calloc(repos->len ? repos->len : 1, sizeof(query_history_t));
+		if (emails && found) {
+			get_histories(served, repos, &warm_up, emails, found);
+		}
+		release_histories(found, repos->len);
+		tur_free(emails);
+	}
+	(void)log_info("serving %zu repositories on `%s`...\n",
+				   repos->len, settings->serve_path.val);
+
+	while (!stopping()) {
+		struct pollfd listening = { .fd = listener, .events = POLLIN };
+		if (poll(&listening, 1, SERVE_TICK_MS) <= 0) { continue; }
+
+		const int client = accept(listener, NULL, NULL);
+		if (client < 0) { continue; }
+		n_queries++;
+		serve_client(client, served, repos, settings, stats);
+		close(client);
+	}
+
+	(void)sigaction(SIGINT, &previous_int, NULL);
+	(void)sigaction(SIGTERM, &previous_term, NULL);
+	(void)sigaction(SIGPIPE, &previous_pipe, NULL);
+	close(listener);
+	(void)unlink(settings->serve_path.val);
+
+	for (size_t i = 0; i < repos->len; i++) {
+		drop_histories(served + i);
+		git_repository_free(served[i].git);
+	}
+	tur_free(served);
+
+	(void)log_info("%zu queries served\n", n_queries);
+	return OK;
+}
@@ -0,0 +1,50 @@
+/* serve.h
+ * -----------------------------------------------------------------------
+ * Copyright (C) 2025  Matteo Nicoli
+ *
+ * This file is part of TUR.
+ *
+ * TUR is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __SERVE_H__
+#define __SERVE_H__
+
+#include "codes.h"
+#include "repo.h"
+#include "settings.h"
+
+/* --serve: long-running mode answering queries over a Unix domain socket.
+ * The repositories of the .rlist stay open, and the history walked for a
+ * set of emails is kept until the refs of its repository change (unless
+ * the time budget cut it short), so a query that hits the warm histories
+ * costs a filter and a render. Cold repositories are walked with -j
+ * threads.
+ *
+ * A client sends a single line of space separated arguments (see
+ * query.h), e.g.
+ *     emails=me@example.com format=json since=1735689600 group sort=desc
+ * and reads `OK <bytes>\n` followed by the output, or `ERR <reason>\n`. */
+
+#define SERVE_REQUEST_MAX 4096
+/* Histories kept for each repository, one per set of emails: the least
+ * recently used one is dropped first */
+#define SERVE_MAX_HISTORIES 8
+
+/* Serves until SIGINT or SIGTERM, then removes the socket */
+return_code_t serve_queries(repository_array_t *repos, const settings_t *settings,
+							repository_stats_t stats);
+
+#endif /* __SERVE_H__ */
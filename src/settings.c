@@ -29,6 +29,8 @@
 
 #define DEFAULT_REPOS_LIST_PATH      ".rlist"
 #define DEFAULT_REPOS_LIST_PATH_SIZE 6
+#define DEFAULT_REFS_GLOB            "refs/heads/*"
+#define DEFAULT_REFS_GLOB_SIZE       12
 
 settings_t default_settings(void)
 {
@@ -42,6 +44,7 @@ settings_t default_settings(void)
 	return (settings_t) {
 		.output_mode = STDOUT,
 		.output = empty_str(),
+		.n_outputs = 0,
 		.clear_cache = false,
 		.no_cache = false,
 		.repos_path = str_init(DEFAULT_REPOS_LIST_PATH, DEFAULT_REPOS_LIST_PATH_SIZE),
@@ -53,11 +56,24 @@ settings_t default_settings(void)
 		.date_only = false,
 		.sort_order = ASC,
 		.n_threads = (size_t) num_cores,
+		.adaptive_threads = false,
 		.no_ansi = false,
 		.no_merge = false,
 		.title = empty_str(),
 		.interactive = false,
 		.editor = empty_str(),
 		.force = false,
+		.all_refs = false,
+		.refs_glob = str_init(DEFAULT_REFS_GLOB, DEFAULT_REFS_GLOB_SIZE),
+		.since = 0,
+		.mmap_output = false,
+		.stream_output = false,
+		.print_stats = false,
+		.profile_path = empty_str(),
+		.trace_path = empty_str(),
+		.metrics_path = empty_str(),
+		.progress = PROGRESS_OFF,
+		.budget = { 0 },
+		.serve_path = empty_str(),
 	};
 }
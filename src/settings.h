@@ -25,19 +25,58 @@
 #include "str.h"
 
 #include <stdbool.h>
+#include <time.h>
 
 typedef enum {
 	STDOUT = 0,
 	LATEX,
 	HTML,
-	JEKYLL
+	JEKYLL,
+	JSON,
+	NDJSON,
+	CSV,
+	TSV,
+	COLUMNAR
 } tur_output_t;
 
+/* Upper bound for -j */
+#define MAX_THREADS 512
+/* With -j auto, the controller can grow the pool up to this many threads
+ * per core: I/O bound walks (e.g. on NFS) benefit from more threads than
+ * cores */
+#define ADAPTIVE_THREADS_PER_CORE 4
+
+/* Maximum number of -o targets in a single run */
+#define MAX_OUTPUTS 8
+
+typedef struct {
+	str_t path;
+	tur_output_t mode;
+} output_target_t;
+
 typedef enum {
 	ASC = 0,
 	DESC
 } sort_ordering_t;
 
+typedef enum {
+	PROGRESS_OFF = 0,
+	PROGRESS_TEXT,
+	PROGRESS_JSON
+} progress_mode_t;
+
+/* A budget field set to this value lifts the limit (e.g. `time=0` in the
+ * .rlist overrides the global budget) */
+#define BUDGET_UNLIMITED ((size_t)-1)
+
+/* Limits of the walk of a repository. Zero means that the field is not
+ * set: the walk is unlimited, or the global budget applies. */
+typedef struct {
+	size_t max_seconds;
+	size_t max_commits;
+	size_t max_diffs;
+} walk_budget_t;
+
 typedef struct {
 	bool show_diffs;
 	bool clear_cache;
@@ -46,18 +85,43 @@ typedef struct {
 	bool sorted;
 	sort_ordering_t sort_order;
 	str_array_t *emails;
+	/* Target being rendered: with many -o targets, each renderer gets a
+	 * copy of the settings pointing to its own target */
 	tur_output_t output_mode;
 	str_t output;
+	output_target_t outputs[MAX_OUTPUTS];
+	size_t n_outputs;
 	str_t repos_path;
 	bool print_msg;
 	bool date_only;
+	/* Threads of the pool; with adaptive_threads, the initial number of
+	 * active ones */
 	size_t n_threads;
+	bool adaptive_threads;
 	bool no_ansi;
 	bool no_merge;
 	str_t title;
 	bool interactive;
 	str_t editor;
 	bool force;
+	bool all_refs;
+	str_t refs_glob;
+	time_t since;
+	bool mmap_output;
+	bool stream_output;
+	/* --stats prints the profile of the run, --profile writes it as JSON */
+	bool print_stats;
+	str_t profile_path;
+	/* --trace: Chrome trace-event file of the thread spans */
+	str_t trace_path;
+	/* --metrics: OpenMetrics text file of the run */
+	str_t metrics_path;
+	/* --progress: periodic reports of the walk on stderr */
+	progress_mode_t progress;
+	/* --budget: limits of every walk, overridden by the .rlist entries */
+	walk_budget_t budget;
+	/* --serve: Unix socket of the query server */
+	str_t serve_path;
 } settings_t;
 
 settings_t default_settings(void);
@@ -0,0 +1,532 @@
+/* sink.c
+ * -----------------------------------------------------------------------
+ * Copyright (C) 2025  Matteo Nicoli
+ *
+ * This file is part of TUR.
+ *
+ * TUR is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "alloc.h"
+#include "codes.h"
+#include "log.h"
+#include "sink.h"
+#include "str.h"
+#include "utils.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+/* Appends at least this large are not copied into the buffer of a fd sink:
+ * they are written along with it by a single writev */
+#define SINK_DIRECT_THRESHOLD (SINK_BUFFER_SIZE / 2)
+#define UINT64_MAX_DIGITS 20
+#define ISO_DATE_LEN 20
+
+static const char hex_digits[] = "0123456789abcdef";
+
+/* For every byte: 0 if it is copied as is, the letter of its short escape,
+ * or 'u' for the \u00XX form */
+static const char json_escapes[256] = {
+	['\0'] = 'u', [0x01] = 'u', [0x02] = 'u', [0x03] = 'u',
+	[0x04] = 'u', [0x05] = 'u', [0x06] = 'u', [0x07] = 'u',
+	['\b'] = 'b', ['\t'] = 't', ['\n'] = 'n', [0x0B] = 'u',
+	['\f'] = 'f', ['\r'] = 'r', [0x0E] = 'u', [0x0F] = 'u',
+	[0x10] = 'u', [0x11] = 'u', [0x12] = 'u', [0x13] = 'u',
+	[0x14] = 'u', [0x15] = 'u', [0x16] = 'u', [0x17] = 'u',
+	[0x18] = 'u', [0x19] = 'u', [0x1A] = 'u', [0x1B] = 'u',
+	[0x1C] = 'u', [0x1D] = 'u', [0x1E] = 'u', [0x1F] = 'u',
+	['"'] = '"', ['\\'] = '\\',
+};
+
+static void sink_fail(sink_t *sink, return_code_t ret)
+{
+	if (sink->ret == OK) {
+		sink->ret = ret;
+	}
+}
+
+/* Writes every iovec, retrying on partial writes and on EINTR */
+static bool write_all(int fd, struct iovec *iov, int iovcnt)
+{
+	while (iovcnt > 0) {
+		const ssize_t written = writev(fd, iov, iovcnt);
+		if (written < 0) {
+			if (errno == EINTR) { continue; }
+			return false;
+		}
+
+		size_t left = (size_t)written;
+		while (iovcnt > 0 && left >= iov->iov_len) {
+			left -= iov->iov_len;
+			iov++;
+			iovcnt--;
+		}
+		if (iovcnt > 0) {
+			iov->iov_base = (char *)iov->iov_base + left;
+			iov->iov_len -= left;
+		}
+	}
+
+	return true;
+}
+
+static bool grow_heap(sink_t *sink, size_t needed)
+{
+	size_t capacity = sink->capacity ? sink->capacity : SINK_BUFFER_SIZE;
+	while (capacity - sink->len < needed) {
+		capacity *= 2;
+	}
+
+	char *buf = tur_realloc(sink->buf, capacity);
+	if (!buf) { return false; }
+	sink->buf = buf;
+	sink->capacity = capacity;
+	return true;
+}
+
+/* The file is extended and mapped again: appends keep going straight into
+ * the page cache */
+static bool grow_mapping(sink_t *sink, size_t needed)
+{
+	size_t capacity = sink->capacity;
+	while (capacity - sink->len < needed) {
+		capacity *= 2;
+	}
+
+	if (ftruncate(sink->fd, (off_t)capacity) != 0) { return false; }
+	if (munmap(sink->buf, sink->capacity) != 0) { return false; }
+	sink->buf = NULL;
+
+	void *map = mmap(NULL, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, sink->fd, 0);
+	if (map == MAP_FAILED) { return false; }
+	sink->buf = map;
+	sink->capacity = capacity;
+	return true;
+}
+
+/* Makes room for `needed` more bytes */
+static bool sink_ensure(sink_t *sink, size_t needed)
+{
+	if (sink->ret != OK) { return false; }
+	if (sink->capacity - sink->len >= needed) { return true; }
+
+	bool ok = true;
+	switch (sink->kind) {
+	case SINK_FD:
+		ok = sink_flush(sink) == OK;
+		if (ok && sink->capacity < needed) {
+			ok = grow_heap(sink, needed);
+		}
+		break;
+	case SINK_MMAP:
+		ok = grow_mapping(sink, needed);
+		break;
+	case SINK_MEMORY:
+		ok = grow_heap(sink, needed);
+		break;
+	}
+
+	if (!ok) {
+		(void)log_err("sink: cannot make room for %zu bytes of output\n", needed);
+		sink_fail(sink, sink->kind == SINK_FD ? CANNOT_WRITE_OUTPUT : RUNTIME_MALLOC_ERROR);
+	}
+	return ok;
+}
+
+return_code_t sink_init_fd(sink_t *sink, int fd)
+{
+	*sink = (sink_t) {
+		.kind = SINK_FD,
+		.fd = fd,
+		.buf = tur_malloc(SINK_BUFFER_SIZE),
+		.capacity = SINK_BUFFER_SIZE,
+	};
+	if (!sink->buf) {
+		sink->capacity = 0;
+		sink->ret = RUNTIME_MALLOC_ERROR;
+	}
+	return sink->ret;
+}
+
+return_code_t sink_init_file(sink_t *sink, const char *path, bool use_mmap)
+{
+	/* The mapping needs read access as well */
+	const int fd = open(path, (use_mmap ? O_RDWR : O_WRONLY) | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0) {
+		(void)log_err("sink_init_file: cannot open file: %s\n", path);
+		*sink = (sink_t) { .kind = SINK_FD, .fd = -1, .ret = CANNOT_OPEN_OUTPUT };
+		return CANNOT_OPEN_OUTPUT;
+	}
+
+	if (!use_mmap) {
+		return_code_t ret = sink_init_fd(sink, fd);
+		sink->owns_fd = true;
+		return ret;
+	}
+
+	*sink = (sink_t) {
+		.kind = SINK_MMAP,
+		.fd = fd,
+		.owns_fd = true,
+		.capacity = SINK_BUFFER_SIZE,
+	};
+
+	void *map = MAP_FAILED;
+	if (ftruncate(fd, SINK_BUFFER_SIZE) == 0) {
+		map = mmap(NULL, SINK_BUFFER_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	}
+	if (map == MAP_FAILED) {
+		(void)log_err("sink_init_file: cannot map file: %s\n", path);
+		close(fd);
+		*sink = (sink_t) { .kind = SINK_FD, .fd = -1, .ret = CANNOT_OPEN_OUTPUT };
+		return CANNOT_OPEN_OUTPUT;
+	}
+	sink->buf = map;
+
+	return OK;
+}
+
+return_code_t sink_init_memory(sink_t *sink)
+{
+	*sink = (sink_t) { .kind = SINK_MEMORY, .fd = -1 };
+	if (!grow_heap(sink, 1)) {
+		sink->ret = RUNTIME_MALLOC_ERROR;
+	}
+	return sink->ret;
+}
+
+return_code_t sink_flush(sink_t *sink)
+{
+	if (sink->ret != OK || sink->kind != SINK_FD || sink->len == 0) {
+		return sink->ret;
+	}
+
+	struct iovec iov = { .iov_base = sink->buf, .iov_len = sink->len };
+	if (!write_all(sink->fd, &iov, 1)) {
+		(void)log_err("sink_flush: cannot write the output\n");
+		sink_fail(sink, CANNOT_WRITE_OUTPUT);
+		return sink->ret;
+	}
+	sink->offset += sink->len;
+	sink->len = 0;
+
+	return OK;
+}
+
+return_code_t sink_close(sink_t *sink)
+{
+	(void)sink_flush(sink);
+
+	switch (sink->kind) {
+	case SINK_FD:
+		tur_free(sink->buf);
+		break;
+	case SINK_MMAP:
+		if (sink->buf) {
+			(void)munmap(sink->buf, sink->capacity);
+		}
+		/* Drops the unused tail of the last mapping */
+		if (ftruncate(sink->fd, (off_t)sink->len) != 0) {
+			sink_fail(sink, CANNOT_WRITE_OUTPUT);
+		}
+		break;
+	case SINK_MEMORY:
+		tur_free(sink->buf);
+		break;
+	}
+
+	if (sink->owns_fd && sink->fd >= 0 && close(sink->fd) != 0) {
+		sink_fail(sink, CANNOT_WRITE_OUTPUT);
+	}
+
+	sink->buf = NULL;
+	sink->capacity = 0;
+	return sink->ret;
+}
+
+size_t sink_size(const sink_t *sink)
+{
+	return sink->offset + sink->len;
+}
+
+char *sink_reserve(sink_t *sink, size_t len)
+{
+	if (!sink_ensure(sink, len)) { return NULL; }
+	return sink->buf + sink->len;
+}
+
+void sink_write(sink_t *sink, const char *data, size_t len)
+{
+	if (sink->ret != OK || len == 0) { return; }
+
+	if (sink->capacity - sink->len >= len) {
+		memcpy(sink->buf + sink->len, data, len);
+		sink->len += len;
+		return;
+	}
+
+	if (sink->kind == SINK_FD && len >= SINK_DIRECT_THRESHOLD) {
+		struct iovec iov[2] = {
+			{ .iov_base = sink->buf, .iov_len = sink->len },
+			{ .iov_base = (void *)data, .iov_len = len },
+		};
+		if (!write_all(sink->fd, iov, 2)) {
+			(void)log_err("sink_write: cannot write the output\n");
+			sink_fail(sink, CANNOT_WRITE_OUTPUT);
+			return;
+		}
+		sink->offset += sink->len + len;
+		sink->len = 0;
+		return;
+	}
+
+	if (!sink_ensure(sink, len)) { return; }
+	memcpy(sink->buf + sink->len, data, len);
+	sink->len += len;
+}
+
+void sink_put_uint(sink_t *sink, uint64_t value)
+{
+	char digits[UINT64_MAX_DIGITS];
+	size_t n = 0;
+
+	do {
+		digits[UINT64_MAX_DIGITS - ++n] = (char)('0' + value % 10);
+		value /= 10;
+	} while (value);
+
+	sink_write(sink, digits + UINT64_MAX_DIGITS - n, n);
+}
+
+void sink_put_int(sink_t *sink, int64_t value)
+{
+	if (value < 0) {
+		sink_putc(sink, '-');
+		sink_put_uint(sink, (uint64_t)0 - (uint64_t)value);
+		return;
+	}
+	sink_put_uint(sink, (uint64_t)value);
+}
+
+/* Length of the well-formed UTF-8 sequence at the start of `s` (RFC 3629:
+ * no overlong forms, surrogates or code points past U+10FFFF), 0 if the
+ * sequence is invalid or cut off */
+static size_t utf8_sequence_len(const unsigned char *s, size_t avail)
+{
+	unsigned char lo = 0x80, hi = 0xBF;
+	size_t len;
+
+	if (s[0] >= 0xC2 && s[0] <= 0xDF) {
+		len = 2;
+	} else if (s[0] >= 0xE0 && s[0] <= 0xEF) {
+		len = 3;
+		if (s[0] == 0xE0) { lo = 0xA0; }
+		if (s[0] == 0xED) { hi = 0x9F; }
+	} else if (s[0] >= 0xF0 && s[0] <= 0xF4) {
+		len = 4;
+		if (s[0] == 0xF0) { lo = 0x90; }
+		if (s[0] == 0xF4) { hi = 0x8F; }
+	} else {
+		return 0;
+	}
+
+	if (avail < len || s[1] < lo || s[1] > hi) { return 0; }
+	for (size_t i = 2; i < len; i++) {
+		if ((s[i] & 0xC0) != 0x80) { return 0; }
+	}
+	return len;
+}
+
+/* Bytes that are not part of a well-formed UTF-8 sequence (e.g. a message
+ * in a legacy encoding, or one cut in the middle of a character) are
+ * replaced one by one with U+FFFD, so the output is always valid JSON */
+void sink_put_json_str(sink_t *sink, str_t str)
+{
+	const unsigned char *s = (const unsigned char *)str.val;
+	size_t run = 0;
+
+	sink_putc(sink, '"');
+	for (size_t i = 0; i < str.len; i++) {
+		if (s[i] >= 0x80) {
+			const size_t len = utf8_sequence_len(s + i, str.len - i);
+			if (len) {
+				i += len - 1;
+				continue;
+			}
+			sink_write(sink, str.val + run, i - run);
+			run = i + 1;
+			sink_write(sink, "\\ufffd", 6);
+			continue;
+		}
+
+		const char escape = json_escapes[s[i]];
+		if (!escape) { continue; }
+
+		sink_write(sink, str.val + run, i - run);
+		run = i + 1;
+
+		char *out = sink_reserve(sink, 6);
+		if (!out) { return; }
+		out[0] = '\\';
+		if (escape != 'u') {
+			out[1] = escape;
+			sink_commit(sink, 2);
+			continue;
+		}
+		memcpy(out + 1, "u00", 3);
+		out[4] = hex_digits[s[i] >> 4];
+		out[5] = hex_digits[s[i] & 0x0F];
+		sink_commit(sink, 6);
+	}
+	sink_write(sink, str.val + run, str.len - run);
+	sink_putc(sink, '"');
+}
+
+void sink_put_csv_str(sink_t *sink, str_t str)
+{
+	const char *end = str.val + str.len;
+	const char *run = str.val;
+
+	sink_putc(sink, '"');
+	for (const char *quote; (quote = memchr(run, '"', (size_t)(end - run))); run = quote + 1) {
+		/* The quote is written twice: once with the run, once alone */
+		sink_write(sink, run, (size_t)(quote - run) + 1);
+		sink_putc(sink, '"');
+	}
+	sink_write(sink, run, (size_t)(end - run));
+	sink_putc(sink, '"');
+}
+
+void sink_put_tsv_str(sink_t *sink, str_t str)
+{
+	size_t run = 0;
+
+	for (size_t i = 0; i < str.len; i++) {
+		char escape;
+		switch (str.val[i]) {
+		case '\t': escape = 't'; break;
+		case '\n': escape = 'n'; break;
+		case '\r': escape = 'r'; break;
+		case '\\': escape = '\\'; break;
+		default: continue;
+		}
+
+		sink_write(sink, str.val + run, i - run);
+		run = i + 1;
+		sink_putc(sink, '\\');
+		sink_putc(sink, escape);
+	}
+	sink_write(sink, str.val + run, str.len - run);
+}
+
+void sink_put_hex(sink_t *sink, const uint8_t *bytes, size_t len)
+{
+	char *out = sink_reserve(sink, 2 * len);
+	if (!out) { return; }
+
+	for (size_t i = 0; i < len; i++) {
+		out[2 * i] = hex_digits[bytes[i] >> 4];
+		out[2 * i + 1] = hex_digits[bytes[i] & 0x0F];
+	}
+	sink_commit(sink, 2 * len);
+}
+
+void sink_put_date(sink_t *sink, time_t timestamp, bool date_only)
+{
+	char *out = sink_reserve(sink, DATE_BUF_SIZE);
+	if (!out) { return; }
+
+	sink_commit(sink, format_date_into(out, DATE_BUF_SIZE, timestamp, date_only));
+}
+
+static inline void put_two_digits(char *out, int value)
+{
+	out[0] = (char)('0' + value / 10);
+	out[1] = (char)('0' + value % 10);
+}
+
+void sink_put_iso_date(sink_t *sink, time_t timestamp)
+{
+	struct tm tm;
+
+	if (!gmtime_r(&timestamp, &tm) || tm.tm_year < -1900 || tm.tm_year > 9999 - 1900) {
+		/* Years outside 0-9999 have no four digits form: write the raw timestamp */
+		sink_printf(sink, "@%lld", (long long)timestamp);
+		return;
+	}
+
+	char *out = sink_reserve(sink, ISO_DATE_LEN);
+	if (!out) { return; }
+
+	const int year = tm.tm_year + 1900;
+	put_two_digits(out, year / 100);
+	put_two_digits(out + 2, year % 100);
+	out[4] = '-';
+	put_two_digits(out + 5, tm.tm_mon + 1);
+	out[7] = '-';
+	put_two_digits(out + 8, tm.tm_mday);
+	out[10] = 'T';
+	put_two_digits(out + 11, tm.tm_hour);
+	out[13] = ':';
+	put_two_digits(out + 14, tm.tm_min);
+	out[16] = ':';
+	put_two_digits(out + 17, tm.tm_sec);
+	out[19] = 'Z';
+	sink_commit(sink, ISO_DATE_LEN);
+}
+
+void sink_put_padded(sink_t *sink, str_t str, size_t width)
+{
+	sink_put_str(sink, str);
+	for (size_t i = str.len; i < width; i++) {
+		sink_putc(sink, ' ');
+	}
+}
+
+void sink_printf(sink_t *sink, const char *format, ...)
+{
+	va_list args, retry;
+
+	if (sink->ret != OK) { return; }
+
+	va_start(args, format);
+	va_copy(retry, args);
+	const int len = vsnprintf(sink->buf + sink->len, sink->capacity - sink->len, format, args);
+	va_end(args);
+
+	if (len >= 0 && (size_t)len >= sink->capacity - sink->len) {
+		/* Did not fit: vsnprintf needs room for the terminator too */
+		if (sink_ensure(sink, (size_t)len + 1)) {
+			(void)vsnprintf(sink->buf + sink->len, sink->capacity - sink->len, format, retry);
+		}
+	}
+	va_end(retry);
+
+	if (len < 0) {
+		sink_fail(sink, CANNOT_WRITE_OUTPUT);
+		return;
+	}
+	if (sink->ret == OK) {
+		sink->len += (size_t)len;
+	}
+}
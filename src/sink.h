@@ -0,0 +1,119 @@
+/* sink.h
+ * -----------------------------------------------------------------------
+ * Copyright (C) 2025  Matteo Nicoli
+ *
+ * This file is part of TUR.
+ *
+ * TUR is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __SINK_H__
+#define __SINK_H__
+
+#include "codes.h"
+#include "str.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#define SINK_BUFFER_SIZE (256 * 1024)
+
+typedef enum {
+	/* Buffered writes to a file descriptor; large appends bypass the
+	 * buffer and are written together with it by a single writev */
+	SINK_FD,
+	/* The output file is memory-mapped and appends are copied into it */
+	SINK_MMAP,
+	/* Appends grow a heap buffer, which is never written anywhere */
+	SINK_MEMORY,
+} sink_kind_t;
+
+/* Output sink used by the renderers. Appends go into `buf`: depending on
+ * the kind it is a user-space buffer, the mapped file or a growable heap
+ * buffer. Errors are sticky: after the first failure every append is a
+ * no-op, and the error is returned by sink_close. */
+typedef struct {
+	sink_kind_t kind;
+	int fd;
+	bool owns_fd;
+	char *buf;
+	size_t len;
+	size_t capacity;
+	/* Bytes already written to the fd or mapped before `buf` */
+	size_t offset;
+	return_code_t ret;
+} sink_t;
+
+return_code_t sink_init_fd(sink_t *sink, int fd);
+return_code_t sink_init_file(sink_t *sink, const char *path, bool use_mmap);
+return_code_t sink_init_memory(sink_t *sink);
+return_code_t sink_flush(sink_t *sink);
+return_code_t sink_close(sink_t *sink);
+/* Total bytes appended so far */
+size_t sink_size(const sink_t *sink);
+
+void sink_write(sink_t *sink, const char *data, size_t len);
+void sink_put_uint(sink_t *sink, uint64_t value);
+void sink_put_int(sink_t *sink, int64_t value);
+void sink_put_hex(sink_t *sink, const uint8_t *bytes, size_t len);
+void sink_put_date(sink_t *sink, time_t timestamp, bool date_only);
+/* UTC timestamp in the ISO 8601 form 2024-11-29T00:00:00Z */
+void sink_put_iso_date(sink_t *sink, time_t timestamp);
+void sink_put_padded(sink_t *sink, str_t str, size_t width);
+/* Appends `str` as a quoted JSON string. Runs of bytes that need no escape
+ * are copied as they are; bytes >= 0x80 are passed through untouched. */
+void sink_put_json_str(sink_t *sink, str_t str);
+/* Appends `str` as an RFC 4180 field: it is always quoted, so it can be
+ * written in one pass, doubling the quotes it contains. */
+void sink_put_csv_str(sink_t *sink, str_t str);
+/* Appends `str` as a TSV field, escaping backslashes, tabs and newlines
+ * with a backslash as PostgreSQL and DuckDB expect. */
+void sink_put_tsv_str(sink_t *sink, str_t str);
+void sink_printf(sink_t *sink, const char *format, ...)
+	__attribute__((format(printf, 2, 3)));
+
+/* Reserves `len` bytes at the end of the sink and returns a pointer to
+ * them, or NULL after an error. The caller commits what it wrote with
+ * sink_commit. */
+char *sink_reserve(sink_t *sink, size_t len);
+
+static inline void sink_commit(sink_t *sink, size_t len)
+{
+	sink->len += len;
+}
+
+static inline void sink_putc(sink_t *sink, char c)
+{
+	if (sink->len < sink->capacity) {
+		sink->buf[sink->len++] = c;
+		return;
+	}
+	sink_write(sink, &c, 1);
+}
+
+static inline void sink_puts(sink_t *sink, const char *s)
+{
+	sink_write(sink, s, strlen(s));
+}
+
+static inline void sink_put_str(sink_t *sink, str_t str)
+{
+	sink_write(sink, str.val, str.len);
+}
+
+#endif /* __SINK_H__ */
@@ -0,0 +1,168 @@
+/* sort.c
+ * -----------------------------------------------------------------------
+ * Copyright (C) 2025  Matteo Nicoli
+ *
+ * This file is part of TUR.
+ *
+ * TUR is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "alloc.h"
+#include "codes.h"
+#include "commit.h"
+#include "log.h"
+#include "settings.h"
+#include "sort.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define RADIX_BITS   8
+#define RADIX_SIZE   (1 << RADIX_BITS)
+#define RADIX_MASK   (RADIX_SIZE - 1)
+#define RADIX_PASSES (64 / RADIX_BITS)
+#define SIGN_BIT     ((uint64_t)1 << 63)
+/* Below this size an insertion sort beats the histogram passes */
+#define INSERTION_SORT_THRESHOLD 64
+
+typedef int (*ord_fn_t) (const void* a, const void* b);
+
+/* Keys and row ids are kept together, so every scatter moves a single
+ * 16 bytes record and never touches the commit table. */
+typedef struct {
+	uint64_t key;
+	uint32_t row;
+} sort_pair_t;
+
+/* qsort has no context argument: the comparators read the dates column of
+ * the table being sorted from here. */
+static _Thread_local const time_t *qsort_dates;
+
+static int order_by_date_asc(const void* a, const void* b)
+{
+	const time_t first = qsort_dates[*(const uint32_t *)a];
+	const time_t second = qsort_dates[*(const uint32_t *)b];
+
+	if (first == second) { return 0; }
+	return first < second ? -1 : 1;
+}
+
+static int order_by_date_desc(const void* a, const void* b)
+{
+	return -order_by_date_asc(a,b);
+}
+
+void sort_rows_by_date_qsort(uint32_t *rows, size_t n, const time_t *dates,
+							 sort_ordering_t order)
+{
+	ord_fn_t ord_fn = order == ASC
+					  ? order_by_date_asc
+					  : order_by_date_desc;
+	qsort_dates = dates;
+	qsort(rows, n, sizeof(uint32_t), ord_fn);
+	qsort_dates = NULL;
+}
+
+/* Maps a (signed) date to an unsigned key with the same ordering. For the
+ * descending order the key is complemented, so that equal dates still keep
+ * their relative order. */
+static inline uint64_t date_key(time_t date, sort_ordering_t order)
+{
+	uint64_t key = (uint64_t)(int64_t)date ^ SIGN_BIT;
+	return order == ASC ? key : ~key;
+}
+
+static void insertion_sort(uint32_t *rows, size_t n, const time_t *dates,
+						   sort_ordering_t order)
+{
+	for (size_t i = 1; i < n; i++) {
+		const uint32_t current = rows[i];
+		const uint64_t key = date_key(dates[current], order);
+		size_t j = i;
+		while (j > 0 && date_key(dates[rows[j - 1]], order) > key) {
+			rows[j] = rows[j - 1];
+			j--;
+		}
+		rows[j] = current;
+	}
+}
+
+return_code_t sort_rows_by_date(uint32_t *rows, size_t n, const time_t *dates,
+								sort_ordering_t order)
+{
+	size_t histograms[RADIX_PASSES][RADIX_SIZE] = { 0 };
+
+	if (n < INSERTION_SORT_THRESHOLD) {
+		insertion_sort(rows, n, dates, order);
+		return OK;
+	}
+
+	sort_pair_t *pairs = tur_malloc(n * sizeof(sort_pair_t));
+	sort_pair_t *scratch = tur_malloc(n * sizeof(sort_pair_t));
+	if (!pairs || !scratch) {
+		(void)log_err("sort_rows_by_date: cannot allocate the radix buffers, "
+					  "falling back to qsort\n");
+		tur_free(pairs);
+		tur_free(scratch);
+		sort_rows_by_date_qsort(rows, n, dates, order);
+		return RUNTIME_MALLOC_ERROR;
+	}
+
+	/* A single pass over the rows builds the keys and all the histograms */
+	for (size_t i = 0; i < n; i++) {
+		const uint64_t key = date_key(dates[rows[i]], order);
+		pairs[i] = (sort_pair_t) { .key = key, .row = rows[i] };
+		for (unsigned p = 0; p < RADIX_PASSES; p++) {
+			histograms[p][(key >> (p * RADIX_BITS)) & RADIX_MASK]++;
+		}
+	}
+
+	sort_pair_t *src = pairs, *dst = scratch;
+
+	for (unsigned p = 0; p < RADIX_PASSES; p++) {
+		size_t *histogram = histograms[p];
+		const unsigned shift = p * RADIX_BITS;
+
+		/* Every key has the same digit (e.g. the high bytes of dates
+		 * that are close in time): this pass would not move anything. */
+		if (histogram[(src[0].key >> shift) & RADIX_MASK] == n) { continue; }
+
+		size_t offset = 0;
+		for (unsigned d = 0; d < RADIX_SIZE; d++) {
+			const size_t count = histogram[d];
+			histogram[d] = offset;
+			offset += count;
+		}
+
+		for (size_t i = 0; i < n; i++) {
+			dst[histogram[(src[i].key >> shift) & RADIX_MASK]++] = src[i];
+		}
+
+		sort_pair_t *tmp = src;
+		src = dst;
+		dst = tmp;
+	}
+
+	for (size_t i = 0; i < n; i++) {
+		rows[i] = src[i].row;
+	}
+
+	tur_free(pairs);
+	tur_free(scratch);
+
+	return OK;
+}
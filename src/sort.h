@@ -0,0 +1,44 @@
+/* sort.h
+ * -----------------------------------------------------------------------
+ * Copyright (C) 2025  Matteo Nicoli
+ *
+ * This file is part of TUR.
+ *
+ * TUR is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __SORT_H__
+#define __SORT_H__
+
+#include "codes.h"
+#include "commit.h"
+#include "settings.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+/* Stable LSD radix sort of row ids by the date column of a commit table.
+ * If the scratch buffers cannot be allocated, it falls back to
+ * sort_rows_by_date_qsort. */
+return_code_t sort_rows_by_date(uint32_t *rows, size_t n, const time_t *dates,
+								sort_ordering_t order);
+
+/* Comparison based sort. It is not stable, and it is kept as a fallback and
+ * as a baseline for benchmarks. */
+void sort_rows_by_date_qsort(uint32_t *rows, size_t n, const time_t *dates,
+							 sort_ordering_t order);
+
+#endif /* __SORT_H__ */
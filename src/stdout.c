@@ -19,127 +19,136 @@
  * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
  */
 
+#include "sink.h"
+#include "timeline.h"
 #include "utils.h"
 #include "view.h"
 
-#include <stdio.h>
+static void print_commit_diffs(sink_t *out, const commit_t * commit, const settings_t *settings)
+{
+	sink_putc(out, '\t');
+	sink_put_uint(out, commit->stats.files_changed);
+	sink_puts(out, commit->stats.files_changed > 1 ? " files changed\t" : " file changed\t");
+	if (!settings->no_ansi) { sink_puts(out, GREEN); }
+	sink_putc(out, '+');
+	sink_put_uint(out, commit->stats.lines_added);
+	if (!settings->no_ansi) { sink_puts(out, RESET); }
+	sink_puts(out, " | ");
+	if (!settings->no_ansi) { sink_puts(out, RED); }
+	sink_putc(out, '-');
+	sink_put_uint(out, commit->stats.lines_removed);
+	if (!settings->no_ansi) { sink_puts(out, RESET); }
+	if (settings->print_msg) { sink_putc(out, '\n'); }
+}
 
-static void print_commit_diffs(const commit_t * commit, const settings_t *settings)
+static void print_commit_message(sink_t *out, const commit_t * commit, const char *indent)
 {
-	char *msg = settings->no_ansi
-						  ? "\t%zu file%s changed\t+%zu | -%zu%s"
-						  : "\t%zu file%s changed\t" GREEN "+%zu" RESET " | " RED "-%zu" RESET "%s";
-	fprintf(stdout, msg,
-			commit->stats.files_changed,
-			(commit->stats.files_changed > 1 ? "s": ""),
-			commit->stats.lines_added,
-			commit->stats.lines_removed,
-			settings->print_msg ? "\n" : "");
+	sink_puts(out, indent);
+	sink_puts(out, "| ");
+	sink_put_str(out, first_line_view(commit->msg));
+	sink_putc(out, '\n');
 }
 
-static void print_commit_message(const commit_t * commit, const char *indent)
+static void print_stdout_commit(sink_t *out, const commit_t *commit, const settings_t *settings)
 {
-	fprintf(stdout, "%s| %s\n", indent, get_first_line(commit->msg).val);
+	if (settings->print_msg) {
+		print_commit_message(out, commit, "\t");
+	}
+	sink_puts(out, "\t| ");
+	sink_put_str(out, commit->hash);
+	sink_putc(out, ' ');
+	sink_put_date(out, commit->date, settings->date_only);
+	if (settings->show_diffs) {
+		print_commit_diffs(out, commit, settings);
+	}
+	sink_putc(out, '\n');
 }
 
-static void print_stdout_grouped(const repository_t *repo, const indexes_t *indexes, const settings_t *settings)
+static void print_stdout_grouped(sink_t *out, const repository_t *repo, const indexes_t *indexes,
+								 const settings_t *settings)
 {
-	commit_t **const authored = indexes->authored;
-	commit_t **const co_authored = indexes->co_authored;
+	const uint32_t *authored = indexes->authored;
+	const uint32_t *co_authored = indexes->co_authored;
 
 	if (repo->history->n_authored == 0 && repo->history->n_co_authored == 0) { return; }
 
-	fprintf(stdout, "Repository: %s\n", repo->name.val);
+	sink_puts(out, "Repository: ");
+	sink_put_str(out, repo->name);
+	sink_puts(out, truncation_note(repo->history->truncated));
+	sink_putc(out, '\n');
 
 	if (repo->history->n_authored == 0) { goto co_authored; }
 
-	fprintf(stdout, "Authored commits:\n");
+	sink_puts(out, "Authored commits:\n");
 	for (size_t n_c = 0; n_c < repo->history->n_authored; n_c++) {
-		if (settings->print_msg) {
-			print_commit_message(authored[n_c], "\t");
-		}
-		fprintf(stdout, "\t| %s %s",
-				authored[n_c]->hash.val,
-				format_date(authored[n_c]->date, settings->date_only).val);
-		if (settings->show_diffs) {
-			print_commit_diffs(authored[n_c], settings);
-		}
-		fprintf(stdout, "\n");
+		const commit_t commit = commit_table_row(&repo->history->commits, authored[n_c]);
+		print_stdout_commit(out, &commit, settings);
 	}
 
 co_authored:
 
 	if (repo->history->n_co_authored == 0) { return; }
 
-	fprintf(stdout, "Co-authored commits:\n");
+	sink_puts(out, "Co-authored commits:\n");
 	for (size_t n_c = 0; n_c < repo->history->n_co_authored; n_c++) {
-		if (settings->print_msg) {
-			print_commit_message(co_authored[n_c], "\t");
-		}
-		fprintf(stdout, "\t| %s %s",
-				co_authored[n_c]->hash.val,
-				format_date(co_authored[n_c]->date, settings->date_only).val);
+		const commit_t commit = commit_table_row(&repo->history->commits, co_authored[n_c]);
+		print_stdout_commit(out, &commit, settings);
+	}
+}
 
-		if (settings->show_diffs) {
-			print_commit_diffs(co_authored[n_c], settings);
-		}
-		fprintf(stdout, "\n");
+static void print_stdout_list_item(sink_t *out, const timeline_item_t *item,
+								   const settings_t *settings, size_t max_name_len)
+{
+	if (settings->print_msg) {
+		print_commit_message(out, &item->commit, "");
 	}
+	sink_puts(out, "| ");
+	sink_put_padded(out, item->repo->name, max_name_len);
+	sink_puts(out, "   ");
+	sink_put_str(out, item->commit.hash);
+	sink_putc(out, ' ');
+	sink_put_date(out, item->commit.date, settings->date_only);
+	sink_puts(out, item->responsability == AUTHORED ? " [A]" : " [C]");
+
+	if (settings->show_diffs) {
+		print_commit_diffs(out, &item->commit, settings);
+	}
+	sink_putc(out, '\n');
 }
 
-static void print_stdout_list(const repository_t *repo, const indexes_t *indexes,
+static void print_stdout_list(sink_t *out, const repository_array_t *repos,
 							  const settings_t *settings, size_t max_name_len)
 {
-	commit_t **const authored = indexes->authored;
-	commit_t **const co_authored = indexes->co_authored;
-	const char *fmt_string = "| %-*s   %s %s [%c]";
+	timeline_t timeline;
+	timeline_item_t item;
 
-	for (size_t n_c = 0; n_c < repo->history->n_authored; n_c++) {
-		if (settings->print_msg) {
-			print_commit_message(authored[n_c], "");
-		}
-		fprintf(stdout, fmt_string,
-				(int)max_name_len,
-				repo->name.val,
-				authored[n_c]->hash.val,
-				format_date(authored[n_c]->date, settings->date_only).val,
-				'A');
-		
-		if (settings->show_diffs) {
-			print_commit_diffs(authored[n_c], settings);
-		}
-		fprintf(stdout, "\n");
-	}
+	if (timeline_init(&timeline, repos, settings) != OK) { return; }
 
-	for (size_t n_c = 0; n_c < repo->history->n_co_authored; n_c++) {
-		if (settings->print_msg) {
-			print_commit_message(co_authored[n_c], "");
-		}
-		fprintf(stdout, fmt_string,
-				(int)max_name_len,
-				repo->name.val,
-				co_authored[n_c]->hash.val,
-				format_date(co_authored[n_c]->date, settings->date_only).val,
-				'C');
-		
-		if (settings->show_diffs) {
-			print_commit_diffs(co_authored[n_c], settings);
-		}
-		fprintf(stdout, "\n");
+	while (timeline_next(&timeline, &item)) {
+		print_stdout_list_item(out, &item, settings, max_name_len);
 	}
+
+	timeline_free(&timeline);
 }
 
-void print_stdout(const repository_array_t *repos, const settings_t *settings, repository_stats_t stats)
+void print_stdout_section(sink_t *out, const repository_t *repo, const settings_t *settings)
 {
-	for (size_t i = 0; i < repos->len; i++) {
-		repository_t *repo = repo_array_get(repos, i);
+	print_stdout_grouped(out, repo, &repo->history->indexes, settings);
+}
 
-		if (settings->grouped) {
-			print_stdout_grouped(repo, &repo->history->indexes, settings);
-		} else {
-			print_stdout_list(repo, &repo->history->indexes, settings, stats.max_name_len);
-		}
+void print_stdout(sink_t *out, const repository_array_t *repos, const settings_t *settings,
+				  repository_stats_t stats, const sink_t *sections)
+{
+	if (!settings->grouped) {
+		print_stdout_list(out, repos, settings, stats.max_name_len);
+		return;
 	}
 
-	fflush(stdout);
+	for (size_t i = 0; i < repos->len; i++) {
+		if (sections) {
+			sink_write(out, sections[i].buf, sections[i].len);
+			continue;
+		}
+		print_stdout_section(out, repo_array_get(repos, i), settings);
+	}
 }
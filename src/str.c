@@ -19,6 +19,7 @@
  * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
  */
 
+#include "alloc.h"
 #include "array.h"
 #include "codes.h"
 #include "log.h"
@@ -42,7 +43,7 @@ str_t empty_str(void)
 
 str_t str_init(const char *str, uint16_t len)
 {
-	char *copy = malloc(len + 1);
+	char *copy = tur_malloc(len + 1);
 	if (!copy) {
 		(void)log_err("str_init: memory allocation failed\n");
 		return empty_str();
@@ -99,7 +100,7 @@ char get_char(str_t str, uint16_t i)
 str_t str_concat(str_t str1, str_t str2)
 {
 	uint16_t new_len = str1.len + str2.len;
-	char *new_val = malloc(new_len + 1);
+	char *new_val = tur_malloc(new_len + 1);
 	if (!new_val) {
 		(void)log_err("str_concat: memory allocation failed. Trying to concatenate:\n"
 					  "    \"%s\"\n"
@@ -139,7 +140,7 @@ bool chars_contains_chars(const char *str, const char * substr)
 
 void str_free(str_t str)
 {
-	free((void *)str.val);
+	tur_free((void *)str.val);
 }
 
 /*
@@ -0,0 +1,177 @@
+/* timeline.c
+ * -----------------------------------------------------------------------
+ * Copyright (C) 2025  Matteo Nicoli
+ *
+ * This file is part of TUR.
+ *
+ * TUR is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "alloc.h"
+#include "codes.h"
+#include "commit.h"
+#include "log.h"
+#include "repo.h"
+#include "settings.h"
+#include "timeline.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#define RUNS_PER_REPO 2
+
+static inline time_t run_head_date(const timeline_t *timeline, size_t run)
+{
+	const timeline_run_t *r = timeline->runs + run;
+	return r->commits->dates[r->rows[r->next]];
+}
+
+/* True if the head of run `a` must be emitted before the head of run `b`.
+ * Ties are broken by the position of the run, so commits with the same date
+ * keep the order of the repository list. */
+static bool run_precedes(const timeline_t *timeline, size_t a, size_t b)
+{
+	const time_t date_a = run_head_date(timeline, a);
+	const time_t date_b = run_head_date(timeline, b);
+
+	if (date_a == date_b) { return a < b; }
+	return timeline->order == ASC
+		   ? date_a < date_b
+		   : date_a > date_b;
+}
+
+static void sift_down(timeline_t *timeline, size_t i)
+{
+	size_t *heap = timeline->heap;
+
+	while (1) {
+		size_t left = 2 * i + 1, right = left + 1, first = i;
+
+		if (left < timeline->heap_len && run_precedes(timeline, heap[left], heap[first])) {
+			first = left;
+		}
+		if (right < timeline->heap_len && run_precedes(timeline, heap[right], heap[first])) {
+			first = right;
+		}
+		if (first == i) { return; }
+
+		size_t tmp = heap[i];
+		heap[i] = heap[first];
+		heap[first] = tmp;
+		i = first;
+	}
+}
+
+static void add_run(timeline_t *timeline, const repository_t *repo,
+					const uint32_t *rows, size_t len, responsability_t resp)
+{
+	if (len == 0 || !rows) { return; }
+
+	timeline->runs[timeline->n_runs++] = (timeline_run_t) {
+		.repo = repo,
+		.commits = &repo->history->commits,
+		.rows = rows,
+		.len = len,
+		.next = 0,
+		.responsability = resp,
+	};
+}
+
+return_code_t timeline_init(timeline_t *timeline,
+							const repository_array_t *repos,
+							const settings_t *settings)
+{
+	*timeline = (timeline_t) {
+		.runs = tur_malloc(repos->len * RUNS_PER_REPO * sizeof(timeline_run_t)),
+		.heap = tur_malloc(repos->len * RUNS_PER_REPO * sizeof(size_t)),
+		.sorted = settings->sorted,
+		.order = settings->sort_order,
+	};
+
+	if (repos->len > 0 && (!timeline->runs || !timeline->heap)) {
+		(void)log_err("timeline_init: cannot allocate the commit runs\n");
+		timeline_free(timeline);
+		return RUNTIME_MALLOC_ERROR;
+	}
+
+	for (size_t i = 0; i < repos->len; i++) {
+		const repository_t *repo = repo_array_get(repos, i);
+		const work_history_t *history = repo->history;
+		if (!history) { continue; }
+
+		add_run(timeline, repo, history->indexes.authored,
+				history->n_authored, AUTHORED);
+		add_run(timeline, repo, history->indexes.co_authored,
+				history->n_co_authored, CO_AUTHORED);
+	}
+
+	if (timeline->sorted) {
+		for (size_t i = 0; i < timeline->n_runs; i++) {
+			timeline->heap[i] = i;
+		}
+		timeline->heap_len = timeline->n_runs;
+		/* Heapify: runs are added in repository order, ties included */
+		for (size_t i = timeline->heap_len / 2; i-- > 0;) {
+			sift_down(timeline, i);
+		}
+	}
+
+	return OK;
+}
+
+bool timeline_next(timeline_t *timeline, timeline_item_t *item)
+{
+	timeline_run_t *run;
+
+	if (timeline->sorted) {
+		if (timeline->heap_len == 0) { return false; }
+		run = timeline->runs + timeline->heap[0];
+	} else {
+		while (timeline->current < timeline->n_runs
+			   && timeline->runs[timeline->current].next
+				  == timeline->runs[timeline->current].len) {
+			timeline->current++;
+		}
+		if (timeline->current == timeline->n_runs) { return false; }
+		run = timeline->runs + timeline->current;
+	}
+
+	*item = (timeline_item_t) {
+		.repo = run->repo,
+		.commit = commit_table_row(run->commits, run->rows[run->next]),
+		.row = run->rows[run->next],
+		.responsability = run->responsability,
+	};
+	run->next++;
+
+	if (timeline->sorted) {
+		if (run->next == run->len) {
+			/* Exhausted: the last run takes its place */
+			timeline->heap[0] = timeline->heap[--timeline->heap_len];
+		}
+		sift_down(timeline, 0);
+	}
+
+	return true;
+}
+
+void timeline_free(timeline_t *timeline)
+{
+	tur_free(timeline->runs);
+	tur_free(timeline->heap);
+	timeline->runs = NULL;
+	timeline->heap = NULL;
+}
@@ -0,0 +1,76 @@
+/* timeline.h
+ * -----------------------------------------------------------------------
+ * Copyright (C) 2025  Matteo Nicoli
+ *
+ * This file is part of TUR.
+ *
+ * TUR is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __TIMELINE_H__
+#define __TIMELINE_H__
+
+#include "codes.h"
+#include "commit.h"
+#include "repo.h"
+#include "settings.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* A run is one of the indexes (authored or co-authored) of a repository.
+ * When the output is sorted, every run is already sorted by build_indexes.
+ * The merge compares dates only, read straight from the dates column. */
+typedef struct {
+	const repository_t *repo;
+	const commit_table_t *commits;
+	const uint32_t *rows;
+	size_t len;
+	size_t next;
+	responsability_t responsability;
+} timeline_run_t;
+
+/* Iterates over the commits of all the repositories as a single list.
+ * If the output is sorted, the runs are merged with a k-way merge driven by
+ * a binary heap, so the commits come out in global date order without
+ * concatenating the indexes. Otherwise, the runs are visited in order. */
+typedef struct {
+	timeline_run_t *runs;
+	size_t n_runs;
+	size_t *heap;
+	size_t heap_len;
+	size_t current;
+	bool sorted;
+	sort_ordering_t order;
+} timeline_t;
+
+/* The hash and the message of `commit` point into the commit table of
+ * `repo` (see commit_table_row) */
+typedef struct {
+	const repository_t *repo;
+	commit_t commit;
+	/* Row of the commit in the commit table of `repo` */
+	uint32_t row;
+	responsability_t responsability;
+} timeline_item_t;
+
+return_code_t timeline_init(timeline_t *timeline,
+							const repository_array_t *repos,
+							const settings_t *settings);
+bool timeline_next(timeline_t *timeline, timeline_item_t *item);
+void timeline_free(timeline_t *timeline);
+
+#endif /* __TIMELINE_H__ */
@@ -0,0 +1,211 @@
+/* trace.c
+ * -----------------------------------------------------------------------
+ * Copyright (C) 2025  Matteo Nicoli
+ *
+ * This file is part of TUR.
+ *
+ * TUR is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "alloc.h"
+#include "codes.h"
+#include "log.h"
+#include "profile.h"
+#include "sink.h"
+#include "str.h"
+#include "trace.h"
+
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define TRACE_INITIAL_CAPACITY 256
+
+typedef struct {
+	const char *name;
+	const char *target;
+	uint64_t start;
+	uint64_t end;
+	uint32_t count;
+} trace_event_t;
+
+typedef struct {
+	trace_event_t *events;
+	size_t len;
+	size_t capacity;
+	char name[TRACE_THREAD_NAME_SIZE];
+	/* Set once an allocation failed: the spans of the thread are dropped */
+	bool truncated;
+} trace_buffer_t;
+
+static bool enabled = false;
+static uint64_t origin = 0;
+static trace_buffer_t buffers[TRACE_MAX_THREADS];
+static size_t n_buffers = 0;
+static _Thread_local trace_buffer_t *local_buffer = NULL;
+static _Thread_local bool no_buffer = false;
+
+void trace_enable(void)
+{
+	origin = profile_clock();
+	enabled = true;
+}
+
+uint64_t trace_begin(void)
+{
+	return enabled ? profile_clock() : 0;
+}
+
+static trace_buffer_t *thread_buffer(void)
+{
+	if (local_buffer || no_buffer) { return local_buffer; }
+
+	const size_t slot = __atomic_fetch_add(&n_buffers, 1, __ATOMIC_RELAXED);
+	if (slot >= TRACE_MAX_THREADS) {
+		no_buffer = true;
+		return NULL;
+	}
+	local_buffer = buffers + slot;
+	return local_buffer;
+}
+
+void trace_end(const char *name, uint64_t start, const char *target, uint32_t count)
+{
+	if (!start) { return; }
+
+	trace_buffer_t *buffer = thread_buffer();
+	if (!buffer || buffer->truncated) { return; }
+
+	if (buffer->len == buffer->capacity) {
+		const size_t capacity = buffer->capacity ? buffer->capacity * 2 : TRACE_INITIAL_CAPACITY;
+		trace_event_t *events = tur_realloc(buffer->events, capacity * sizeof(trace_event_t));
+		if (!events) {
+			buffer->truncated = true;
+			return;
+		}
+		buffer->events = events;
+		buffer->capacity = capacity;
+	}
+
+	buffer->events[buffer->len++] = (trace_event_t) {
+		.name = name,
+		.target = target,
+		.start = start,
+		.end = profile_clock(),
+		.count = count
+	};
+}
+
+void trace_thread_name(const char *format, ...)
+{
+	va_list args;
+
+	if (!enabled) { return; }
+	trace_buffer_t *buffer = thread_buffer();
+	if (!buffer) { return; }
+
+	va_start(args, format);
+	(void)vsnprintf(buffer->name, sizeof(buffer->name), format, args);
+	va_end(args);
+}
+
+/* Timestamps are in microseconds from trace_enable */
+static void put_us(sink_t *out, uint64_t ns)
+{
+	sink_put_uint(out, ns / 1000);
+	sink_putc(out, '.');
+	sink_printf(out, "%03u", (unsigned)(ns % 1000));
+}
+
+static void put_c_str(sink_t *out, const char *str)
+{
+	sink_put_json_str(out, (str_t) { .val = str, .len = (uint16_t)strlen(str) });
+}
+
+return_code_t trace_write(const char *path)
+{
+	sink_t out;
+	const unsigned pid = (unsigned)getpid();
+	const size_t used = n_buffers < TRACE_MAX_THREADS ? n_buffers : TRACE_MAX_THREADS;
+	bool first = true;
+
+	if (sink_init_file(&out, path, false) != OK) {
+		(void)log_err("trace_write: cannot open file: %s\n", path);
+		return CANNOT_OPEN_OUTPUT;
+	}
+
+	sink_puts(&out, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+	for (size_t tid = 0; tid < used; tid++) {
+		const trace_buffer_t *buffer = buffers + tid;
+
+		if (buffer->name[0]) {
+			sink_printf(&out, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%u,"
+						"\"tid\":%zu,\"args\":{\"name\":", first ? "" : ",\n", pid, tid);
+			put_c_str(&out, buffer->name);
+			sink_puts(&out, "}}");
+			first = false;
+		}
+
+		for (size_t i = 0; i < buffer->len; i++) {
+			const trace_event_t *event = buffer->events + i;
+
+			sink_puts(&out, first ? "{\"name\":" : ",\n{\"name\":");
+			put_c_str(&out, event->name);
+			sink_printf(&out, ",\"ph\":\"X\",\"pid\":%u,\"tid\":%zu,\"ts\":", pid, tid);
+			put_us(&out, event->start - origin);
+			sink_puts(&out, ",\"dur\":");
+			put_us(&out, event->end - event->start);
+			if (event->target || event->count) {
+				sink_puts(&out, ",\"args\":{");
+				if (event->target) {
+					sink_puts(&out, "\"target\":");
+					put_c_str(&out, event->target);
+				}
+				if (event->count) {
+					sink_puts(&out, event->target ? ",\"count\":" : "\"count\":");
+					sink_put_uint(&out, event->count);
+				}
+				sink_putc(&out, '}');
+			}
+			sink_putc(&out, '}');
+			first = false;
+		}
+		if (buffer->truncated) {
+			(void)log_err("trace_write: spans of thread #%zu dropped, out of memory\n", tid);
+		}
+	}
+	sink_puts(&out, "\n]}\n");
+
+	const return_code_t ret = sink_close(&out);
+	if (ret != OK) {
+		(void)log_err("trace_write: cannot write file: %s\n", path);
+	}
+	return ret;
+}
+
+void trace_free(void)
+{
+	const size_t used = n_buffers < TRACE_MAX_THREADS ? n_buffers : TRACE_MAX_THREADS;
+
+	for (size_t i = 0; i < used; i++) {
+		tur_free(buffers[i].events);
+		buffers[i] = (trace_buffer_t) { 0 };
+	}
+	n_buffers = 0;
+	enabled = false;
+}
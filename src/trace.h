@@ -0,0 +1,56 @@
+/* trace.h
+ * -----------------------------------------------------------------------
+ * Copyright (C) 2025  Matteo Nicoli
+ *
+ * This file is part of TUR.
+ *
+ * TUR is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __TRACE_H__
+#define __TRACE_H__
+
+#include "codes.h"
+
+#include <stdint.h>
+
+/* --trace: spans in the Chrome trace-event format, to be opened with
+ * Perfetto or chrome://tracing. Each thread records into its own buffer,
+ * claimed with an atomic increment the first time it records a span, so
+ * no lock is taken while tracing. The buffers are read by trace_write
+ * once every traced thread has been joined. */
+
+/* Threads that can record spans over a run: the walk, the render pass,
+ * the writers and the main thread */
+#define TRACE_MAX_THREADS 2048
+#define TRACE_THREAD_NAME_SIZE 32
+/* Diffs grouped in a single "diff batch" span */
+#define TRACE_DIFF_BATCH 256
+
+/* Must be called before any traced thread is started */
+void trace_enable(void);
+/* Start of a span, or 0 when tracing is off */
+uint64_t trace_begin(void);
+/* Records the span [start, now) on the calling thread. `target` (the
+ * repository or the output file) and `count` are optional arguments (NULL,
+ * 0 to omit them); `name` and `target` must live until trace_write. */
+void trace_end(const char *name, uint64_t start, const char *target, uint32_t count);
+/* Names the calling thread in the trace, e.g. "worker #3" */
+void trace_thread_name(const char *format, ...)
+	__attribute__((format(printf, 1, 2)));
+return_code_t trace_write(const char *path);
+void trace_free(void);
+
+#endif /* __TRACE_H__ */
@@ -19,11 +19,13 @@
  * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
  */
 
+#include "alloc.h"
 #include "cache.h"
 #include "codes.h"
 #include "log.h"
 #include "opts_args.h"
 #include "repo.h"
+#include "serve.h"
 #include "settings.h"
 #include "str.h"
 #include "utils.h"
@@ -36,6 +38,9 @@
 #include <stdlib.h>
 #include <string.h>
 #include <getopt.h>
+#include <time.h>
+
+#define SECONDS_PER_HOUR 3600
 
 static settings_t settings;
 static struct option long_options[] = {
@@ -51,7 +56,19 @@ static struct option long_options[] = {
 	{ "no-merge",    no_argument,       0,  3  },
 	{ "no-cache",    no_argument,       0,  4  },
 	{ "clear-cache", no_argument,       0,  5  },
+	{ "all-refs",    optional_argument, 0,  6  },
+	{ "recent",      required_argument, 0,  7  },
+	{ "mmap",        no_argument,       0,  8  },
+	{ "stream",      no_argument,       0,  9  },
+	{ "stats",       no_argument,       0,  10 },
+	{ "profile",     required_argument, 0,  11 },
+	{ "trace",       required_argument, 0,  12 },
+	{ "metrics",     required_argument, 0,  13 },
+	{ "progress",    optional_argument, 0,  14 },
+	{ "budget",      required_argument, 0,  15 },
+	{ "serve",       required_argument, 0,  16 },
 	{ "emails",      required_argument, 0, 'e' },
+	{ "jobs",        required_argument, 0, 'j' },
 	{ "out",         required_argument, 0, 'o' },
 	{ "repos",       required_argument, 0, 'r' },
 	{ "sort",        required_argument, 0, 's' },
@@ -83,9 +100,23 @@ static void print_help(void)
 		   "  -m, --message          Shows the first line of the commit message\n"
 		   "  -v, --version          Prints the verison on tur\n"
 		   "                         Default: false\n"
+		   "  --all-refs[=GLOB]      Walk every local branch (or every ref matching GLOB,\n"
+		   "                         e.g. 'refs/remotes/origin/*') at once. Each commit is\n"
+		   "                         visited only once, even if it's reachable from many refs.\n"
+		   "                         It overrides the branches listed in the repository file\n"
+		   "  --budget <LIMITS>      Stop the walk of each repository after `time=SECONDS`,\n"
+		   "                         `commits=N` visited or `diffs=N` diffed, whichever\n"
+		   "                         comes first (e.g. time=60,diffs=5000). The output is\n"
+		   "                         marked as truncated. An .rlist entry can override them\n"
 		   "  --clear-cache          Delete the cache folder .tur/. Irreversible!!!\n"
 		   "  --date-only            Each commit will be printed without time information\n"
-		   "                         Format: Dec 28, 1994\n"
+		   "                         Format: Dec 28, 1994\n",
+		   __TUR_VERSION__);
+	printf("  --metrics FILE         Write the commits, lines, walk time and errors of each\n"
+		   "                         repository, and the phase timings of the run, to FILE\n"
+		   "                         in the OpenMetrics text format (node exporter textfile)\n"
+		   "  --mmap                 Write the output file through a memory mapping instead\n"
+		   "                         of write(2). It has no effect when printing to stdout\n"
 		   "  --no-ansi              Avoid ANSI escape characters (e.g. escape characters\n"
 		   "                         for color handling in terminal)\n"
 		   "                         NOTE: this option is active only when printing to stdout.\n"
@@ -93,12 +124,47 @@ static void print_help(void)
 		   "  --no-cache             Disable the cache no file is neither saved nor created in\n"
 		   "                         the directory `.tur`\n"
 		   "  --no-merge             Exclude merge commits\n"
-		   "  -e, --emails <e_1,...> Specify a list of email addresses\n"
+		   "  --profile FILE         Write the profile of the run (see --stats) to FILE,\n"
+		   "                         as JSON. Times are in nanoseconds\n"
+		   "  --progress[=json]      Every second, print to stderr the commits/s, the ETA and\n"
+		   "                         the repository each thread is walking; with `json`, as\n"
+		   "                         one JSON object per line. SIGUSR1 prints a report anytime\n"
+		   "  --recent <HOURS>       Only retrieve the commits made in the last HOURS hours.\n"
+		   "                         Candidate commits are read from the reflogs of HEAD and\n"
+		   "                         of the branches, instead of walking the whole history\n"
+		   "  --serve SOCKET         Keep the repositories open and answer queries on the\n"
+		   "                         Unix socket SOCKET, e.g. `emails=a@b.c format=json\n"
+		   "                         since=<UNIX TIME> group`. The histories are kept in\n"
+		   "                         memory and walked again only when the refs change\n"
+		   "  --stats                At the end of the run, print how long each phase took\n"
+		   "                         (open, revwalk, lookup, diff, index, render, cache\n"
+		   "                         and output) and how many commits were visited, matched\n"
+		   "                         and diffed, for each repository\n"
+		   "  --stream               With -g, write each repository as soon as it and all\n"
+		   "                         the repositories before it in the list are done.\n"
+		   "                         It requires --no-cache and no interactive mode\n"
+		   "  --trace FILE           Write the spans of every thread (open, walk, diff\n"
+		   "                         batch, index, render, output) to FILE, in the trace\n"
+		   "                         event format of Perfetto and chrome://tracing\n");
+	printf("  -e, --emails <e_1,...> Specify a list of email addresses\n"
 		   "                         This list expects the emails separated by a comma.\n"
-		   "  -o, --out FILE         Specify an output file. Allowed extensions are:\n"
+		   "  -j, --jobs <N|auto>    Number of threads walking the repositories, capped at\n"
+		   "                         the number of repositories. With `auto`, the number of\n"
+		   "                         active threads follows the measured commits/s, up to\n"
+		   "                         4 threads per core.\n"
+		   "                         Default: number of online cores\n"
+		   "  -o, --out FILE         Specify an output file. It can be repeated (up to 8\n"
+		   "                         times) to write many formats from a single walk.\n"
+		   "                         A repeated file, or a second output with an\n"
+		   "                         unknown extension (stdout), is ignored.\n"
+		   "                         Allowed extensions are:\n"
 		   "                             .tex          (LaTeX)\n"
 		   "                             .html / .html (HTML)\n"
 		   "                             .md           (Markdown)\n"
+		   "                             .json         (JSON)\n"
+		   "                             .ndjson/.jsonl (NDJSON, one commit per line)\n"
+		   "                             .csv / .tsv   (CSV, TSV)\n"
+		   "                             .turc         (binary columnar export)\n"
 		   "                         Default: stdout\n"
 		   "  -r, --repos REPOS      Specify the file containing the list of repositories.\n"
 		   "                         Default: .rlist in the current folder\n"
@@ -111,10 +177,30 @@ static void print_help(void)
 		   "Examples:\n"
 		   "  tur -e user@example.com\n"
 		   "  tur -e user1@example.com,user2@example.com -o commits.tex\n"
+		   "  tur -g -e user@example.com -o commits.html -o commits.md -o commits.tex\n"
 		   "  tur -dmg -e user1@example.com,user2@example.com -o commits.html -s DESC\n"
 		   "\n"
-		   "\n",
-		   __TUR_VERSION__);
+		   "\n");
+}
+
+/* Two targets on the same file would truncate and write it at the same
+ * time, and two stdout targets would interleave on fd 1 */
+static bool output_target_conflicts(const char *path, tur_output_t mode)
+{
+	const str_t target = STR_VIEW(path, (uint16_t) strlen(path));
+
+	for (size_t i = 0; i < settings.n_outputs; i++) {
+		if (str_equals(settings.outputs[i].path, target)) {
+			(void)log_err("Output file %s repeated: ignored\n", path);
+			return true;
+		}
+		if (mode == STDOUT && settings.outputs[i].mode == STDOUT) {
+			(void)log_err("Only one output can be written to stdout: %s ignored\n", path);
+			return true;
+		}
+	}
+
+	return false;
 }
 
 int main(int argc, char *argv[])
@@ -127,10 +213,12 @@ int main(int argc, char *argv[])
 		goto end;
 	}
 
-	settings = default_settings();
 	(void)init_default_loggers();
+	/* Before anything is allocated */
+	alloc_init();
+	settings = default_settings();
 
-	while ((ch = getopt_long(argc, argv, "hdfgimve:o:r:s:t:", long_options, &option_index)) != -1) {
+	while ((ch = getopt_long(argc, argv, "hdfgimve:j:o:r:s:t:", long_options, &option_index)) != -1) {
 		switch (ch) {
 		case 'h':
 			print_help();
@@ -175,12 +263,84 @@ int main(int argc, char *argv[])
 				(void)log_info("cache dir `%s` removed...\n", TUR_DIR);
 			}
 			break;
+		case 6:
+			settings.all_refs = true;
+			if (optarg && strlen(optarg)) {
+				str_free(settings.refs_glob);
+				settings.refs_glob = str_init(optarg, (uint16_t) strlen(optarg));
+			}
+			break;
+		case 7: {
+			unsigned hours;
+			if (parse_optarg_to_int(optarg, &hours) != OK || hours == 0) {
+				(void)log_err("Invalid number of hours '%s' for `--recent`. "
+							  "The option has been ignored\n", optarg);
+				break;
+			}
+			settings.since = time(NULL) - (time_t)hours * SECONDS_PER_HOUR;
+			break;
+		}
+		case 8:
+			settings.mmap_output = true;
+			break;
+		case 9:
+			settings.stream_output = true;
+			break;
+		case 10:
+			settings.print_stats = true;
+			break;
+		case 11:
+			settings.profile_path = str_init(optarg, (uint16_t) strlen(optarg));
+			break;
+		case 12:
+			settings.trace_path = str_init(optarg, (uint16_t) strlen(optarg));
+			break;
+		case 13:
+			settings.metrics_path = str_init(optarg, (uint16_t) strlen(optarg));
+			break;
+		case 14:
+			if (parse_progress(optarg, &settings.progress) != OK) {
+				(void)log_err("Invalid progress format '%s': expected `text` or `json`. "
+							  "The option has been ignored\n", optarg);
+			}
+			break;
+		case 15:
+			if (parse_budget(&settings.budget, optarg, strlen(optarg)) != OK) {
+				(void)log_err("Invalid budget '%s': expected e.g. `time=60,commits=100000,"
+							  "diffs=5000`. The option has been ignored\n", optarg);
+			}
+			break;
+		case 16:
+			settings.serve_path = str_init(optarg, (uint16_t) strlen(optarg));
+			break;
 		case 'e':
 			settings.emails = parse_emails(optarg);
 			break;
+		case 'j':
+			if (parse_jobs(optarg, &settings.n_threads, &settings.adaptive_threads) != OK) {
+				(void)log_err("Invalid number of jobs '%s': expected a number between "
+							  "1 and %d, or `auto`. The option has been ignored\n",
+							  optarg, MAX_THREADS);
+			}
+			break;
 		case 'o':
-			settings.output_mode = parse_output_file_ext(optarg);
-			settings.output = str_init(optarg, (uint16_t) strlen(optarg));
+			if (settings.n_outputs == MAX_OUTPUTS) {
+				(void)log_err("Too many output files (max %d): %s ignored\n",
+							  MAX_OUTPUTS, optarg);
+				break;
+			}
+			const tur_output_t mode = parse_output_file_ext(optarg);
+			if (output_target_conflicts(optarg, mode)) {
+				break;
+			}
+			settings.outputs[settings.n_outputs++] = (output_target_t) {
+				.path = str_init(optarg, (uint16_t) strlen(optarg)),
+				.mode = mode
+			};
+			if (settings.n_outputs == 1) {
+				settings.output_mode = settings.outputs[0].mode;
+				settings.output = settings.outputs[0].path;
+			}
 			break;
 		case 'r':
 			settings.repos_path = str_init(optarg, (uint16_t) strlen(optarg));
@@ -207,22 +367,37 @@ int main(int argc, char *argv[])
 		}
 	}
 
+	if (str_not_empty(settings.serve_path) && settings.since) {
+		(void)log_err("`--recent` is ignored with `--serve`: "
+					  "the queries can set `since=` instead\n");
+		settings.since = 0;
+	}
+
 	git_libgit2_init();
 
 	repository_array_t *repos = NULL;
 
 	repo_array_init(&repos);
 
+	(void)alloc_set_tag(ALLOC_REPOS);
 	ret = get_repos_array(repos, &settings);
 	if (ret != OK) { goto clean; }
+	(void)alloc_set_tag(ALLOC_WALK);
 
 	repository_stats_t repos_stats = get_repos_stats(repos);
 
+	if (str_not_empty(settings.serve_path)) {
+		ret = serve_queries(repos, &settings, repos_stats);
+		goto clean;
+	}
+
 	ret = walk_through_repos(repos, &settings, repos_stats);
 	if (ret != OK) { goto clean; }
 
 clean:
+	repo_array_free(&repos);
 	git_libgit2_shutdown();
+	alloc_shutdown();
 
 end:
 	return ret;
@@ -19,6 +19,7 @@
  * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
  */
 
+#include "alloc.h"
 #include "codes.h"
 #include "commit.h"
 #include "log.h"
@@ -40,83 +41,123 @@
 #define GITLAB_URL      "-/commit/"
 #define GITLAB_URL_SIZE 9
 
-static str_t time_to_full_string(time_t timestamp)
+/* ctime_r writes exactly 26 bytes, the last two being "\n\0" */
+static size_t time_to_full_string(char *buf, size_t size, time_t timestamp)
 {
-	const char *date = ctime(&timestamp);
-	return str_init(date, (uint16_t) strlen(date) - 1);
+	char date[26];
+
+	if (!ctime_r(&timestamp, date)) {
+		buf[0] = '\0';
+		return 0;
+	}
+	const int len = snprintf(buf, size, "%.*s", (int)strcspn(date, "\n"), date);
+	return len < 0 ? 0 : (size_t)len < size ? (size_t)len : size - 1;
 }
 
-static str_t time_to_date_string(time_t timestamp)
+static size_t time_to_date_string(char *buf, size_t size, time_t timestamp)
 {
 	struct tm tm_info;
-	static char buffer[DATE_PATTERN_SIZE];
 
 	gmtime_r(&timestamp, &tm_info);
-	strftime(buffer, sizeof(buffer), DATE_PATTERN, &tm_info);
+	return strftime(buf, size, DATE_PATTERN, &tm_info);
+}
 
-	return str_init(buffer, strlen(buffer));
+size_t format_date_into(char *buf, size_t size, time_t timestamp, bool date_only)
+{
+	return date_only
+		   ? time_to_date_string(buf, size, timestamp)
+		   : time_to_full_string(buf, size, timestamp);
 }
 
 str_t format_date(time_t timestamp, bool date_only)
 {
-	return date_only
-		   ? time_to_date_string(timestamp)
-		   : time_to_full_string(timestamp);
+	char buf[DATE_BUF_SIZE];
+	const size_t len = format_date_into(buf, sizeof(buf), timestamp, date_only);
+	return str_init(buf, (uint16_t)len);
 }
 
 static str_t get_commit_url(str_t repo_url, str_t commit_hash, str_t provider_url)
 {
 	/* Adding one for the NULL terminator */
 	const size_t new_len = repo_url.len + provider_url.len + GIT_HASH_LEN + 1;
-	char *url = malloc(new_len * sizeof(char));
+	char *url = tur_malloc(new_len * sizeof(char));
 	snprintf(url, new_len, "%s%s%s", repo_url.val, provider_url.val, commit_hash.val);
 
-	return str_init(url, new_len);
+	str_t commit_url = str_init(url, new_len);
+	tur_free(url);
+	return commit_url;
 }
 
 str_t get_github_commit_url(str_t repo_url, str_t commit_hash)
 {
-	return get_commit_url(repo_url, commit_hash, str_init(GITHUB_URL, GITHUB_URL_SIZE));
+	return get_commit_url(repo_url, commit_hash, STR_VIEW(GITHUB_URL, GITHUB_URL_SIZE));
 }
 
 str_t get_gitlab_commit_url(str_t repo_url, str_t commit_hash)
 {
-	return get_commit_url(repo_url, commit_hash, str_init(GITLAB_URL, GITLAB_URL_SIZE));
+	return get_commit_url(repo_url, commit_hash, STR_VIEW(GITLAB_URL, GITLAB_URL_SIZE));
 }
 
 str_t get_raw_url(str_t repo_url, str_t commit_hash)
 {
-	return get_commit_url(repo_url, commit_hash, empty_str());
+	return get_commit_url(repo_url, commit_hash, STR_VIEW("", 0));
 }
 
-str_t get_first_line(str_t input)
+str_t get_commit_path(str_t repo_url)
+{
+	if (str_contains_chars(repo_url, "github.com")) { return STR_VIEW(GITHUB_URL, GITHUB_URL_SIZE); }
+	if (str_contains_chars(repo_url, "gitlab")) { return STR_VIEW(GITLAB_URL, GITLAB_URL_SIZE); }
+	return STR_VIEW("", 0);
+}
+
+str_t first_line_view(str_t input)
 {
-	char output[4096];
+	const char *newline = input.len ? memchr(input.val, '\n', input.len) : NULL;
+	return STR_VIEW(input.val, newline ? (uint16_t)(newline - input.val) : input.len);
+}
 
+str_t get_first_line(str_t input)
+{
 	if (input.len == 0) { return empty_str(); }
-	
-	size_t len = strcspn(input.val, "\n");
-	if (len >= input.len) {
-		len = input.len;
+
+	const str_t line = first_line_view(input);
+	return str_init(line.val, line.len);
+}
+
+str_t render_escaped(render_buf_t *buf, str_t input)
+{
+	const size_t size = sizeof(buf->text);
+	size_t j = 0;
+
+	for (uint16_t i = 0; i < input.len; i++) {
+		const bool special = input.val[i] == '_' || input.val[i] == '#';
+		/* Never split an escape sequence when the buffer is full */
+		if (j + (special ? 2 : 1) >= size) { break; }
+		if (special) {
+			buf->text[j++] = '\\';
+		}
+		buf->text[j++] = input.val[i];
 	}
-	
-	memcpy(output, input.val, len);
-	output[len] = '\0';
+	buf->text[j] = '\0';
 
-	return str_init(output, len);
+	return STR_VIEW(buf->text, (uint16_t)j);
 }
 
 char* trim_whitespace(const char *str)
 {
 	while (isspace((unsigned char)*str)) str++;
 	
-	if (*str == '\0') { return strdup(""); }
+	if (*str == '\0') {
+		char *empty = tur_malloc(1);
+		if (empty) { *empty = '\0'; }
+		return empty;
+	}
 	
 	const char *end = str + strlen(str) - 1;
 	while (end > str && isspace((unsigned char)*end)) end--;
 	
 	size_t len = end - str + 1;
-	char *trimmed = (char*)malloc(len + 1);
+	char *trimmed = (char*)tur_malloc(len + 1);
 	if (!trimmed) { return NULL; }
 	
 	strncpy(trimmed, str, len);
@@ -135,7 +176,7 @@ str_t escape_special_chars(str_t input)
 	}
 	
 	uint16_t new_len = input.len + extra_chars;
-	char *escaped_str = malloc(new_len + 1);
+	char *escaped_str = tur_malloc(new_len + 1);
 	if (!escaped_str) {
 		(void)log_err("escape_special_chars: memory allocation failed\n");
 		return empty_str();
@@ -151,7 +192,7 @@ str_t escape_special_chars(str_t input)
 	escaped_str[j] = '\0';
 	
 	str_t escaped_string = str_init(escaped_str, new_len);
-	free(escaped_str);
+	tur_free(escaped_str);
 
 	return escaped_string;
 }
@@ -181,3 +222,63 @@ return_code_t parse_commit_id(unsigned *id, const char *line)
 	*id = (unsigned)val;
 	return OK;
 }
+
+static bool budget_key_is(const char *key, size_t len, const char *name)
+{
+	return len == strlen(name) && strncmp(key, name, len) == 0;
+}
+
+return_code_t parse_budget(walk_budget_t *budget, const char *str, size_t len)
+{
+	const char *end = str + len;
+	walk_budget_t parsed;
+
+	if (!budget || !str) { return NULL_PARAMETER; }
+
+	parsed = *budget;
+	while (str < end) {
+		const char *comma = memchr(str, ',', (size_t)(end - str));
+		const char *item_end = comma ? comma : end;
+		const char *eq = memchr(str, '=', (size_t)(item_end - str));
+		size_t *field, value = 0;
+
+		if (!eq || eq + 1 == item_end) { return UNSUPPORTED_VALUE; }
+
+		if (budget_key_is(str, (size_t)(eq - str), "time")) {
+			field = &parsed.max_seconds;
+		} else if (budget_key_is(str, (size_t)(eq - str), "commits")) {
+			field = &parsed.max_commits;
+		} else if (budget_key_is(str, (size_t)(eq - str), "diffs")) {
+			field = &parsed.max_diffs;
+		} else {
+			return UNSUPPORTED_VALUE;
+		}
+
+		for (const char *p = eq + 1; p < item_end; p++) {
+			if (!isdigit((unsigned char)*p)) { return UNSUPPORTED_VALUE; }
+			if (value > (BUDGET_UNLIMITED - 10) / 10) { return INT_OVERFLOW; }
+			value = value * 10 + (size_t)(*p - '0');
+		}
+		*field = value == 0 ? BUDGET_UNLIMITED : value;
+
+		str = comma ? comma + 1 : end;
+	}
+
+	*budget = parsed;
+	return OK;
+}
+
+static size_t merge_budget_field(size_t global, size_t entry)
+{
+	const size_t value = entry ? entry : global;
+	return value == BUDGET_UNLIMITED ? 0 : value;
+}
+
+walk_budget_t merge_budgets(const walk_budget_t *global, const walk_budget_t *entry)
+{
+	return (walk_budget_t) {
+		.max_seconds = merge_budget_field(global->max_seconds, entry->max_seconds),
+		.max_commits = merge_budget_field(global->max_commits, entry->max_commits),
+		.max_diffs = merge_budget_field(global->max_diffs, entry->max_diffs),
+	};
+}
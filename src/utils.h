@@ -38,15 +38,40 @@
 #define ASCII_SPACE       32
 #define DATE_PATTERN      "%b %d, %Y"
 #define DATE_PATTERN_SIZE 13 /* Mar 10, 2025 */
+#define DATE_BUF_SIZE     32
+#define TEXT_BUF_SIZE     4096
+
+/* A string that points into memory owned by someone else.
+ * !!! DO NOT FREE IT !!!
+ */
+#define STR_VIEW(v, l) ((str_t) { .val = (v), .len = (l) })
+
+/* Scratch space reused by the renderers for every commit. render_escaped
+ * formats into it and returns a view of the result, valid until the next
+ * call on the same buffer: rendering a commit needs no allocation. */
+typedef struct {
+	char text[TEXT_BUF_SIZE];
+} render_buf_t;
 
 str_t format_date(time_t timestamp, bool date_only);
+size_t format_date_into(char *buf, size_t size, time_t timestamp, bool date_only);
 str_t get_github_commit_url(str_t repo_url, str_t commit_hash);
 str_t get_gitlab_commit_url(str_t repo_url, str_t commit_hash);
 str_t get_raw_url(str_t repo_url, str_t commit_hash);
+str_t get_commit_path(str_t repo_url);
 str_t get_first_line(str_t input);
+str_t first_line_view(str_t input);
+str_t render_escaped(render_buf_t *buf, str_t input);
 char* trim_whitespace(const char *str);
 str_t escape_special_chars(str_t input);
 str_t get_editor_or_default(void);
 return_code_t parse_commit_id(unsigned *id, const char *line);
+/* Parses a comma-separated list of limits, e.g. "time=60,commits=100000,diffs=5000",
+ * into `budget`, whose other fields are left as they are. A value of 0 is
+ * stored as BUDGET_UNLIMITED. On error, `budget` is not modified. */
+return_code_t parse_budget(walk_budget_t *budget, const char *str, size_t len);
+/* The fields set in `entry` override the ones of `global`. In the result,
+ * zero means unlimited. */
+walk_budget_t merge_budgets(const walk_budget_t *global, const walk_budget_t *entry);
 
 #endif /* __UTILS_H__ */
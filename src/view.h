@@ -24,10 +24,47 @@
 
 #include "repo.h"
 #include "settings.h"
+#include "sink.h"
 
-void print_stdout(const repository_array_t *repos, const settings_t *settings, repository_stats_t stats);
-void generate_latex_file(FILE *out, const repository_array_t *repos, const settings_t *settings);
-void generate_html_file(FILE *out, const repository_array_t *repos, const settings_t *settings);
-void generate_markdown_file(FILE *out, const repository_array_t *repos, const settings_t *settings);
+/* In grouped mode `sections` may hold, in .rlist order, the section of every
+ * repository already rendered by the *_section functions: the sections are
+ * then copied as they are. Pass NULL to render everything in place. */
+void print_stdout(sink_t *out, const repository_array_t *repos, const settings_t *settings,
+				  repository_stats_t stats, const sink_t *sections);
+void generate_latex_file(sink_t *out, const repository_array_t *repos,
+						 const settings_t *settings, const sink_t *sections);
+void generate_html_file(sink_t *out, const repository_array_t *repos,
+						const settings_t *settings, const sink_t *sections);
+void generate_markdown_file(sink_t *out, const repository_array_t *repos,
+							const settings_t *settings, const sink_t *sections);
+void generate_json_file(sink_t *out, const repository_array_t *repos,
+						const settings_t *settings, const sink_t *sections);
+void generate_ndjson_file(sink_t *out, const repository_array_t *repos,
+						  const settings_t *settings, const sink_t *sections);
+/* Writes CSV or TSV, depending on settings->output_mode */
+void generate_csv_file(sink_t *out, const repository_array_t *repos,
+					   const settings_t *settings, const sink_t *sections);
+/* Binary columnar export, see columnar.h. It has no sections. */
+void generate_columnar_file(sink_t *out, const repository_array_t *repos,
+							const settings_t *settings, const sink_t *sections);
+
+/* Everything the output file has before the first repository */
+void generate_latex_header(sink_t *out, const settings_t *settings);
+void generate_html_header(sink_t *out, const settings_t *settings);
+void generate_markdown_header(sink_t *out, const settings_t *settings);
+void generate_json_header(sink_t *out, const settings_t *settings);
+void generate_csv_header(sink_t *out, const settings_t *settings);
+
+/* Everything the output file has after the last repository */
+void generate_json_footer(sink_t *out, const settings_t *settings);
+
+/* Grouped section of a single repository */
+void print_stdout_section(sink_t *out, const repository_t *repo, const settings_t *settings);
+void generate_latex_section(sink_t *out, const repository_t *repo, const settings_t *settings);
+void generate_html_section(sink_t *out, const repository_t *repo, const settings_t *settings);
+void generate_markdown_section(sink_t *out, const repository_t *repo, const settings_t *settings);
+void generate_json_section(sink_t *out, const repository_t *repo, const settings_t *settings);
+void generate_ndjson_section(sink_t *out, const repository_t *repo, const settings_t *settings);
+void generate_csv_section(sink_t *out, const repository_t *repo, const settings_t *settings);
 
 #endif /* __VIEW_H__ */
@@ -19,68 +19,59 @@
  * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
  */
 
+#include "alloc.h"
 #include "cache.h"
 #include "codes.h"
 #include "commit.h"
 #include "editor.h"
 #include "log.h"
+#include "profile.h"
+#include "progress.h"
 #include "repo.h"
 #include "settings.h"
+#include "sink.h"
+#include "sort.h"
+#include "trace.h"
+#include "utils.h"
 #include "view.h"
 #include "walk.h"
 
+#include <errno.h>
 #include <pthread.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
 
-typedef int (*ord_fn_t) (const void* a, const void* b);
-
 #define REPO_STAT_LOG_STR "%-5lu commits in %-*s  +%lu | -%lu  " \
-						  "[AVG +%.2f | -%.2f]  ~%s\n"
+						  "[AVG +%.2f | -%.2f]  ~%s%s\n"
 #define FLOAT_AVG(x,y) ((float) ((float) x / (y)))
+#define REFS_SUMMARY_SIZE 256
+#define ADAPTIVE_INTERVAL_MS 500
+/* Relative drop of commits/s that makes the controller reverse */
+#define ADAPTIVE_TOLERANCE 0.05
 
 static thread_pool_t pool;
 
-static int order_by_date_asc(const void* a, const void* b)
-{
-	commit_t **first = (commit_t **)a;
-	commit_t **second = (commit_t **)b;
-
-	if ((*first)->date == (*second)->date) { return 0; }
-	return (*first)->date < (*second)->date ? -1 : 1;
-}
-
-static int order_by_date_desc(const void* a, const void* b)
+static uint32_t *get_commit_refs(const commit_table_t *commits,
+								 size_t commit_with_resp,
+								 responsability_t resp,
+								 const settings_t *settings)
 {
-	return -order_by_date_asc(a,b);
-}
+	uint32_t *commits_with_resp = tur_malloc(commit_with_resp * sizeof(uint32_t));
+	if (!commits_with_resp) { return NULL; }
 
-static commit_t **get_commit_refs(const commit_arr_t *commit_arr,
-								  size_t commit_with_resp,
-								  responsability_t resp,
-								  const settings_t *settings)
-{
-	commit_t **commits_with_resp = malloc(commit_with_resp * sizeof(commit_t *));
-	for (size_t i = 0, n_resp = 0; i < commit_arr->len; i++) {
-		commit_t *commit = commit_array_get(commit_arr, i);
-		if (commit->responsability == resp) {
-			commits_with_resp[n_resp] = commit;
-			n_resp++;
-		}
-	}
+	(void)commit_table_select(commits, resp, commits_with_resp);
 	if (settings->sorted) {
-		ord_fn_t ord_fn = settings->sort_order == ASC
-						  ? order_by_date_asc
-						  : order_by_date_desc;
-		qsort(commits_with_resp,
-			  commit_with_resp,
-			  sizeof(commit_t *),
-			  ord_fn);
+		(void)sort_rows_by_date(commits_with_resp,
+								commit_with_resp,
+								commits->dates,
+								settings->sort_order);
 	}
 
 	return commits_with_resp;
 }
+
 static bool non_cached_non_inter(const settings_t *settings)
 {
 	return settings->no_cache && !settings->interactive;
@@ -94,12 +85,12 @@ static bool cached_or_inter(const settings_t *settings)
 static return_code_t build_indexes(repository_t *repo,
 								   const settings_t *settings)
 {
-	commit_t **authored = get_commit_refs(repo->history->commit_arr,
-										  repo->history->n_authored,
-										  AUTHORED, settings);
-	commit_t **co_authored = get_commit_refs(repo->history->commit_arr,
-											 repo->history->n_co_authored,
-											 CO_AUTHORED, settings);
+	uint32_t *authored = get_commit_refs(&repo->history->commits,
+										 repo->history->n_authored,
+										 AUTHORED, settings);
+	uint32_t *co_authored = get_commit_refs(&repo->history->commits,
+											repo->history->n_co_authored,
+											CO_AUTHORED, settings);
 
 	repo->history->indexes.authored = authored;
 	repo->history->indexes.co_authored = co_authored;
@@ -110,101 +101,654 @@ static return_code_t build_indexes(repository_t *repo,
 	return OK;
 }
 
-static void print_output(const repository_array_t *repos,
-						 const settings_t *settings,
-						 repository_stats_t stats)
+static section_renderer_t get_section_renderer(tur_output_t output_mode)
 {
-	if (settings->output_mode == STDOUT) {
-		print_stdout(repos, settings, stats);
+	switch (output_mode) {
+	case STDOUT:
+		return print_stdout_section;
+	case LATEX:
+		return generate_latex_section;
+	case HTML:
+		return generate_html_section;
+	case JEKYLL:
+		return generate_markdown_section;
+	case JSON:
+		return generate_json_section;
+	case NDJSON:
+		return generate_ndjson_section;
+	case CSV:
+	case TSV:
+		return generate_csv_section;
+	default:
+		return NULL;
+	}
+}
+
+static inline profile_t *worker_profile(size_t n_worker)
+{
+	return pool.profiles ? pool.profiles + n_worker : NULL;
+}
+
+static void render_worker_section(size_t n_worker)
+{
+	sink_t *section = pool.sections + n_worker;
+	profile_t *profile = worker_profile(n_worker);
+	uint64_t timer = profile_start(profile);
+	const uint64_t span = trace_begin();
+	const alloc_tag_t tag = alloc_set_tag(ALLOC_RENDER);
+
+	if (sink_init_memory(section) != OK) {
+		(void)alloc_set_tag(tag);
 		return;
 	}
+	pool.render_section(section, pool.workers[n_worker].repo, pool.settings);
+	(void)alloc_set_tag(tag);
+	trace_end("render", span, pool.workers[n_worker].repo->name.val, 0);
+	profile_lap(profile, PROFILE_RENDER, &timer);
+	profile_count(profile, PROFILE_BYTES, sink_size(section));
+}
+
+static header_renderer_t get_header_renderer(tur_output_t output_mode)
+{
+	switch (output_mode) {
+	case LATEX:
+		return generate_latex_header;
+	case HTML:
+		return generate_html_header;
+	case JEKYLL:
+		return generate_markdown_header;
+	case JSON:
+		return generate_json_header;
+	case CSV:
+	case TSV:
+		return generate_csv_header;
+	default:
+		return NULL;
+	}
+}
+
+static header_renderer_t get_footer_renderer(tur_output_t output_mode)
+{
+	return output_mode == JSON ? generate_json_footer : NULL;
+}
+
+static return_code_t worker_queue_init(worker_queue_t *queue, size_t capacity)
+{
+	queue->items = tur_malloc(capacity * sizeof(size_t));
+	if (!queue->items) { return RUNTIME_MALLOC_ERROR; }
+	queue->capacity = capacity;
+	queue->head = 0;
+	queue->len = 0;
+	pthread_mutex_init(&queue->lock, NULL);
+	pthread_cond_init(&queue->not_empty, NULL);
+	pthread_cond_init(&queue->not_full, NULL);
+	return OK;
+}
+
+static void worker_queue_push(worker_queue_t *queue, size_t n_worker)
+{
+	pthread_mutex_lock(&queue->lock);
+	while (queue->len == queue->capacity) {
+		pthread_cond_wait(&queue->not_full, &queue->lock);
+	}
+	queue->items[(queue->head + queue->len) % queue->capacity] = n_worker;
+	queue->len++;
+	pthread_cond_signal(&queue->not_empty);
+	pthread_mutex_unlock(&queue->lock);
+}
+
+static size_t worker_queue_pop(worker_queue_t *queue)
+{
+	pthread_mutex_lock(&queue->lock);
+	while (queue->len == 0) {
+		pthread_cond_wait(&queue->not_empty, &queue->lock);
+	}
+	const size_t n_worker = queue->items[queue->head];
+	queue->head = (queue->head + 1) % queue->capacity;
+	queue->len--;
+	pthread_cond_signal(&queue->not_full);
+	pthread_mutex_unlock(&queue->lock);
+	return n_worker;
+}
+
+static void worker_queue_free(worker_queue_t *queue)
+{
+	if (!queue->items) { return; }
+	tur_free(queue->items);
+	queue->items = NULL;
+	pthread_mutex_destroy(&queue->lock);
+	pthread_cond_destroy(&queue->not_empty);
+	pthread_cond_destroy(&queue->not_full);
+}
+
+static void *render_repo(void *arg)
+{
+	size_t n_worker;
+
+	trace_thread_name("render #%zu", (size_t)(uintptr_t)arg);
+
+	while (1) {
+		pthread_mutex_lock(&pool.current_worker_lock);
+		if (pool.current_worker >= pool.n_workers) {
+			pthread_mutex_unlock(&pool.current_worker_lock);
+			break;
+		}
+		n_worker = pool.current_worker;
+		pool.current_worker++;
+		pthread_mutex_unlock(&pool.current_worker_lock);
+
+		render_worker_section(n_worker);
+	}
+
+	return NULL;
+}
+
+/* Renders the sections the walk could not render, i.e. all of them when the
+ * indexes have been rebuilt from the commits file, spreading them over the
+ * pool threads. */
+static void render_sections(void)
+{
+	size_t n_threads = 0;
+
+	if (!pool.sections || pool.render_in_walk) { return; }
+
+	pool.current_worker = 0;
+	for (; n_threads < pool.n_threads; n_threads++) {
+		if (pthread_create(pool.threads + n_threads, NULL, render_repo,
+						   (void *)(uintptr_t)n_threads) != 0) {
+			(void)log_err("render_sections: cannot create thread #%zu\n", n_threads);
+			break;
+		}
+	}
+
+	for (size_t i = 0; i < n_threads; i++) {
+		pthread_join(pool.threads[i], NULL);
+	}
+}
+
+static void free_sections(void)
+{
+	if (!pool.sections) { return; }
+
+	for (size_t i = 0; i < pool.n_workers; i++) {
+		if (pool.sections[i].kind == SINK_MEMORY) {
+			(void)sink_close(pool.sections + i);
+		}
+	}
+	tur_free(pool.sections);
+	pool.sections = NULL;
+}
+
+/* Returns the rendered sections if every one of them is complete; otherwise
+ * they are released and the output is rendered in place. */
+static const sink_t *collect_sections(void)
+{
+	if (!pool.sections) { return NULL; }
+
+	for (size_t i = 0; i < pool.n_workers; i++) {
+		if (pool.sections[i].kind != SINK_MEMORY || pool.sections[i].ret != OK) {
+			(void)log_err("collect_sections: section #%zu has not been rendered, "
+						  "rendering the output sequentially\n", i);
+			free_sections();
+			return NULL;
+		}
+	}
+
+	return pool.sections;
+}
+
+static return_code_t open_output(sink_t *out, const settings_t *settings)
+{
+	if (settings->output_mode == STDOUT) {
+		/* Anything already buffered by stdio must come first */
+		fflush(stdout);
+		return sink_init_fd(out, STDOUT_FILENO);
+	}
 
-	FILE *out = fopen(settings->output.val, "w");
-	if (!out) {
-		(void)log_err("print_output: cannot open file: %s\n",
+	if (sink_init_file(out, settings->output.val, settings->mmap_output) != OK) {
+		(void)log_err("open_output: cannot open file: %s\n",
 					  settings->output.val);
-		return;
+		return CANNOT_OPEN_OUTPUT;
+	}
+
+	return OK;
+}
+
+static void close_output(sink_t *out, const settings_t *settings)
+{
+	if (sink_close(out) != OK && settings->output_mode != STDOUT) {
+		(void)log_err("close_output: cannot write file: %s\n",
+					  settings->output.val);
+	}
+}
+
+/* Writes the section of a worker whose walk is over and releases it. A
+ * section that could not be rendered ahead is rendered here, while a
+ * failed walk has nothing to write. */
+static void emit_section(sink_t *out, size_t n_worker)
+{
+	sink_t *section = pool.sections + n_worker;
+
+	if (pool.workers[n_worker].ret == OK) {
+		if (section->kind == SINK_MEMORY && section->ret == OK) {
+			sink_write(out, section->buf, section->len);
+		} else {
+			pool.render_section(out, pool.workers[n_worker].repo, pool.settings);
+		}
+	}
+
+	if (section->kind == SINK_MEMORY) { (void)sink_close(section); }
+	*section = (sink_t) { 0 };
+}
+
+/* Streaming writer: workers finish in any order, so a section is emitted
+ * only once every section before it in the .rlist has been emitted. The
+ * output is flushed after each run of sections, so the first repository
+ * shows up as soon as it has been walked. */
+static void *stream_output(void *arg)
+{
+	bool *walked = arg;
+	size_t next = 0;
+	sink_t out;
+	const bool opened = open_output(&out, pool.settings) == OK;
+	profile_t *profile = pool.profiles ? &pool.run_profile : NULL;
+	uint64_t timer = profile_start(profile);
+	uint64_t span;
+
+	trace_thread_name("writer");
+	(void)alloc_set_tag(ALLOC_RENDER);
+
+	if (opened && pool.render_header) {
+		pool.render_header(&out, pool.settings);
+		(void)sink_flush(&out);
+	}
+
+	/* Every worker must be popped even if the output is unusable, since
+	 * the workers block on a full queue */
+	for (size_t n = 0; n < pool.n_workers; n++) {
+		walked[worker_queue_pop(&pool.finished)] = true;
+		if (!opened) { continue; }
+
+		/* Only the time spent writing counts, not the wait */
+		timer = profile_start(profile);
+		span = trace_begin();
+		const size_t first = next;
+		for (; next < pool.n_workers && walked[next]; next++) {
+			emit_section(&out, next);
+		}
+		if (next > first) {
+			(void)sink_flush(&out);
+			trace_end("write", span, NULL, (uint32_t)(next - first));
+		}
+		profile_lap(profile, PROFILE_OUTPUT, &timer);
 	}
 
+	if (opened && pool.render_footer) {
+		pool.render_footer(&out, pool.settings);
+	}
+	if (opened) {
+		profile_count(profile, PROFILE_BYTES, sink_size(&out));
+		close_output(&out, pool.settings);
+		profile_lap(profile, PROFILE_OUTPUT, &timer);
+	}
+
+	return NULL;
+}
+
+void render_output(sink_t *out, const repository_array_t *repos,
+				   const settings_t *settings, repository_stats_t stats,
+				   const sink_t *sections)
+{
 	switch (settings->output_mode) {
+	case STDOUT:
+		print_stdout(out, repos, settings, stats, sections);
+		break;
 	case LATEX:
-		generate_latex_file(out, repos, settings);
+		generate_latex_file(out, repos, settings, sections);
 		break;
 	case HTML:
-		generate_html_file(out, repos, settings);
+		generate_html_file(out, repos, settings, sections);
 		break;
 	case JEKYLL:
-		generate_markdown_file(out, repos, settings);
+		generate_markdown_file(out, repos, settings, sections);
+		break;
+	case JSON:
+		generate_json_file(out, repos, settings, sections);
+		break;
+	case NDJSON:
+		generate_ndjson_file(out, repos, settings, sections);
+		break;
+	case CSV:
+	case TSV:
+		generate_csv_file(out, repos, settings, sections);
+		break;
+	case COLUMNAR:
+		generate_columnar_file(out, repos, settings, sections);
 		break;
 	default:
 		(void)log_err("corrupted output mode [%d]... stdout selected",
 					  settings->output_mode);
 		break;
 	}
+}
+
+/* Returns the number of bytes written */
+static size_t print_output(const repository_array_t *repos,
+						   const settings_t *settings,
+						   repository_stats_t stats)
+{
+	const sink_t *sections = collect_sections();
+	sink_t out;
+
+	if (open_output(&out, settings) != OK) { return 0; }
+
+	render_output(&out, repos, settings, stats, sections);
+
+	if (settings->output_mode == STDOUT) {
+		const size_t written = sink_size(&out);
+		(void)sink_close(&out);
+		return written;
+	}
 
-	fclose(out);
+	const size_t written = sink_size(&out);
+	close_output(&out, settings);
+	return written;
 }
 
-static void *walk_repo(void* arg)
+typedef struct {
+	const repository_array_t *repos;
+	settings_t settings;
+	repository_stats_t stats;
+	size_t written;
+} output_job_t;
+
+static void *print_output_job(void *arg)
 {
-	size_t max_name_len = *(size_t *)arg;
-	thread_worker_t *worker;
+	output_job_t *job = arg;
+	const uint64_t span = trace_begin();
 
-	while (1) {
-		pthread_mutex_lock(&pool.current_worker_lock);
-		if (pool.current_worker >= pool.n_workers) {
-			pthread_mutex_unlock(&pool.current_worker_lock);
-			break;
+	(void)alloc_set_tag(ALLOC_RENDER);
+	job->written = print_output(job->repos, &job->settings, job->stats);
+	trace_end("output", span, job->settings.output.val, 0);
+	return NULL;
+}
+
+/* Every -o target is rendered from the same walk. The renderers only read
+ * the histories, so with more than one thread each target gets its own. */
+static size_t print_outputs(const repository_array_t *repos,
+							 const settings_t *settings,
+							 repository_stats_t stats)
+{
+	output_job_t jobs[MAX_OUTPUTS];
+	pthread_t threads[MAX_OUTPUTS];
+	bool started[MAX_OUTPUTS] = { 0 };
+	size_t written = 0;
+
+	if (settings->n_outputs <= 1) {
+		return print_output(repos, settings, stats);
+	}
+
+	for (size_t i = 0; i < settings->n_outputs; i++) {
+		jobs[i] = (output_job_t) { .repos = repos, .settings = *settings, .stats = stats };
+		jobs[i].settings.output = settings->outputs[i].path;
+		jobs[i].settings.output_mode = settings->outputs[i].mode;
+
+		if (settings->n_threads > 1) {
+			/* The spans of each target go to their own thread */
+			started[i] = pthread_create(threads + i, NULL, print_output_job, jobs + i) == 0;
+		}
+		if (!started[i]) {
+			print_output_job(jobs + i);
+		}
+	}
+
+	for (size_t i = 0; i < settings->n_outputs; i++) {
+		if (started[i]) { pthread_join(threads[i], NULL); }
+		written += jobs[i].written;
+	}
+
+	return written;
+}
+
+/* Lists the walked refs, e.g. "main(12) feature/x(3)". Counts are shown only
+ * when more than one ref has been pushed into the walk. */
+static void format_refs_summary(char *buf, size_t size, const work_history_t *history)
+{
+	const str_array_t *refs = history->refs;
+	size_t used = 0;
+
+	buf[0] = '\0';
+	if (!refs || refs->len == 0) { return; }
+
+	if (refs->len == 1) {
+		(void)snprintf(buf, size, "%s", str_array_get(refs, 0).val);
+		return;
+	}
+
+	for (size_t i = 0; i < refs->len; i++) {
+		int n = snprintf(buf + used, size - used, "%s%s(%zu)",
+						 i ? " " : "",
+						 str_array_get(refs, i).val,
+						 history->ref_commits[i]);
+		if (n < 0 || (size_t)n >= size - used) {
+			/* Truncated: mark it at the end of the buffer */
+			(void)snprintf(buf + size - 4, 4, "...");
+			return;
 		}
+		used += (size_t)n;
+	}
+}
+
+static void walk_worker(thread_worker_t *worker, size_t max_name_len)
+{
+	const size_t n_worker = (size_t)(worker - pool.workers);
+	profile_t *profile = worker_profile(n_worker);
+	uint64_t span = trace_begin();
+	const walk_budget_t budget = merge_budgets(&pool.settings->budget, &worker->repo->budget);
+
+	worker->repo->history = get_commit_history(worker->repo->path,
+											   worker->repo->branches,
+											   pool.settings,
+											   &budget,
+											   profile);
+	trace_end("walk", span, worker->repo->name.val, 0);
+	if (!worker->repo->history) {
+		worker->ret = RUNTIME_MALLOC_ERROR;
+		(void)log_err("walk_repo: cannot retrieve commit history for %s\n",
+					  worker->repo->name.val);
+		return;
+	}
+	uint64_t timer = profile_start(profile);
+	span = trace_begin();
+	worker->ret = build_indexes(worker->repo, pool.settings);
+	trace_end("index", span, worker->repo->name.val, 0);
+	profile_lap(profile, PROFILE_INDEX, &timer);
+	if (worker->ret == OK && pool.sections && pool.render_in_walk) {
+		render_worker_section(n_worker);
+	}
+
+	/* Print log with stats */
+	const size_t n_commits = worker->repo->history->commits.len;
+	const size_t lines_added = worker->repo->history->tot_lines_added;
+	const size_t lines_removed = worker->repo->history->tot_lines_removed;
+	char refs_summary[REFS_SUMMARY_SIZE];
+	format_refs_summary(refs_summary, sizeof(refs_summary), worker->repo->history);
+	(void)log_info(REPO_STAT_LOG_STR,
+				   n_commits,
+				   max_name_len,
+				   worker->repo->name.val,
+				   lines_added,
+				   lines_removed,
+				   FLOAT_AVG(lines_added, n_commits),
+				   FLOAT_AVG(lines_removed, n_commits),
+				   refs_summary,
+				   truncation_note(worker->repo->history->truncated));
+}
+
+/* Takes the next repository to walk, or returns NULL when there is none
+ * left. In adaptive mode, threads beyond the active limit park here. */
+static thread_worker_t *next_worker(size_t n_thread)
+{
+	thread_worker_t *worker = NULL;
+
+	pthread_mutex_lock(&pool.current_worker_lock);
+	while (pool.adaptive
+		   && n_thread >= pool.active_threads
+		   && pool.current_worker < pool.n_workers) {
+		pthread_cond_wait(&pool.resized, &pool.current_worker_lock);
+	}
+	if (pool.current_worker < pool.n_workers) {
 		worker = pool.workers + pool.current_worker;
 		pool.current_worker++;
-		pthread_mutex_unlock(&pool.current_worker_lock);
+		if (pool.adaptive && pool.current_worker == pool.n_workers) {
+			/* Release the parked threads and the controller */
+			pthread_cond_broadcast(&pool.resized);
+		}
+	}
+	pthread_mutex_unlock(&pool.current_worker_lock);
+
+	return worker;
+}
+
+static void *walk_repo(void* arg)
+{
+	const size_t n_thread = (size_t)(uintptr_t)arg;
+	thread_worker_t *worker;
 
-		const char *branch_name = worker->repo->branches
-								  ? str_array_get(worker->repo->branches, 0).val
-								  : NULL;
-
-		worker->repo->history = get_commit_history(worker->repo->path,
-												   branch_name, pool.settings);
-		if (!worker->repo->history) {
-			worker->ret = RUNTIME_MALLOC_ERROR;
-			(void)log_err("walk_repo: cannot retrieve commit history for %s\n",
-						  worker->repo->name.val);
-			continue;
+	trace_thread_name("worker #%zu", n_thread);
+	(void)alloc_set_tag(ALLOC_WALK);
+	progress_attach(n_thread);
+
+	while ((worker = next_worker(n_thread))) {
+		progress_begin_repo(worker->repo->name.val);
+		walk_worker(worker, pool.max_name_len);
+		progress_end_repo();
+		if (pool.streaming) {
+			worker_queue_push(&pool.finished, (size_t)(worker - pool.workers));
 		}
-		worker->ret = build_indexes(worker->repo, pool.settings);
-
-		/* Print log with stats */
-		const size_t n_commits = worker->repo->history->commit_arr->len;
-		const size_t lines_added = worker->repo->history->tot_lines_added;
-		const size_t lines_removed = worker->repo->history->tot_lines_removed;
-		(void)log_info(REPO_STAT_LOG_STR,
-					   n_commits,
-					   max_name_len,
-					   worker->repo->name.val,
-					   lines_added,
-					   lines_removed,
-					   FLOAT_AVG(lines_added, n_commits),
-					   FLOAT_AVG(lines_removed, n_commits),
-					   branch_name ? branch_name : "HEAD");
 	}
 	
 	return NULL;
 }
 
+/* Hill climbing on the number of active threads: every interval the
+ * controller compares the commits/s with the previous interval, keeps
+ * moving in the same direction while the rate holds, and reverses when it
+ * drops. It stops once every repository has been taken. */
+static void *control_threads(void *arg)
+{
+	size_t last_walked = progress_visited();
+	double last_rate = 0.0, peak_rate = 0.0;
+	int direction = 1;
+	struct timespec deadline;
+	(void)arg;
+
+	pthread_mutex_lock(&pool.current_worker_lock);
+	while (pool.current_worker < pool.n_workers) {
+		clock_gettime(CLOCK_REALTIME, &deadline);
+		deadline.tv_nsec += (long)ADAPTIVE_INTERVAL_MS * 1000000L;
+		deadline.tv_sec += deadline.tv_nsec / 1000000000L;
+		deadline.tv_nsec %= 1000000000L;
+
+		int wait = 0;
+		while (pool.current_worker < pool.n_workers && wait != ETIMEDOUT) {
+			wait = pthread_cond_timedwait(&pool.resized, &pool.current_worker_lock, &deadline);
+		}
+		if (pool.current_worker >= pool.n_workers) { break; }
+
+		const size_t walked = progress_visited();
+		const double rate = (double)(walked - last_walked) * 1000.0 / ADAPTIVE_INTERVAL_MS;
+		last_walked = walked;
+		if (rate > peak_rate) { peak_rate = rate; }
+
+		if (rate < last_rate * (1.0 - ADAPTIVE_TOLERANCE)) {
+			direction = -direction;
+		}
+		last_rate = rate;
+
+		if ((direction < 0 && pool.active_threads == 1)
+			|| (direction > 0 && pool.active_threads == pool.n_threads)) {
+			direction = -direction;
+		}
+		pool.active_threads = direction > 0 ? pool.active_threads + 1 : pool.active_threads - 1;
+		if (direction > 0) {
+			pthread_cond_broadcast(&pool.resized);
+		}
+	}
+	const size_t active_threads = pool.active_threads;
+	pthread_mutex_unlock(&pool.current_worker_lock);
+
+	(void)log_info("Adaptive pool: %zu active threads at the end, peak %.0f commits/s\n",
+				   active_threads, peak_rate);
+	return NULL;
+}
+
 static return_code_t init_thread_pool(const repository_array_t *repos,
 									  const settings_t *settings)
 {
-	pool.threads = malloc(settings->n_threads * sizeof(pthread_t));
+	/* There is no point in having more threads than repositories */
+	size_t n_threads = settings->adaptive_threads
+					   ? settings->n_threads * ADAPTIVE_THREADS_PER_CORE
+					   : settings->n_threads;
+	if (n_threads > MAX_THREADS) { n_threads = MAX_THREADS; }
+	if (n_threads > repos->len) { n_threads = repos->len; }
+	if (n_threads == 0) { n_threads = 1; }
+
+	pool.threads = tur_malloc(n_threads * sizeof(pthread_t));
 	if (!pool.threads) { goto err; }
-	pool.workers = malloc(repos->len * sizeof(thread_worker_t));
+	pool.workers = tur_malloc(repos->len * sizeof(thread_worker_t));
 	if (!pool.workers) { goto err; }
 	pool.settings = settings;
-	pool.n_threads = settings->n_threads;
+	pool.n_threads = n_threads;
 	pool.n_workers = repos->len;
 	pool.current_worker = 0;
 	pthread_mutex_init(&pool.current_worker_lock, NULL);
 
+	pool.adaptive = settings->adaptive_threads && n_threads > 1;
+	pool.active_threads = settings->n_threads < n_threads ? settings->n_threads : n_threads;
+	pthread_cond_init(&pool.resized, NULL);
+
+	/* Rendering the sections concurrently pays off only with more than
+	 * one thread; the list mode merges every repository into one timeline */
+	pool.sections = NULL;
+	pool.render_section = get_section_renderer(settings->output_mode);
+	pool.render_header = get_header_renderer(settings->output_mode);
+	pool.render_footer = get_footer_renderer(settings->output_mode);
+	pool.render_in_walk = non_cached_non_inter(settings);
+	pool.streaming = false;
+	pool.finished.items = NULL;
+	pool.run_profile = (profile_t) { 0 };
+	pool.profiles = NULL;
+	if (settings->print_stats || str_not_empty(settings->profile_path)
+		|| str_not_empty(settings->metrics_path)) {
+		pool.profiles = tur_calloc(repos->len, sizeof(profile_t));
+		if (!pool.profiles) { goto err; }
+	}
+
+	if (settings->n_outputs > 1) {
+		/* Sections are rendered for a single format */
+		pool.render_section = NULL;
+	}
+
+	if (settings->stream_output && settings->n_outputs > 1) {
+		(void)log_info("--stream has no effect with more than one output file\n");
+	} else if (settings->stream_output && !settings->grouped) {
+		(void)log_info("--stream has no effect without -g\n");
+	} else if (settings->stream_output && !pool.render_in_walk) {
+		(void)log_info("--stream requires --no-cache and no interactive mode: "
+					   "the output will be written at the end\n");
+	} else if (settings->stream_output && !pool.render_section) {
+		(void)log_info("--stream is not supported by this output format\n");
+	} else if (settings->stream_output) {
+		pool.streaming = worker_queue_init(&pool.finished, pool.n_threads) == OK;
+	}
+
+	if (settings->grouped && pool.render_section && (pool.n_threads > 1 || pool.streaming)) {
+		/* Zeroed sinks are SINK_FD with no buffer: nothing to release
+		 * until a worker turns them into memory sinks */
+		pool.sections = tur_calloc(repos->len, sizeof(sink_t));
+	}
+
 	return OK;
 
 err:
@@ -212,15 +756,74 @@ err:
 	return RUNTIME_MALLOC_ERROR;
 }
 
+/* Called when only the first `started` threads of the pool have been
+ * created: the walk goes on with them, and the threads are joined as
+ * usual. The adaptive controller never activates more threads than
+ * there are. Without any of them, every repository fails, and each one
+ * is still handed to the streaming writer, which waits for all of them. */
+static void shrink_thread_pool(size_t started)
+{
+	size_t first = 0, last = 0;
+
+	pthread_mutex_lock(&pool.current_worker_lock);
+	pool.n_threads = started;
+	if (pool.active_threads > started) {
+		pool.active_threads = started > 0 ? started : 1;
+	}
+	if (started == 0) {
+		first = pool.current_worker;
+		last = pool.n_workers;
+		for (size_t i = first; i < last; i++) {
+			pool.workers[i].ret = RUNTIME_THREAD_CREATE_ERROR;
+		}
+		pool.current_worker = pool.n_workers;
+		/* The controller stops as soon as every repository is taken */
+		pthread_cond_broadcast(&pool.resized);
+	}
+	pthread_mutex_unlock(&pool.current_worker_lock);
+
+	for (size_t i = first; pool.streaming && i < last; i++) {
+		worker_queue_push(&pool.finished, i);
+	}
+}
+
+static void free_thread_pool(void)
+{
+	tur_free(pool.threads);
+	tur_free(pool.workers);
+	pool.threads = NULL;
+	pool.workers = NULL;
+}
+
+static void write_metrics(const repository_array_t *repos, const settings_t *settings)
+{
+	if (!pool.profiles || !str_not_empty(settings->metrics_path)) { return; }
+
+	return_code_t *errors = tur_malloc(pool.n_workers * sizeof(return_code_t));
+	if (errors) {
+		for (size_t i = 0; i < pool.n_workers; i++) {
+			errors[i] = pool.workers[i].ret;
+		}
+	}
+	(void)profile_write_metrics(settings->metrics_path.val, repos, pool.profiles,
+								&pool.run_profile, errors);
+	tur_free(errors);
+}
+
 static return_code_t cache_commit_list(const repository_array_t *repos,
-									   const settings_t *settings)
+									   const settings_t *settings,
+									   profile_t *profile)
 {
 	return_code_t ret = OK;
 
 	if (cached_or_inter(settings)) {
 		if (settings->force || !commit_file_exists()) {
 			/* We have to create or overwrite the commits file */
+			uint64_t timer = profile_start(profile);
+			const uint64_t span = trace_begin();
 			ret = write_repos_on_file(repos);
+			trace_end("cache write", span, NULL, 0);
+			profile_lap(profile, PROFILE_CACHE, &timer);
 			if (ret != OK) { return ret; }
 		}
 	}
@@ -238,12 +841,40 @@ return_code_t walk_through_repos(const repository_array_t *repos,
 								 repository_stats_t stats)
 {
 	return_code_t ret = OK;
-	size_t max_name_len = stats.max_name_len;
+	const uint64_t start = profile_clock();
+
+	if (str_not_empty(settings->trace_path)) {
+		trace_enable();
+		trace_thread_name("main");
+	}
 
 	ret = init_thread_pool(repos, settings);
 	if (ret != OK) { return RUNTIME_MALLOC_ERROR; }
+	pool.max_name_len = stats.max_name_len;
+	profile_t *run_profile = pool.profiles ? &pool.run_profile : NULL;
+	uint64_t timer, span;
+
+	/* The progress slots count the commits walked, also for the controller */
+	if (progress_start(pool.n_threads, pool.n_workers, settings->progress) != OK) {
+		(void)log_err("walk_through_repos: cannot start the progress reporter\n");
+		if (pool.adaptive) {
+			(void)log_err("walk_through_repos: the adaptive controller needs it, "
+						  "every thread will be active\n");
+			pool.adaptive = false;
+		}
+	}
 
-	(void)log_info("Created thread pool [size %lu]\n", pool.n_threads);
+	if (pool.adaptive && pthread_create(&pool.controller, NULL, control_threads, NULL) != 0) {
+		(void)log_err("walk_through_repos: cannot start the adaptive controller\n");
+		pool.adaptive = false;
+	}
+
+	if (pool.adaptive) {
+		(void)log_info("Created thread pool [size %lu, %lu active at start]\n",
+					   pool.n_threads, pool.active_threads);
+	} else {
+		(void)log_info("Created thread pool [size %lu]\n", pool.n_threads);
+	}
 
 	__sync_synchronize();
 
@@ -255,22 +886,49 @@ return_code_t walk_through_repos(const repository_array_t *repos,
 		};
 	}
 
+	bool *walked = pool.streaming ? tur_calloc(pool.n_workers, sizeof(bool)) : NULL;
+	if (pool.streaming && (!walked || !pool.sections ||
+						   pthread_create(&pool.writer, NULL, stream_output, walked) != 0)) {
+		(void)log_err("walk_through_repos: cannot start the streaming writer, "
+					  "the output will be written at the end\n");
+		pool.streaming = false;
+	}
+
 	for (size_t i = 0; i < pool.n_threads; i++) {
-		if (pthread_create(pool.threads + i, NULL, walk_repo, &max_name_len) != 0) {
+		if (pthread_create(pool.threads + i, NULL, walk_repo, (void *)(uintptr_t)i) != 0) {
 			(void)log_err("walk_through_repos: cannot create thread #%zu\n", i);
-			return RUNTIME_THREAD_CREATE_ERROR;
+			shrink_thread_pool(i);
+			break;
 		}
 	}
 
 	for (size_t i = 0; i < pool.n_threads; i++) {
 		pthread_join(pool.threads[i], NULL);
 	}
+	progress_stop();
+
+	if (pool.adaptive) {
+		pthread_join(pool.controller, NULL);
+	}
+	if (pool.streaming) {
+		pthread_join(pool.writer, NULL);
+	}
+	tur_free(walked);
+	worker_queue_free(&pool.finished);
 
 	for (size_t i = 0; i < pool.n_workers; i++) {
 		if (pool.workers[i].ret != OK) {
 			(void)log_err("walk_through_repos: worker #%zu failed with error code %d",
 						  i, pool.workers[i].ret);
-			return pool.workers[i].ret;
+			free_sections();
+			/* A failed run is exported too, so that it can be alerted on */
+			pool.run_profile.ns[PROFILE_TOTAL] = profile_clock() - start;
+			write_metrics(repos, settings);
+			tur_free(pool.profiles);
+			pool.profiles = NULL;
+			ret = pool.workers[i].ret;
+			free_thread_pool();
+			return ret;
 		}
 	}
 
@@ -288,13 +946,18 @@ return_code_t walk_through_repos(const repository_array_t *repos,
 	 *           * if force == 1, then the index is recalculated and the file overwritten;
 	 *           * otherwise, the file is loaded as is and the index is not recalculated.
 	 */
-	ret = cache_commit_list(repos, settings);
-	if (ret != OK) { goto print_and_exit; }
+	const alloc_tag_t tag = alloc_set_tag(ALLOC_CACHE);
+	ret = cache_commit_list(repos, settings, run_profile);
 
-	if (cached_or_inter(settings)) {
+	if (ret == OK && cached_or_inter(settings)) {
+		timer = profile_start(run_profile);
+		span = trace_begin();
 		ret = rebuild_indexes(repos);
-		if (ret != OK) { goto print_and_exit; }
+		trace_end("cache read", span, NULL, 0);
+		profile_lap(run_profile, PROFILE_CACHE, &timer);
 	}
+	(void)alloc_set_tag(tag);
+	if (ret != OK) { goto print_and_exit; }
 
 	if (settings->no_cache && commit_file_exists()) {
 		(void)log_info("Removing temporary commit file `%s`...\n",
@@ -306,7 +969,41 @@ return_code_t walk_through_repos(const repository_array_t *repos,
 	}
 
 print_and_exit:
-	print_output(repos, settings, stats);
+	if (!pool.streaming) {
+		span = trace_begin();
+		render_sections();
+		if (pool.sections && !pool.render_in_walk) {
+			trace_end("render pass", span, NULL, 0);
+		}
+		timer = profile_start(run_profile);
+		span = trace_begin();
+		const alloc_tag_t main_tag = alloc_set_tag(ALLOC_RENDER);
+		profile_count(run_profile, PROFILE_BYTES, print_outputs(repos, settings, stats));
+		(void)alloc_set_tag(main_tag);
+		trace_end("print", span, NULL, 0);
+		profile_lap(run_profile, PROFILE_OUTPUT, &timer);
+	}
+	free_sections();
+
+	if (str_not_empty(settings->trace_path)) {
+		(void)trace_write(settings->trace_path.val);
+		trace_free();
+	}
+
+	if (run_profile) {
+		run_profile->ns[PROFILE_TOTAL] = profile_clock() - start;
+		if (settings->print_stats) {
+			profile_print_table(repos, pool.profiles, run_profile);
+		}
+		if (str_not_empty(settings->profile_path)) {
+			(void)profile_write_json(settings->profile_path.val, repos,
+									 pool.profiles, run_profile);
+		}
+		write_metrics(repos, settings);
+		tur_free(pool.profiles);
+		pool.profiles = NULL;
+	}
+	free_thread_pool();
 
 	return ret;
 }
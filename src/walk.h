@@ -23,8 +23,10 @@
 #define __WALK_H__
 
 #include "commit.h"
+#include "profile.h"
 #include "repo.h"
 #include"settings.h"
+#include "sink.h"
 
 #include <pthread.h>
 
@@ -35,6 +37,24 @@ typedef struct {
 	uint16_t ret;
 } __attribute__((aligned(64))) thread_worker_t;
 
+typedef void (*section_renderer_t)(sink_t *out,
+								   const repository_t *repo,
+								   const settings_t *settings);
+/* Also used for the footers */
+typedef void (*header_renderer_t)(sink_t *out, const settings_t *settings);
+
+/* Bounded FIFO of the workers whose repository has been walked. Workers
+ * block when it is full, the streaming writer when it is empty. */
+typedef struct {
+	size_t *items;
+	size_t capacity;
+	size_t head;
+	size_t len;
+	pthread_mutex_t lock;
+	pthread_cond_t not_empty;
+	pthread_cond_t not_full;
+} worker_queue_t;
+
 typedef struct {
 	size_t n_threads;
 	size_t n_workers;
@@ -43,10 +63,43 @@ typedef struct {
 	size_t current_worker;
 	pthread_mutex_t current_worker_lock;
 	const settings_t *settings;
+	size_t max_name_len;
+	/* -j auto: threads whose index is not below active_threads wait on
+	 * `resized` before taking another repository, while the controller
+	 * moves the limit following the measured commits/s */
+	bool adaptive;
+	size_t active_threads;
+	pthread_cond_t resized;
+	pthread_t controller;
+	/* Grouped output only: one memory sink per repository, rendered by
+	 * the worker that walked it, or NULL when rendering is left to
+	 * print_output. */
+	sink_t *sections;
+	section_renderer_t render_section;
+	/* The indexes built by the walk are final, so the sections can be
+	 * rendered as soon as each walk ends */
+	bool render_in_walk;
+	/* --stream: a writer thread emits the sections in .rlist order as soon
+	 * as the workers push them into `finished` */
+	bool streaming;
+	header_renderer_t render_header;
+	header_renderer_t render_footer;
+	worker_queue_t finished;
+	pthread_t writer;
+	/* --stats / --profile: one profile per repository, or NULL when
+	 * profiling is off. The run profile is written by the main thread and
+	 * by the streaming writer, never at the same time. */
+	profile_t *profiles;
+	profile_t run_profile;
 } thread_pool_t;
 
 return_code_t walk_through_repos(const repository_array_t *repos,
 								 const settings_t *settings,
 								 repository_stats_t stats);
+/* Renders the whole output of settings->output_mode into `out`. `sections`
+ * is NULL or holds the sections already rendered, as in view.h. */
+void render_output(sink_t *out, const repository_array_t *repos,
+				   const settings_t *settings, repository_stats_t stats,
+				   const sink_t *sections);
 
 #endif /* __WALK_H__ */
@@ -0,0 +1,53 @@
+/* bench.c
+ * -----------------------------------------------------------------------
+ * Copyright (C) 2025  Matteo Nicoli
+ *
+ * This file is part of TUR.
+ *
+ * TUR is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "bench.h"
+
+#include <stdio.h>
+#include <time.h>
+
+uint64_t bench_now_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+void bench_report(const char *label, size_t n_ops, uint64_t elapsed_ns)
+{
+	printf("%-40s %12.3f ms %12.2f ns/op\n",
+		   label,
+		   (double)elapsed_ns / 1e6,
+		   n_ops ? (double)elapsed_ns / (double)n_ops : 0.0);
+}
+
+void bench_report_throughput(const char *label, size_t n_bytes, uint64_t elapsed_ns)
+{
+	printf("%-40s %12.3f ms %12.2f MB/s\n",
+		   label,
+		   (double)elapsed_ns / 1e6,
+		   elapsed_ns ? ((double)n_bytes / (1024.0 * 1024.0)) / ((double)elapsed_ns / 1e9) : 0.0);
+}
+
+void bench_do_not_optimize(const void *p)
+{
+	__asm__ volatile("" : : "g"(p) : "memory");
+}
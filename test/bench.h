@@ -0,0 +1,46 @@
+/* bench.h
+ * -----------------------------------------------------------------------
+ * Copyright (C) 2025  Matteo Nicoli
+ *
+ * This file is part of TUR.
+ *
+ * TUR is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __BENCH_H__
+#define __BENCH_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Monotonic clock, in nanoseconds */
+uint64_t bench_now_ns(void);
+
+/* Prints a line with the total time and the time per operation */
+void bench_report(const char *label, size_t n_ops, uint64_t elapsed_ns);
+
+/* Prints a line with the total time and the throughput in MB/s */
+void bench_report_throughput(const char *label, size_t n_bytes, uint64_t elapsed_ns);
+
+/* Keeps the compiler from optimizing away a computed value */
+void bench_do_not_optimize(const void *p);
+
+/* Calls to malloc, calloc and realloc so far (bench_alloc.c). They are
+ * counted only where the linker supports --wrap */
+size_t bench_allocations(void);
+bool bench_counts_allocations(void);
+
+#endif /* __BENCH_H__ */
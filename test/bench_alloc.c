@@ -0,0 +1,74 @@
+/* bench_alloc.c
+ * -----------------------------------------------------------------------
+ * Copyright (C) 2025  Matteo Nicoli
+ *
+ * This file is part of TUR.
+ *
+ * TUR is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/* Allocation counter of the micro-benchmarks. With BENCH_COUNT_ALLOCS,
+ * the benchmark is linked with --wrap for the allocator functions, so the
+ * calls made by the tur sources compiled into it go through these
+ * wrappers. Without it (e.g. with the macOS linker), nothing is counted. */
+
+#include "bench.h"
+
+#include <stddef.h>
+
+static size_t n_allocations = 0;
+
+#ifdef BENCH_COUNT_ALLOCS
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t n, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+
+void *__wrap_malloc(size_t size)
+{
+	n_allocations++;
+	return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t n, size_t size)
+{
+	n_allocations++;
+	return __real_calloc(n, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size)
+{
+	n_allocations++;
+	return __real_realloc(ptr, size);
+}
+
+bool bench_counts_allocations(void)
+{
+	return true;
+}
+
+#else
+
+bool bench_counts_allocations(void)
+{
+	return false;
+}
+
+#endif /* BENCH_COUNT_ALLOCS */
+
+size_t bench_allocations(void)
+{
+	return n_allocations;
+}
@@ -0,0 +1,280 @@
+/* bench_primitives.c
+ * -----------------------------------------------------------------------
+ * Copyright (C) 2025  Matteo Nicoli
+ *
+ * This file is part of TUR.
+ *
+ * TUR is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/* Micro-benchmarks of the core data structures: str_t, array_t and the
+ * lookup table of the cache. Every operation is measured on sizes from 10
+ * to 10M elements, and reported in ns/op and allocations/op. A size is
+ * skipped once the previous one, scaled linearly, would take longer than
+ * BUDGET_NS: quadratic operations stop early instead of running for hours. */
+
+#include "bench.h"
+#include "../src/array.h"
+#include "../src/lookup_table.h"
+#include "../src/str.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MIN_SIZE 10
+#define MAX_SIZE 10000000
+/* Small sizes are repeated until at least MIN_OPS operations are done */
+#define MIN_OPS 100000
+#define BUDGET_NS 5000000000ull
+#define HASH_LEN 40
+
+typedef enum {
+	STR_INIT,
+	STR_FREE,
+	STR_ARRAY_ADD,
+	STR_ARRAY_COPY,
+	STR_ARRAY_FREE,
+	ARRAY_ADD,
+	CACHE_ARRAY_ADD,
+	CACHE_ARRAY_COPY,
+	TABLE_PUT,
+	TABLE_GET,
+	TABLE_FREE,
+	N_OPS
+} op_t;
+
+static const char *op_names[N_OPS] = {
+	"str_init", "str_free", "str_array_add", "str_array_copy", "str_array_free",
+	"array_add (uint32_t)", "cache_array_add", "cache_array_copy",
+	"table_put", "table_get", "table_free"
+};
+
+typedef struct {
+	uint64_t ns;
+	size_t allocs;
+	size_t ops;
+	uint64_t start_ns;
+	size_t start_allocs;
+} probe_t;
+
+static probe_t probes[N_OPS];
+static char *hashes;
+
+static void probe_start(op_t op)
+{
+	probes[op].start_allocs = bench_allocations();
+	probes[op].start_ns = bench_now_ns();
+}
+
+static void probe_stop(op_t op, size_t n_ops)
+{
+	probes[op].ns += bench_now_ns() - probes[op].start_ns;
+	probes[op].allocs += bench_allocations() - probes[op].start_allocs;
+	probes[op].ops += n_ops;
+}
+
+static const char *hash_at(size_t i)
+{
+	return hashes + i * (HASH_LEN + 1);
+}
+
+static void assign_u32(void *dst, void *src)
+{
+	*(uint32_t *)dst = *(uint32_t *)src;
+}
+
+static void free_nothing(void *elem)
+{
+	(void)elem;
+}
+
+static uint32_t id_hash(void *key)
+{
+	return *(uint32_t *)key;
+}
+
+static void bench_str(size_t n, bool *skip)
+{
+	str_t *strs = malloc(n * sizeof(str_t));
+
+	if (!skip[STR_INIT]) {
+		probe_start(STR_INIT);
+		for (size_t i = 0; i < n; i++) {
+			strs[i] = str_init(hash_at(i), HASH_LEN);
+		}
+		probe_stop(STR_INIT, n);
+		bench_do_not_optimize(strs);
+
+		probe_start(STR_FREE);
+		for (size_t i = 0; i < n; i++) {
+			str_free(strs[i]);
+		}
+		probe_stop(STR_FREE, n);
+	}
+
+	if (!skip[STR_ARRAY_ADD]) {
+		str_array_t *arr = NULL, *copy = NULL;
+		str_array_init(&arr);
+		probe_start(STR_ARRAY_ADD);
+		for (size_t i = 0; i < n; i++) {
+			(void)str_array_add(arr, (str_t) { .val = hash_at(i), .len = HASH_LEN });
+		}
+		probe_stop(STR_ARRAY_ADD, n);
+
+		if (!skip[STR_ARRAY_COPY]) {
+			probe_start(STR_ARRAY_COPY);
+			copy = str_array_copy(arr);
+			probe_stop(STR_ARRAY_COPY, n);
+			str_array_free(&copy);
+		}
+
+		probe_start(STR_ARRAY_FREE);
+		str_array_free(&arr);
+		probe_stop(STR_ARRAY_FREE, n);
+	}
+
+	free(strs);
+}
+
+static void bench_array(size_t n, bool *skip)
+{
+	if (skip[ARRAY_ADD]) { return; }
+
+	array_t *arr = NULL;
+	array_init(&arr, sizeof(uint32_t));
+	probe_start(ARRAY_ADD);
+	for (uint32_t i = 0; i < n; i++) {
+		(void)array_add(arr, &i, assign_u32);
+	}
+	probe_stop(ARRAY_ADD, n);
+	array_free(&arr, free_nothing);
+}
+
+static void bench_cache_array(size_t n, bool *skip)
+{
+	if (skip[CACHE_ARRAY_ADD]) { return; }
+
+	cacheidx_arr_t *arr = NULL;
+	cache_array_init(&arr);
+	probe_start(CACHE_ARRAY_ADD);
+	for (size_t i = 0; i < n; i++) {
+		cache_index_t idx = { .hash = { .val = hash_at(i), .len = HASH_LEN }, .is_favorite = i % 2 };
+		(void)cache_array_add(arr, &idx);
+	}
+	probe_stop(CACHE_ARRAY_ADD, n);
+
+	if (!skip[CACHE_ARRAY_COPY]) {
+		probe_start(CACHE_ARRAY_COPY);
+		cacheidx_arr_t *copy = cache_array_copy(arr);
+		probe_stop(CACHE_ARRAY_COPY, n);
+		cache_array_free(&copy);
+	}
+
+	cache_array_free(&arr);
+}
+
+/* One repository (key) per element, each with a single commit, as
+ * rebuild_indexes does with the commits file */
+static void bench_table(size_t n, bool *skip)
+{
+	if (skip[TABLE_PUT]) { return; }
+
+	table_t table;
+	cacheidx_arr_t *value = NULL;
+	cache_index_t idx = { .hash = { .val = hash_at(0), .len = HASH_LEN }, .is_favorite = false };
+
+	cache_array_init(&value);
+	(void)cache_array_add(value, &idx);
+	(void)table_init(&table, DEFAULT_MAP_SIZE, DEFAULT_MAP_SIZE, id_hash);
+
+	/* Key 0 marks the empty slots */
+	probe_start(TABLE_PUT);
+	for (uint32_t key = 1; key <= n; key++) {
+		(void)table_put(&table, key, value);
+	}
+	probe_stop(TABLE_PUT, n);
+
+	if (!skip[TABLE_GET]) {
+		size_t found = 0;
+		probe_start(TABLE_GET);
+		for (uint32_t key = 1; key <= n; key++) {
+			found += table_get(&table, key) != NULL;
+		}
+		probe_stop(TABLE_GET, n);
+		bench_do_not_optimize(&found);
+	}
+
+	probe_start(TABLE_FREE);
+	table_free(&table);
+	probe_stop(TABLE_FREE, n);
+	cache_array_free(&value);
+}
+
+int main(void)
+{
+	bool skip[N_OPS] = { 0 };
+	const bool allocs = bench_counts_allocations();
+
+	hashes = malloc((size_t)MAX_SIZE * (HASH_LEN + 1));
+	if (!hashes) {
+		fprintf(stderr, "bench_primitives: cannot allocate the keys\n");
+		return 1;
+	}
+	srand(1234);
+	for (size_t i = 0; i < MAX_SIZE; i++) {
+		char *hash = hashes + i * (HASH_LEN + 1);
+		for (size_t j = 0; j < HASH_LEN; j++) {
+			hash[j] = "0123456789abcdef"[rand() % 16];
+		}
+		hash[HASH_LEN] = '\0';
+	}
+
+	printf("Core data structures (%s)\n", allocs ? "allocations counted" : "allocations not counted");
+	printf("%-22s %10s %14s %14s\n", "operation", "size", "ns/op", "allocs/op");
+
+	for (size_t n = MIN_SIZE; n <= MAX_SIZE; n *= 10) {
+		const size_t rounds = n < MIN_OPS ? MIN_OPS / n : 1;
+
+		memset(probes, 0, sizeof(probes));
+		for (size_t r = 0; r < rounds; r++) {
+			bench_str(n, skip);
+			bench_array(n, skip);
+			bench_cache_array(n, skip);
+			bench_table(n, skip);
+		}
+
+		for (size_t op = 0; op < N_OPS; op++) {
+			if (skip[op]) { continue; }
+			const probe_t *probe = probes + op;
+			printf("%-22s %10zu %14.2f %14.3f\n", op_names[op], n,
+				   (double)probe->ns / (double)probe->ops,
+				   allocs ? (double)probe->allocs / (double)probe->ops : 0.0);
+
+			/* Projected time of the next size, if the operation scaled
+			 * linearly */
+			const uint64_t round_ns = probe->ns / rounds;
+			if (n < MAX_SIZE && round_ns * 10 > BUDGET_NS) {
+				printf("%-22s %10zu %14s\n", op_names[op], n * 10, "skipped");
+				skip[op] = true;
+			}
+		}
+	}
+
+	free(hashes);
+	return 0;
+}
@@ -0,0 +1,236 @@
+/* bench_render.c
+ * -----------------------------------------------------------------------
+ * Copyright (C) 2025  Matteo Nicoli
+ *
+ * This file is part of TUR.
+ *
+ * TUR is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "bench.h"
+#include "../src/alloc.h"
+#include "../src/commit.h"
+#include "../src/repo.h"
+#include "../src/settings.h"
+#include "../src/sink.h"
+#include "../src/view.h"
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define N_REPOS 4
+#define COMMITS_PER_REPO 75000
+#define MMAP_FILE "/tmp/tur_bench_render.out"
+
+typedef enum { TO_MEMORY, TO_DEV_NULL, TO_MMAP } target_t;
+
+static const char *target_names[] = { "memory", "fd /dev/null", "mmap" };
+
+static work_history_t *make_history(unsigned seed)
+{
+	work_history_t *history = tur_calloc(1, sizeof(work_history_t));
+	char hash[GIT_HASH_LEN + 1], msg[128];
+
+	commit_table_init(&history->commits, COMMITS_PER_REPO);
+	srand(seed);
+	for (size_t i = 0; i < COMMITS_PER_REPO; i++) {
+		for (size_t j = 0; j < GIT_HASH_LEN; j++) {
+			hash[j] = "0123456789abcdef"[rand() % 16];
+		}
+		hash[GIT_HASH_LEN] = '\0';
+		snprintf(msg, sizeof(msg), "Fix issue #%zu in module_%zu\n\nLonger description of the change",
+				 i, i % 17);
+		commit_stats_t stats = {
+			.files_changed = (size_t)(rand() % 20),
+			.lines_added = (size_t)(rand() % 500),
+			.lines_removed = (size_t)(rand() % 300)
+		};
+		commit_table_add(&history->commits, hash, msg,
+						 1400000000 + (time_t)(rand() % 315360000),
+						 i % 5 ? AUTHORED : CO_AUTHORED, &stats);
+	}
+
+	history->indexes.authored = tur_malloc(COMMITS_PER_REPO * sizeof(uint32_t));
+	history->indexes.co_authored = tur_malloc(COMMITS_PER_REPO * sizeof(uint32_t));
+	history->n_authored = commit_table_select(&history->commits, AUTHORED,
+											  history->indexes.authored);
+	history->n_co_authored = commit_table_select(&history->commits, CO_AUTHORED,
+												 history->indexes.co_authored);
+	return history;
+}
+
+static void render(sink_t *out, tur_output_t mode, const repository_array_t *repos,
+				   const settings_t *settings, repository_stats_t stats)
+{
+	switch (mode) {
+	case STDOUT:
+		print_stdout(out, repos, settings, stats, NULL);
+		break;
+	case LATEX:
+		generate_latex_file(out, repos, settings, NULL);
+		break;
+	case HTML:
+		generate_html_file(out, repos, settings, NULL);
+		break;
+	case JEKYLL:
+		generate_markdown_file(out, repos, settings, NULL);
+		break;
+	case JSON:
+		generate_json_file(out, repos, settings, NULL);
+		break;
+	case NDJSON:
+		generate_ndjson_file(out, repos, settings, NULL);
+		break;
+	case CSV:
+	case TSV:
+		generate_csv_file(out, repos, settings, NULL);
+		break;
+	case COLUMNAR:
+		generate_columnar_file(out, repos, settings, NULL);
+		break;
+	}
+}
+
+static void bench_mode(tur_output_t mode, const char *name, const repository_array_t *repos,
+					   const settings_t *settings, repository_stats_t stats)
+{
+	char label[64];
+
+	for (target_t target = TO_MEMORY; target <= TO_MMAP; target++) {
+		sink_t out;
+		int fd = -1;
+
+		switch (target) {
+		case TO_MEMORY:
+			sink_init_memory(&out);
+			break;
+		case TO_DEV_NULL:
+			fd = open("/dev/null", O_WRONLY);
+			sink_init_fd(&out, fd);
+			break;
+		case TO_MMAP:
+			sink_init_file(&out, MMAP_FILE, true);
+			break;
+		}
+
+		const uint64_t start = bench_now_ns();
+		render(&out, mode, repos, settings, stats);
+		const size_t n_bytes = sink_size(&out);
+		(void)sink_close(&out);
+		const uint64_t elapsed = bench_now_ns() - start;
+
+		if (fd >= 0) { close(fd); }
+		snprintf(label, sizeof(label), "%-8s -> %s", name, target_names[target]);
+		bench_report_throughput(label, n_bytes, elapsed);
+	}
+	unlink(MMAP_FILE);
+}
+
+typedef struct {
+	sink_t section;
+	const repository_t *repo;
+	const settings_t *settings;
+} section_job_t;
+
+static void *render_html_section(void *arg)
+{
+	section_job_t *job = arg;
+
+	sink_init_memory(&job->section);
+	generate_html_section(&job->section, job->repo, job->settings);
+	return NULL;
+}
+
+/* Renders every repository section on its own thread, then concatenates
+ * them as walk.c does for grouped output */
+static void bench_parallel_sections(const repository_array_t *repos, const settings_t *settings)
+{
+	section_job_t jobs[N_REPOS];
+	pthread_t threads[N_REPOS];
+	sink_t sections[N_REPOS];
+	sink_t out;
+
+	sink_init_memory(&out);
+	const uint64_t start = bench_now_ns();
+	for (size_t i = 0; i < N_REPOS; i++) {
+		jobs[i] = (section_job_t) {
+			.repo = repo_array_get(repos, i),
+			.settings = settings
+		};
+		pthread_create(threads + i, NULL, render_html_section, jobs + i);
+	}
+	for (size_t i = 0; i < N_REPOS; i++) {
+		pthread_join(threads[i], NULL);
+		sections[i] = jobs[i].section;
+	}
+	generate_html_file(&out, repos, settings, sections);
+	const uint64_t elapsed = bench_now_ns() - start;
+
+	bench_report_throughput("html     -> memory, sections in parallel", sink_size(&out), elapsed);
+	for (size_t i = 0; i < N_REPOS; i++) {
+		(void)sink_close(sections + i);
+	}
+	(void)sink_close(&out);
+}
+
+int main(void)
+{
+	repository_array_t *repos = NULL;
+	settings_t settings = default_settings();
+	repository_stats_t stats = { .max_name_len = 5 };
+
+	settings.print_msg = true;
+	settings.show_diffs = true;
+	settings.sorted = true;
+	settings.sort_order = DESC;
+
+	repo_array_init(&repos);
+	for (unsigned i = 0; i < N_REPOS; i++) {
+		char line[64];
+		const int len = snprintf(line, sizeof(line), "/tmp/repo%u[https://github.com/x/repo%u]", i, i);
+		repository_t repo = parse_repository(line, len, i);
+		repo_array_add(repos, &repo);
+		str_free(repo.path);
+		str_free(repo.name);
+		str_free(repo.url);
+		repo_array_get(repos, i)->history = make_history(i + 1);
+	}
+
+	printf("Rendering %d commits (messages and diffs, sorted timeline)\n",
+		   N_REPOS * COMMITS_PER_REPO);
+	bench_mode(STDOUT, "stdout", repos, &settings, stats);
+	bench_mode(HTML, "html", repos, &settings, stats);
+	bench_mode(LATEX, "latex", repos, &settings, stats);
+	bench_mode(JEKYLL, "markdown", repos, &settings, stats);
+	bench_mode(JSON, "json", repos, &settings, stats);
+	bench_mode(NDJSON, "ndjson", repos, &settings, stats);
+	settings.output_mode = CSV;
+	bench_mode(CSV, "csv", repos, &settings, stats);
+	settings.output_mode = TSV;
+	bench_mode(TSV, "tsv", repos, &settings, stats);
+	bench_mode(COLUMNAR, "turc", repos, &settings, stats);
+
+	settings.grouped = true;
+	printf("Grouped by repository\n");
+	bench_mode(HTML, "html", repos, &settings, stats);
+	bench_parallel_sections(repos, &settings);
+
+	repo_array_free(&repos);
+	return 0;
+}
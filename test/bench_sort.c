@@ -0,0 +1,105 @@
+/* bench_sort.c
+ * -----------------------------------------------------------------------
+ * Copyright (C) 2025  Matteo Nicoli
+ *
+ * This file is part of TUR.
+ *
+ * TUR is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "bench.h"
+#include "../src/sort.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define N_RUNS 5
+
+static const size_t sizes[] = { 1000, 10000, 100000, 500000, 1000000 };
+
+/* Rows come out of the walk in history order, which is not the date order
+ * of the whole table once several branches are merged: shuffle them. */
+static uint32_t *make_rows(size_t n)
+{
+	uint32_t *rows = malloc(n * sizeof(uint32_t));
+	for (size_t i = 0; i < n; i++) {
+		rows[i] = (uint32_t)i;
+	}
+	for (size_t i = n - 1; i > 0; i--) {
+		size_t j = (size_t)rand() % (i + 1);
+		uint32_t tmp = rows[i];
+		rows[i] = rows[j];
+		rows[j] = tmp;
+	}
+	return rows;
+}
+
+static uint64_t run(const uint32_t *rows, uint32_t *work, size_t n, const time_t *dates,
+					bool radix, sort_ordering_t order)
+{
+	uint64_t best = UINT64_MAX;
+
+	for (int r = 0; r < N_RUNS; r++) {
+		memcpy(work, rows, n * sizeof(uint32_t));
+		uint64_t start = bench_now_ns();
+		if (radix) {
+			(void)sort_rows_by_date(work, n, dates, order);
+		} else {
+			sort_rows_by_date_qsort(work, n, dates, order);
+		}
+		uint64_t elapsed = bench_now_ns() - start;
+		bench_do_not_optimize(work);
+		if (elapsed < best) { best = elapsed; }
+	}
+
+	return best;
+}
+
+int main(void)
+{
+	char label[64];
+
+	srand(1234);
+	printf("Sorting commit rows by date (best of %d runs)\n", N_RUNS);
+
+	for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+		const size_t n = sizes[s];
+		time_t *dates = malloc(n * sizeof(time_t));
+		/* About 10 years of history */
+		for (size_t i = 0; i < n; i++) {
+			dates[i] = 1400000000 + (time_t)(rand() % 315360000);
+		}
+		uint32_t *rows = make_rows(n);
+		uint32_t *work = malloc(n * sizeof(uint32_t));
+
+		const uint64_t qsort_ns = run(rows, work, n, dates, false, DESC);
+		const uint64_t radix_ns = run(rows, work, n, dates, true, DESC);
+
+		snprintf(label, sizeof(label), "qsort  n=%zu", n);
+		bench_report(label, n, qsort_ns);
+		snprintf(label, sizeof(label), "radix  n=%zu", n);
+		bench_report(label, n, radix_ns);
+		printf("%-40s %12.2fx\n", "speedup", (double)qsort_ns / (double)radix_ns);
+
+		free(work);
+		free(rows);
+		free(dates);
+	}
+
+	return 0;
+}
@@ -0,0 +1,478 @@
+/* bench_walk.c
+ * -----------------------------------------------------------------------
+ * Copyright (C) 2025  Matteo Nicoli
+ *
+ * This file is part of TUR.
+ *
+ * TUR is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/* End-to-end benchmark of tur on repositories generated by gen_repos. Each
+ * scenario runs the tur binary with --profile, and reports:
+ *     - the wall time (median of the runs) and the commits/s of the walk;
+ *     - the MB/s of the output, from the run profile;
+ *     - p50/p99 of the per-repository latency (sum of its phases);
+ *     - the peak RSS of the process.
+ * Results are written as JSON, one scenario per line. With -b, they are
+ * compared with a stored baseline and the regressions are reported. */
+
+#include "bench.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <ftw.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#define MAX_ARGS 32
+#define MAX_SAMPLES 65536
+#define MAX_RESULTS 64
+#define NAME_SIZE 64
+#define PATH_SIZE 4096
+#define PROFILE_FILE "tur_bench_profile.json"
+/* A scenario regresses when it is this much slower than the baseline */
+#define DEFAULT_THRESHOLD 0.10
+
+typedef struct {
+	char name[NAME_SIZE];
+	double wall_ms;
+	double commits_per_s;
+	double output_mb_per_s;
+	double repo_p50_ms;
+	double repo_p99_ms;
+	long peak_rss_kb;
+} result_t;
+
+typedef struct {
+	const char *tur;
+	const char *gen_repos;
+	const char *repos_dir;
+	const char *out;
+	const char *baseline;
+	size_t n_repos;
+	size_t n_commits;
+	size_t max_threads;
+	size_t n_runs;
+	double threshold;
+} bench_options_t;
+
+typedef struct {
+	const char *name;
+	const char *ext;
+} format_t;
+
+static const format_t formats[] = {
+	{ "stdout", NULL }, { "latex", "tex" }, { "html", "html" }, { "markdown", "md" },
+	{ "json", "json" }, { "ndjson", "ndjson" }, { "csv", "csv" }, { "tsv", "tsv" },
+	{ "columnar", "turc" }
+};
+
+static char rlist[PATH_SIZE];
+static double samples[MAX_SAMPLES];
+static size_t n_samples;
+
+static int compare_double(const void *a, const void *b)
+{
+	const double x = *(const double *)a, y = *(const double *)b;
+	return (x > y) - (x < y);
+}
+
+static double percentile(double *values, size_t n, double p)
+{
+	if (n == 0) { return 0.0; }
+	qsort(values, n, sizeof(double), compare_double);
+	size_t i = (size_t)(p * (double)(n - 1) + 0.5);
+	return values[i];
+}
+
+/* Runs argv with stdout and stderr sent to /dev/null, and returns the
+ * peak RSS in KB, or -1 when the command fails */
+static long run_command(char *const argv[], const char *cwd)
+{
+	struct rusage usage;
+	int status;
+
+	const pid_t pid = fork();
+	if (pid < 0) { return -1; }
+	if (pid == 0) {
+		const int null_fd = open("/dev/null", O_WRONLY);
+		if (null_fd >= 0) {
+			dup2(null_fd, STDOUT_FILENO);
+			dup2(null_fd, STDERR_FILENO);
+		}
+		if (cwd && chdir(cwd) != 0) { _exit(127); }
+		execv(argv[0], argv);
+		_exit(127);
+	}
+
+	if (wait4(pid, &status, 0, &usage) < 0) { return -1; }
+	if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) { return -1; }
+	return usage.ru_maxrss;
+}
+
+static int evict_file(const char *path, const struct stat *st, int type, struct FTW *ftw)
+{
+	(void)st;
+	(void)ftw;
+	if (type != FTW_F) { return 0; }
+
+	const int fd = open(path, O_RDONLY);
+	if (fd >= 0) {
+		(void)posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+		close(fd);
+	}
+	return 0;
+}
+
+/* Cold page cache: the repositories are dropped from the page cache,
+ * which needs no privilege for clean pages */
+static void evict_repos(const char *dir)
+{
+	sync();
+	(void)nftw(dir, evict_file, 64, FTW_PHYS);
+}
+
+static bool read_file(const char *path, char **out)
+{
+	FILE *file = fopen(path, "r");
+	if (!file) { return false; }
+
+	(void)fseek(file, 0, SEEK_END);
+	const long size = ftell(file);
+	(void)fseek(file, 0, SEEK_SET);
+	*out = malloc((size_t)size + 1);
+	const bool ok = *out && fread(*out, 1, (size_t)size, file) == (size_t)size;
+	if (ok) { (*out)[size] = '\0'; }
+	fclose(file);
+	return ok;
+}
+
+static double json_number(const char *from, const char *key)
+{
+	const char *at = strstr(from, key);
+	return at ? strtod(at + strlen(key), NULL) : 0.0;
+}
+
+/* Reads the profile written by tur --profile: adds the latency of every
+ * repository to the samples, and returns the commits visited, the output
+ * bytes and the output time */
+static bool read_profile(const char *path, double *visited, double *bytes, double *output_ns)
+{
+	char *json = NULL;
+	if (!read_file(path, &json)) { return false; }
+
+	const char *run = strstr(json, "\"run\":");
+	const char *repos = strstr(json, "\"repositories\":");
+	if (!run || !repos) {
+		free(json);
+		return false;
+	}
+	*bytes = json_number(run, "\"bytes\":");
+	*output_ns = json_number(run, "\"output\":");
+
+	static const char *phases[] = {
+		"\"open\":", "\"revwalk\":", "\"lookup\":", "\"diff\":", "\"index\":", "\"render\":"
+	};
+	for (const char *repo = strstr(repos, "{\"name\":"); repo; repo = strstr(repo + 1, "{\"name\":")) {
+		double ns = 0.0;
+		for (size_t p = 0; p < sizeof(phases) / sizeof(phases[0]); p++) {
+			ns += json_number(repo, phases[p]);
+		}
+		*visited += json_number(repo, "\"visited\":");
+		if (n_samples < MAX_SAMPLES) { samples[n_samples++] = ns / 1e6; }
+	}
+
+	free(json);
+	return true;
+}
+
+static bool run_scenario(const bench_options_t *opts, const char *name, size_t n_threads,
+						 const format_t *format, bool cold, bool cached, result_t *result)
+{
+	char jobs[16], out[PATH_SIZE], profile[PATH_SIZE];
+	double walls[16], visited = 0.0, bytes = 0.0, output_ns = 0.0;
+	char *argv[MAX_ARGS];
+	size_t argc = 0;
+
+	(void)snprintf(jobs, sizeof(jobs), "%zu", n_threads);
+	(void)snprintf(profile, sizeof(profile), "%s/" PROFILE_FILE, opts->repos_dir);
+	argv[argc++] = (char *)opts->tur;
+	argv[argc++] = "-e";
+	argv[argc++] = "me@example.com";
+	argv[argc++] = "-g";
+	argv[argc++] = "-j";
+	argv[argc++] = jobs;
+	argv[argc++] = "-r";
+	argv[argc++] = rlist;
+	argv[argc++] = "--profile";
+	argv[argc++] = profile;
+	/* With the cache, -f rewrites .tur/commits every run */
+	argv[argc++] = cached ? "-f" : "--no-cache";
+	if (format->ext) {
+		(void)snprintf(out, sizeof(out), "%s/bench_out.%s", opts->repos_dir, format->ext);
+		argv[argc++] = "-o";
+		argv[argc++] = out;
+	}
+	argv[argc] = NULL;
+
+	*result = (result_t) { 0 };
+	(void)snprintf(result->name, sizeof(result->name), "%s", name);
+	n_samples = 0;
+
+	for (size_t r = 0; r < opts->n_runs; r++) {
+		if (cold) { evict_repos(opts->repos_dir); }
+
+		const uint64_t start = bench_now_ns();
+		const long rss = run_command(argv, opts->repos_dir);
+		walls[r] = (double)(bench_now_ns() - start) / 1e6;
+		if (rss < 0 || !read_profile(profile, &visited, &bytes, &output_ns)) {
+			fprintf(stderr, "bench_walk: %s: tur failed\n", name);
+			return false;
+		}
+		if (rss > result->peak_rss_kb) { result->peak_rss_kb = rss; }
+	}
+
+	double total_wall_ms = 0.0;
+	for (size_t r = 0; r < opts->n_runs; r++) {
+		total_wall_ms += walls[r];
+	}
+	result->wall_ms = percentile(walls, opts->n_runs, 0.5);
+	result->commits_per_s = visited / (total_wall_ms / 1e3);
+	result->output_mb_per_s = output_ns > 0.0 ? (bytes / (1024.0 * 1024.0)) / (output_ns / 1e9) : 0.0;
+	result->repo_p50_ms = percentile(samples, n_samples, 0.5);
+	result->repo_p99_ms = percentile(samples, n_samples, 0.99);
+	return true;
+}
+
+static void print_result(FILE *out, const result_t *result, bool last)
+{
+	fprintf(out, "{\"name\":\"%s\",\"wall_ms\":%.3f,\"commits_per_s\":%.1f,"
+			"\"output_mb_per_s\":%.2f,\"repo_p50_ms\":%.3f,\"repo_p99_ms\":%.3f,"
+			"\"peak_rss_kb\":%ld}%s\n",
+			result->name, result->wall_ms, result->commits_per_s, result->output_mb_per_s,
+			result->repo_p50_ms, result->repo_p99_ms, result->peak_rss_kb, last ? "" : ",");
+}
+
+/* Compares wall time, p99 latency and peak RSS with the scenario of the
+ * same name in the baseline (a file written by a previous run). Returns
+ * the number of regressions. */
+static size_t compare_baseline(const char *path, const result_t *results, size_t n_results,
+							   double threshold)
+{
+	char *json = NULL, key[NAME_SIZE + 16];
+	size_t n_regressions = 0;
+
+	if (!read_file(path, &json)) {
+		fprintf(stderr, "bench_walk: cannot read the baseline %s\n", path);
+		return 1;
+	}
+
+	printf("\nComparison with %s (threshold %.0f%%)\n", path, threshold * 100.0);
+	for (size_t i = 0; i < n_results; i++) {
+		const result_t *result = results + i;
+		(void)snprintf(key, sizeof(key), "{\"name\":\"%.*s\",", NAME_SIZE - 1, result->name);
+		const char *line = strstr(json, key);
+		if (!line) {
+			printf("  %-28s not in the baseline\n", result->name);
+			continue;
+		}
+
+		const struct { const char *key; double now; } metrics[] = {
+			{ "\"wall_ms\":", result->wall_ms },
+			{ "\"repo_p99_ms\":", result->repo_p99_ms },
+			{ "\"peak_rss_kb\":", (double)result->peak_rss_kb }
+		};
+		for (size_t m = 0; m < sizeof(metrics) / sizeof(metrics[0]); m++) {
+			const double before = json_number(line, metrics[m].key);
+			const double change = before > 0.0 ? metrics[m].now / before - 1.0 : 0.0;
+			const bool regressed = change > threshold;
+			if (regressed) { n_regressions++; }
+			printf("  %-28s %-16.*s %12.2f -> %12.2f  %+6.1f%%%s\n",
+				   result->name, (int)strlen(metrics[m].key) - 3, metrics[m].key + 1,
+				   before, metrics[m].now, change * 100.0, regressed ? "  REGRESSION" : "");
+		}
+	}
+
+	free(json);
+	return n_regressions;
+}
+
+static bool generate_repos(const bench_options_t *opts)
+{
+	char n_repos[32], n_commits[32];
+	char *argv[] = {
+		(char *)opts->gen_repos, "-o", (char *)opts->repos_dir, "-n", n_repos, "-c", n_commits,
+		"-M", "50", "-F", "3", NULL
+	};
+
+	if (access(rlist, R_OK) == 0) { return true; }
+
+	(void)snprintf(n_repos, sizeof(n_repos), "%zu", opts->n_repos);
+	(void)snprintf(n_commits, sizeof(n_commits), "%zu", opts->n_commits);
+	fprintf(stderr, "Generating %zu repositories of %zu commits in %s...\n",
+			opts->n_repos, opts->n_commits, opts->repos_dir);
+	if (mkdir(opts->repos_dir, 0755) != 0 && errno != EEXIST) { return false; }
+	return run_command(argv, NULL) >= 0;
+}
+
+static bool parse_size(const char *arg, size_t *out)
+{
+	char *end = NULL;
+	const unsigned long value = strtoul(arg, &end, 10);
+	if (!*arg || *end || *arg == '-' || value == 0) { return false; }
+	*out = (size_t)value;
+	return true;
+}
+
+static void usage(void)
+{
+	fprintf(stderr,
+			"Usage: bench_walk [OPTIONS]\n"
+			"  -t FILE    tur binary (default ../src/tur)\n"
+			"  -g FILE    gen_repos binary (default ./gen_repos)\n"
+			"  -d DIR     Repositories, generated if DIR/.rlist is missing\n"
+			"             (default /tmp/tur_bench_<N>x<C>)\n"
+			"  -n N       Number of repositories (default 8)\n"
+			"  -c N       Commits per repository (default 5000)\n"
+			"  -j N       Up to N threads (default: number of online cores)\n"
+			"  -r N       Runs per scenario (default 3)\n"
+			"  -o FILE    Write the results to FILE (default stdout)\n"
+			"  -b FILE    Compare with a baseline written by -o\n"
+			"  -T PCT     Regression threshold in percent (default 10)\n");
+}
+
+int main(int argc, char *argv[])
+{
+	bench_options_t opts = {
+		.tur = "../src/tur",
+		.gen_repos = "./gen_repos",
+		.repos_dir = NULL,
+		.out = NULL,
+		.baseline = NULL,
+		.n_repos = 8,
+		.n_commits = 5000,
+		.max_threads = (size_t)sysconf(_SC_NPROCESSORS_ONLN),
+		.n_runs = 3,
+		.threshold = DEFAULT_THRESHOLD
+	};
+	static result_t results[MAX_RESULTS];
+	size_t n_results = 0, value = 0;
+	char dir[PATH_SIZE], name[NAME_SIZE];
+	bool valid = true;
+	int ch;
+
+	while ((ch = getopt(argc, argv, "t:g:d:n:c:j:r:o:b:T:h")) != -1 && valid) {
+		switch (ch) {
+		case 't': opts.tur = optarg; break;
+		case 'g': opts.gen_repos = optarg; break;
+		case 'd': opts.repos_dir = optarg; break;
+		case 'n': valid = parse_size(optarg, &opts.n_repos); break;
+		case 'c': valid = parse_size(optarg, &opts.n_commits); break;
+		case 'j': valid = parse_size(optarg, &opts.max_threads); break;
+		case 'r': valid = parse_size(optarg, &opts.n_runs) && opts.n_runs <= 16; break;
+		case 'o': opts.out = optarg; break;
+		case 'b': opts.baseline = optarg; break;
+		case 'T':
+			valid = parse_size(optarg, &value);
+			opts.threshold = (double)value / 100.0;
+			break;
+		default:
+			valid = false;
+			break;
+		}
+	}
+	if (!valid) {
+		usage();
+		return 1;
+	}
+
+	/* tur runs from the repositories directory */
+	char *tur = realpath(opts.tur, NULL);
+	if (!tur) {
+		fprintf(stderr, "bench_walk: cannot find tur at %s\n", opts.tur);
+		return 1;
+	}
+	opts.tur = tur;
+
+	if (!opts.repos_dir) {
+		(void)snprintf(dir, sizeof(dir), "/tmp/tur_bench_%zux%zu", opts.n_repos, opts.n_commits);
+		opts.repos_dir = dir;
+	}
+	(void)snprintf(rlist, sizeof(rlist), "%s/.rlist", opts.repos_dir);
+	if (!generate_repos(&opts)) {
+		fprintf(stderr, "bench_walk: cannot generate the repositories in %s\n", opts.repos_dir);
+		free(tur);
+		return 1;
+	}
+
+	/* Walk: cold and warm page cache, 1..N threads by powers of two */
+	for (size_t n_threads = 1; n_threads <= opts.max_threads; ) {
+		for (int cold = 1; cold >= 0; cold--) {
+			(void)snprintf(name, sizeof(name), "walk/j%zu/%s", n_threads, cold ? "cold" : "warm");
+			if (run_scenario(&opts, name, n_threads, formats + 2, cold, false, results + n_results)) {
+				n_results++;
+			}
+		}
+		n_threads = n_threads == opts.max_threads ? n_threads + 1
+				  : n_threads * 2 > opts.max_threads ? opts.max_threads : n_threads * 2;
+	}
+
+	/* Render: every format, warm, with all the threads */
+	for (size_t f = 0; f < sizeof(formats) / sizeof(formats[0]); f++) {
+		(void)snprintf(name, sizeof(name), "render/%s", formats[f].name);
+		if (run_scenario(&opts, name, opts.max_threads, formats + f, false, false, results + n_results)) {
+			n_results++;
+		}
+	}
+
+	/* Cache: .tur/commits written and read back */
+	if (run_scenario(&opts, "cache/rewrite", opts.max_threads, formats + 2, false, true,
+					 results + n_results)) {
+		n_results++;
+	}
+
+	FILE *out = opts.out ? fopen(opts.out, "w") : stdout;
+	if (!out) {
+		fprintf(stderr, "bench_walk: cannot write %s\n", opts.out);
+		free(tur);
+		return 1;
+	}
+	fprintf(out, "{\"repos\":%zu,\"commits_per_repo\":%zu,\"runs\":%zu,\"results\":[\n",
+			opts.n_repos, opts.n_commits, opts.n_runs);
+	for (size_t i = 0; i < n_results; i++) {
+		print_result(out, results + i, i + 1 == n_results);
+	}
+	fprintf(out, "]}\n");
+	if (opts.out) {
+		fclose(out);
+		printf("Results written to %s\n", opts.out);
+	}
+
+	size_t n_regressions = 0;
+	if (opts.baseline) {
+		n_regressions = compare_baseline(opts.baseline, results, n_results, opts.threshold);
+		if (n_regressions > 0) { printf("%zu regression(s)\n", n_regressions); }
+	}
+
+	free(tur);
+	return n_results == 0 || n_regressions > 0;
+}
@@ -0,0 +1,483 @@
+/* gen_repos.c
+ * -----------------------------------------------------------------------
+ * Copyright (C) 2025  Matteo Nicoli
+ *
+ * This file is part of TUR.
+ *
+ * TUR is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/* Synthetic repository generator for benchmarks and stress tests. It
+ * writes N repositories with libgit2 and an .rlist listing them, so that a
+ * walk at scale can be reproduced locally without network:
+ *
+ *     ./gen_repos -o /tmp/tur_synth -n 8 -c 20000 -M 50 -F 3
+ *     cd /tmp/tur_synth && tur -e me@example.com --no-cache -g -o out.html
+ *
+ * The output only depends on the options and the seed. */
+
+#include <getopt.h>
+#include <git2.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define BASE_DATE 1577836800 /* 2020-01-01 */
+#define MAX_FAN_IN 16
+#define MAX_MSG_LEN 65536
+#define MAX_FILES_PER_COMMIT 3
+#define FILE_NAME_SIZE 32
+#define LINE_WIDTH 72
+#define BYTES_PER_LINE 48
+
+typedef struct {
+	size_t n_repos;
+	size_t n_commits;
+	size_t n_files;
+	/* A merge every `merge_every` commits, joining `fan_in` - 1 side
+	 * commits into the main line (0 disables merges) */
+	size_t merge_every;
+	size_t fan_in;
+	size_t msg_len;
+	unsigned co_author_pct;
+	size_t n_authors;
+	unsigned own_pct;
+	const char *email;
+	const char *out_dir;
+	uint64_t seed;
+} gen_options_t;
+
+typedef struct {
+	size_t file;
+	git_oid blob;
+} change_t;
+
+typedef struct {
+	const gen_options_t *opts;
+	git_repository *repo;
+	git_commit *head;
+	git_tree *head_tree;
+	/* Current version of each file */
+	uint32_t *versions;
+	git_time_t now;
+	char *content;
+	char *msg;
+	size_t n_created;
+} gen_state_t;
+
+static uint64_t rng_state;
+
+/* xorshift64*: the generated repositories must not depend on the libc */
+static uint32_t next_rand(void)
+{
+	rng_state ^= rng_state >> 12;
+	rng_state ^= rng_state << 25;
+	rng_state ^= rng_state >> 27;
+	return (uint32_t)((rng_state * 0x2545F4914F6CDD1DULL) >> 32);
+}
+
+static bool chance(unsigned pct)
+{
+	return next_rand() % 100 < pct;
+}
+
+static void print_git_error(const char *what)
+{
+	const git_error *err = git_error_last();
+	fprintf(stderr, "gen_repos: %s: %s\n", what,
+			err && err->message ? err->message : "unknown error");
+}
+
+/* Version v of a file: its length and one line out of five depend on v,
+ * so that consecutive versions differ by a few insertions and deletions */
+static bool write_blob(gen_state_t *state, size_t file, git_oid *oid)
+{
+	const uint32_t version = state->versions[file];
+	const size_t n_lines = 10 + version % 20;
+	size_t len = 0;
+
+	for (size_t i = 0; i < n_lines; i++) {
+		const uint32_t rev = i % 5 == version % 5 ? version : 0;
+		len += (size_t)snprintf(state->content + len, BYTES_PER_LINE,
+								"int f%zu_%zu(void) { return %u; }\n", file, i, rev);
+	}
+
+	if (git_blob_create_from_buffer(oid, state->repo, state->content, len) != 0) {
+		print_git_error("cannot create blob");
+		return false;
+	}
+	return true;
+}
+
+static bool change_file(gen_state_t *state, size_t file, change_t *change)
+{
+	state->versions[file]++;
+	change->file = file;
+	return write_blob(state, file, &change->blob);
+}
+
+/* The tree of the head with `changes` applied; without a head, the first
+ * tree with every file */
+static bool build_tree(gen_state_t *state, const change_t *changes, size_t n_changes,
+					   git_tree **out)
+{
+	git_treebuilder *builder = NULL;
+	char name[FILE_NAME_SIZE];
+	git_oid oid;
+	bool ok = false;
+
+	if (git_treebuilder_new(&builder, state->repo, state->head_tree) != 0) { goto cleanup; }
+
+	if (!state->head_tree) {
+		for (size_t i = 0; i < state->opts->n_files; i++) {
+			(void)snprintf(name, sizeof(name), "module_%04zu.c", i);
+			if (!write_blob(state, i, &oid)) { goto cleanup; }
+			if (git_treebuilder_insert(NULL, builder, name, &oid, GIT_FILEMODE_BLOB) != 0) {
+				goto cleanup;
+			}
+		}
+	}
+
+	for (size_t i = 0; i < n_changes; i++) {
+		(void)snprintf(name, sizeof(name), "module_%04zu.c", changes[i].file);
+		if (git_treebuilder_insert(NULL, builder, name, &changes[i].blob,
+								   GIT_FILEMODE_BLOB) != 0) {
+			goto cleanup;
+		}
+	}
+
+	ok = git_treebuilder_write(&oid, builder) == 0 && git_tree_lookup(out, state->repo, &oid) == 0;
+
+cleanup:
+	if (!ok) { print_git_error("cannot build tree"); }
+	git_treebuilder_free(builder);
+	return ok;
+}
+
+/* Subject, a body of about msg_len bytes wrapped at LINE_WIDTH and,
+ * sometimes, a Co-authored-by trailer */
+static void write_message(gen_state_t *state, const char *subject, bool own, size_t author)
+{
+	static const char *words[] = {
+		"refactor", "the", "parser", "to", "handle", "edge", "cases", "in",
+		"walk", "cache", "render", "output", "when", "empty", "history", "fix"
+	};
+	const gen_options_t *opts = state->opts;
+	size_t len = (size_t)snprintf(state->msg, MAX_MSG_LEN, "%s\n\n", subject);
+	size_t line = 0;
+
+	while (len < opts->msg_len) {
+		const char *word = words[next_rand() % (sizeof(words) / sizeof(words[0]))];
+		const size_t word_len = strlen(word);
+		if (len + word_len + 2 >= opts->msg_len) { break; }
+		if (line + word_len + 1 > LINE_WIDTH) {
+			state->msg[len++] = '\n';
+			line = 0;
+		} else if (line > 0) {
+			state->msg[len++] = ' ';
+			line++;
+		}
+		memcpy(state->msg + len, word, word_len);
+		len += word_len;
+		line += word_len;
+	}
+	state->msg[len] = '\0';
+
+	if (chance(opts->co_author_pct)) {
+		/* Co-authored by the given email, or by someone else when the
+		 * commit is already ours */
+		size_t co_author = (author + 1 + next_rand() % opts->n_authors) % opts->n_authors;
+		if (own) {
+			(void)snprintf(state->msg + len, MAX_MSG_LEN - len,
+						   "\n\nCo-authored-by: Dev %zu <dev%zu@example.com>\n",
+						   co_author, co_author);
+		} else {
+			(void)snprintf(state->msg + len, MAX_MSG_LEN - len,
+						   "\n\nCo-authored-by: Me <%s>\n", opts->email);
+		}
+	}
+}
+
+static bool commit(gen_state_t *state, const char *update_ref, const git_tree *tree,
+				   const git_commit **parents, size_t n_parents, const char *subject,
+				   git_commit **out)
+{
+	const gen_options_t *opts = state->opts;
+	git_signature *signature = NULL;
+	git_oid oid;
+	char name[32], email[64];
+	const bool own = chance(opts->own_pct);
+	const size_t author = next_rand() % opts->n_authors;
+
+	if (own) {
+		(void)snprintf(name, sizeof(name), "Me");
+		(void)snprintf(email, sizeof(email), "%s", opts->email);
+	} else {
+		(void)snprintf(name, sizeof(name), "Dev %zu", author);
+		(void)snprintf(email, sizeof(email), "dev%zu@example.com", author);
+	}
+
+	state->now += 60 + next_rand() % 7200;
+	write_message(state, subject, own, author);
+
+	bool ok = git_signature_new(&signature, name, email, state->now, 0) == 0
+			  && git_commit_create(&oid, state->repo, update_ref, signature, signature,
+								   NULL, state->msg, tree, n_parents, parents) == 0
+			  && git_commit_lookup(out, state->repo, &oid) == 0;
+	if (!ok) { print_git_error("cannot create commit"); }
+	git_signature_free(signature);
+	state->n_created++;
+	return ok;
+}
+
+/* Main line commit changing a few random files */
+static bool add_commit(gen_state_t *state)
+{
+	change_t changes[MAX_FILES_PER_COMMIT];
+	const size_t n_files = state->opts->n_files;
+	size_t n_changes = 1 + next_rand() % MAX_FILES_PER_COMMIT;
+	const size_t first = next_rand() % n_files;
+	const git_commit *parents[1] = { state->head };
+	git_tree *tree = NULL;
+	git_commit *head = NULL;
+	char subject[64];
+
+	/* Adjacent files, so that no file is changed twice */
+	if (n_changes > n_files) { n_changes = n_files; }
+	for (size_t i = 0; i < n_changes; i++) {
+		if (!change_file(state, (first + i) % n_files, changes + i)) { return false; }
+	}
+	(void)snprintf(subject, sizeof(subject), "Change %zu in module_%04zu.c",
+				   state->n_created, changes[0].file);
+
+	const bool ok = build_tree(state, changes, state->head ? n_changes : 0, &tree)
+					&& commit(state, "HEAD", tree, parents, state->head ? 1 : 0, subject, &head);
+	if (!ok) {
+		git_tree_free(tree);
+		return false;
+	}
+
+	git_commit_free(state->head);
+	git_tree_free(state->head_tree);
+	state->head = head;
+	state->head_tree = tree;
+	return true;
+}
+
+/* fan_in - 1 side commits forked from the head, then merged back together
+ * with the head */
+static bool add_merge(gen_state_t *state)
+{
+	const size_t n_sides = state->opts->fan_in - 1;
+	const git_commit *parents[MAX_FAN_IN] = { state->head };
+	change_t changes[MAX_FAN_IN];
+	git_tree *tree = NULL;
+	git_commit *head = NULL;
+	char subject[64];
+	bool ok = true;
+
+	for (size_t i = 0; i < n_sides && ok; i++) {
+		git_tree *side_tree = NULL;
+		git_commit *side = NULL;
+
+		(void)snprintf(subject, sizeof(subject), "Side change %zu", state->n_created);
+		ok = change_file(state, next_rand() % state->opts->n_files, changes + i)
+			 && build_tree(state, changes + i, 1, &side_tree)
+			 && commit(state, NULL, side_tree, parents, 1, subject, &side);
+		git_tree_free(side_tree);
+		parents[i + 1] = side;
+	}
+
+	(void)snprintf(subject, sizeof(subject), "Merge %zu branches", n_sides);
+	ok = ok
+		 && build_tree(state, changes, n_sides, &tree)
+		 && commit(state, "HEAD", tree, parents, n_sides + 1, subject, &head);
+
+	for (size_t i = 1; i <= n_sides; i++) {
+		git_commit_free((git_commit *)parents[i]);
+	}
+	if (!ok) {
+		git_tree_free(tree);
+		return false;
+	}
+
+	git_commit_free(state->head);
+	git_tree_free(state->head_tree);
+	state->head = head;
+	state->head_tree = tree;
+	return true;
+}
+
+static bool generate_repo(const gen_options_t *opts, const char *path)
+{
+	gen_state_t state = {
+		.opts = opts,
+		.now = BASE_DATE,
+		.versions = calloc(opts->n_files, sizeof(uint32_t)),
+		.content = malloc(30 * BYTES_PER_LINE),
+		.msg = malloc(MAX_MSG_LEN)
+	};
+	bool ok = state.versions && state.content && state.msg;
+
+	if (ok && git_repository_init(&state.repo, path, 0) != 0) {
+		print_git_error("cannot create repository");
+		ok = false;
+	}
+
+	while (ok && state.n_created < opts->n_commits) {
+		const bool merge = opts->merge_every
+						   && state.head
+						   && state.n_created % opts->merge_every == 0
+						   && state.n_created + opts->fan_in <= opts->n_commits;
+		ok = merge ? add_merge(&state) : add_commit(&state);
+	}
+
+	git_commit_free(state.head);
+	git_tree_free(state.head_tree);
+	git_repository_free(state.repo);
+	free(state.versions);
+	free(state.content);
+	free(state.msg);
+	return ok;
+}
+
+static bool parse_size(const char *arg, size_t min, size_t max, size_t *out)
+{
+	char *end = NULL;
+	const unsigned long long value = strtoull(arg, &end, 10);
+
+	if (!*arg || *end || *arg == '-' || value < min || value > max) { return false; }
+	*out = (size_t)value;
+	return true;
+}
+
+static void usage(void)
+{
+	fprintf(stderr,
+			"Usage: gen_repos -o DIR [OPTIONS]\n"
+			"  -o DIR     Output directory: DIR/repo_NNN and DIR/.rlist\n"
+			"  -n N       Number of repositories (default 4)\n"
+			"  -c N       Commits per repository, merges included (default 1000)\n"
+			"  -f N       Files per repository (default 32)\n"
+			"  -M N       A merge every N commits, 0 for none (default 0)\n"
+			"  -F N       Parents of each merge, 2 to %d (default 2)\n"
+			"  -l N       Approximate length of the messages in bytes (default 200)\n"
+			"  -C PCT     Commits with a Co-authored-by trailer (default 10)\n"
+			"  -a N       Number of other authors (default 8)\n"
+			"  -p PCT     Commits authored by EMAIL (default 50)\n"
+			"  -e EMAIL   Email of the author to report (default me@example.com)\n"
+			"  -s SEED    Random seed (default 1)\n",
+			MAX_FAN_IN);
+}
+
+int main(int argc, char *argv[])
+{
+	gen_options_t opts = {
+		.n_repos = 4,
+		.n_commits = 1000,
+		.n_files = 32,
+		.merge_every = 0,
+		.fan_in = 2,
+		.msg_len = 200,
+		.co_author_pct = 10,
+		.n_authors = 8,
+		.own_pct = 50,
+		.email = "me@example.com",
+		.out_dir = NULL,
+		.seed = 1
+	};
+	size_t value = 0;
+	int ch;
+	bool valid = true;
+
+	while ((ch = getopt(argc, argv, "o:n:c:f:M:F:l:C:a:p:e:s:h")) != -1 && valid) {
+		switch (ch) {
+		case 'o': opts.out_dir = optarg; break;
+		case 'n': valid = parse_size(optarg, 1, 100000, &opts.n_repos); break;
+		case 'c': valid = parse_size(optarg, 1, UINT32_MAX, &opts.n_commits); break;
+		case 'f': valid = parse_size(optarg, 1, 100000, &opts.n_files); break;
+		case 'M': valid = parse_size(optarg, 0, UINT32_MAX, &opts.merge_every); break;
+		case 'F': valid = parse_size(optarg, 2, MAX_FAN_IN, &opts.fan_in); break;
+		case 'l': valid = parse_size(optarg, 0, MAX_MSG_LEN - 256, &opts.msg_len); break;
+		case 'a': valid = parse_size(optarg, 1, 100000, &opts.n_authors); break;
+		case 'e': opts.email = optarg; break;
+		case 'C':
+		case 'p':
+			valid = parse_size(optarg, 0, 100, &value);
+			*(ch == 'C' ? &opts.co_author_pct : &opts.own_pct) = (unsigned)value;
+			break;
+		case 's':
+			valid = parse_size(optarg, 0, UINT64_MAX, &value);
+			opts.seed = value;
+			break;
+		default:
+			valid = false;
+			break;
+		}
+	}
+
+	if (!valid || !opts.out_dir || strlen(opts.email) > 48) {
+		usage();
+		return 1;
+	}
+
+	char *dir = realpath(opts.out_dir, NULL);
+	if (!dir) {
+		fprintf(stderr, "gen_repos: %s must be an existing directory\n", opts.out_dir);
+		return 1;
+	}
+
+	char *rlist_path = malloc(strlen(dir) + sizeof("/.rlist"));
+	sprintf(rlist_path, "%s/.rlist", dir);
+	FILE *rlist = fopen(rlist_path, "w");
+	free(rlist_path);
+	if (!rlist) {
+		fprintf(stderr, "gen_repos: cannot write %s/.rlist\n", dir);
+		free(dir);
+		return 1;
+	}
+
+	git_libgit2_init();
+	int ret = 0;
+	char *path = malloc(strlen(dir) + 32);
+
+	for (size_t i = 0; i < opts.n_repos && ret == 0; i++) {
+		/* Each repository has its own stream, so that its content does
+		 * not change with -n */
+		rng_state = (opts.seed + 1) * 0x9E3779B97F4A7C15ULL + i;
+		sprintf(path, "%s/repo_%03zu", dir, i);
+		if (access(path, F_OK) == 0) {
+			fprintf(stderr, "gen_repos: %s already exists\n", path);
+			ret = 1;
+			break;
+		}
+		if (!generate_repo(&opts, path)) {
+			ret = 1;
+			break;
+		}
+		fprintf(rlist, "%s[https://github.com/synthetic/repo_%03zu]\n", path, i);
+		fprintf(stderr, "%s: %zu commits\n", path, opts.n_commits);
+	}
+
+	git_libgit2_shutdown();
+	free(path);
+	free(dir);
+	if (fclose(rlist) != 0) { ret = 1; }
+	return ret;
+}
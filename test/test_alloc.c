@@ -0,0 +1,137 @@
+/* test_alloc.c
+ * -----------------------------------------------------------------------
+ * Copyright (C) 2025  Matteo Nicoli
+ *
+ * This file is part of TUR.
+ *
+ * TUR is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "test.h"
+#include "../src/alloc.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+static bool is_aligned(const void *ptr)
+{
+	return (uintptr_t)ptr % _Alignof(max_align_t) == 0;
+}
+
+static bool is_filled(const unsigned char *buf, size_t len, unsigned char value)
+{
+	for (size_t i = 0; i < len; i++) {
+		if (buf[i] != value) { return false; }
+	}
+	return true;
+}
+
+void test_alloc_count(void)
+{
+	setenv("TUR_ALLOC", "count", 1);
+	alloc_init();
+	assert_true(alloc_backend() == BACKEND_COUNT, "count: the count backend should be selected");
+
+	const alloc_tag_t previous = alloc_set_tag(ALLOC_WALK);
+	assert_true(previous == ALLOC_OTHER, "threads should start with the `other` tag");
+
+	char *a = tur_malloc(100);
+	assert_true(a && is_aligned(a), "count: tur_malloc should return an aligned block");
+	assert_true(alloc_live_bytes(ALLOC_WALK) == 100, "count: 100 bytes should be live in walk");
+
+	a = tur_realloc(a, 300);
+	assert_true(alloc_live_bytes(ALLOC_WALK) == 300, "count: realloc should update the live bytes");
+
+	(void)alloc_set_tag(ALLOC_RENDER);
+	unsigned char *b = tur_calloc(10, 8);
+	assert_true(b && is_filled(b, 80, 0), "count: tur_calloc should zero the block");
+	assert_true(alloc_live_bytes(ALLOC_RENDER) == 80, "count: 80 bytes should be live in render");
+
+	/* Freed blocks are accounted to the tag they were allocated with */
+	tur_free(a);
+	tur_free(b);
+	tur_free(NULL);
+	assert_true(alloc_live_bytes(ALLOC_WALK) == 0, "count: nothing should be live in walk");
+	assert_true(alloc_live_bytes(ALLOC_RENDER) == 0, "count: nothing should be live in render");
+
+	(void)alloc_set_tag(ALLOC_OTHER);
+}
+
+void test_alloc_arena(void)
+{
+	setenv("TUR_ALLOC", "arena", 1);
+	alloc_init();
+	assert_true(alloc_backend() == BACKEND_ARENA, "arena: the arena backend should be selected");
+
+	unsigned char *a = tur_malloc(24);
+	unsigned char *b = tur_malloc(24);
+	assert_true(a && b && is_aligned(a) && is_aligned(b), "arena: blocks should be aligned");
+	assert_true(a + 24 <= b || b + 24 <= a, "arena: blocks should not overlap");
+
+	memset(b, 0xab, 24);
+	unsigned char *grown = tur_realloc(b, 200);
+	assert_true(grown == b, "arena: the last block should grow in place");
+	assert_true(is_filled(grown, 24, 0xab), "arena: growing should keep the content");
+
+	memset(a, 0xcd, 24);
+	unsigned char *moved = tur_realloc(a, 200);
+	assert_true(moved && moved != a, "arena: a block in the middle should be moved");
+	assert_true(is_filled(moved, 24, 0xcd), "arena: moving should keep the content");
+
+	unsigned char *zeroed = tur_calloc(64, 1);
+	assert_true(zeroed && is_filled(zeroed, 64, 0), "arena: tur_calloc should zero the block");
+
+	/* Blocks larger than a quarter of a chunk have their own malloc */
+	const size_t large_size = 1 << 19;
+	unsigned char *large = tur_malloc(large_size);
+	assert_true(large && is_aligned(large), "arena: large blocks should be aligned");
+	memset(large, 0x11, large_size);
+	large = tur_realloc(large, 2 * large_size);
+	assert_true(large && is_filled(large, large_size, 0x11), "arena: large blocks should be reallocated");
+	tur_free(large);
+
+	/* Many blocks span several chunks */
+	bool ok = true;
+	for (size_t i = 0; i < 10000; i++) {
+		unsigned char *block = tur_malloc(1000);
+		if (!block || !is_aligned(block)) { ok = false; break; }
+		memset(block, (int)(i & 0xff), 1000);
+	}
+	assert_true(ok, "arena: allocations should span several chunks");
+
+	alloc_shutdown();
+}
+
+void test_alloc_libc(void)
+{
+	setenv("TUR_ALLOC", "libc", 1);
+	alloc_init();
+	assert_true(alloc_backend() == BACKEND_LIBC, "libc: the libc backend should be selected");
+
+	char *a = tur_malloc(16);
+	a = tur_realloc(a, 4096);
+	assert_true(a != NULL, "libc: tur_realloc should return a block");
+	assert_true(alloc_live_bytes(ALLOC_OTHER) == 0, "libc: nothing should be counted");
+	tur_free(a);
+}
+
+int main(void)
+{
+	test_alloc_count();
+	test_alloc_arena();
+	test_alloc_libc();
+	print_report();
+}
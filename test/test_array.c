@@ -41,85 +41,193 @@ commit_t make_commit(const char *hash, responsability_t r, time_t date,
 	return c;
 }
 
-void test_commit_array_add_get(void)
+/* Commits are kept in the generic array with a deep copy of their strings */
+static void assign_commit(void *dst, void *elem)
 {
-	commit_arr_t *arr = NULL;
-	commit_array_init(&arr);
+	const commit_t *src = (const commit_t *)elem;
+	commit_t *commit = (commit_t *)dst;
+	*commit = *src;
+	commit->hash = str_copy(src->hash);
+	commit->msg = str_copy(src->msg);
+}
+
+static int compare_commit(void *c1, void *c2)
+{
+	return str_compare(((commit_t *)c1)->hash, ((commit_t *)c2)->hash);
+}
+
+static void free_commit(void *c)
+{
+	commit_t *commit = (commit_t *)c;
+	str_free(commit->hash);
+	str_free(commit->msg);
+}
+
+void test_array_add_get(void)
+{
+	array_t *arr = NULL;
+	assert_true(array_init(&arr, sizeof(commit_t)) == OK, "array_init should return OK");
 
 	commit_t c1 = make_commit("abc123", AUTHORED, 0, "Initial commit", 1, 10, 0);
-	assert_true(commit_array_add(arr, &c1) == OK, "commit_array_add should return OK");
+	assert_true(array_add(arr, &c1, assign_commit) == OK, "array_add should return OK");
 
-	commit_t *c = commit_array_get(arr, 0);
+	commit_t *c = (commit_t *)arr->values;
 	assert_true(str_arr_equals(c->hash, "abc123"), "hash of first commit should be 'abc123'");
 	assert_true(c->stats.lines_added == 10, "lines_added should be 10");
 	assert_true(c->responsability == AUTHORED, "responsibility should be AUTHORED");
 
-	commit_free(&c1);
-	commit_array_free(&arr);
+	free_commit(&c1);
+	array_free(&arr, free_commit);
 }
 
-void test_commit_array_contains(void)
+void test_array_contains(void)
 {
-	commit_arr_t *arr = NULL;
-	commit_array_init(&arr);
+	array_t *arr = NULL;
+	array_init(&arr, sizeof(commit_t));
 
 	commit_t c1 = make_commit("abc123", AUTHORED, 0, "Initial commit", 1, 10, 0);
-	commit_array_add(arr, &c1);
+	array_add(arr, &c1, assign_commit);
 
 	commit_t c2 = make_commit("abc123", CO_AUTHORED, 100, "Something else", 0, 0, 0);
-	assert_true(commit_array_contains(arr, &c2), "commit_array_contains should match on hash only");
+	assert_true(array_contains(arr, &c2, compare_commit),
+				"array_contains should match through the compare function");
 
-	commit_free(&c1);
-	commit_free(&c2);
-	commit_array_free(&arr);
+	free_commit(&c1);
+	free_commit(&c2);
+	array_free(&arr, free_commit);
 }
 
-void test_commit_array_copy(void)
+void test_array_copy(void)
 {
-	commit_arr_t *arr = NULL;
-	commit_array_init(&arr);
+	array_t *arr = NULL;
+	array_init(&arr, sizeof(commit_t));
 
 	commit_t c1 = make_commit("abc123", AUTHORED, 0, "Initial commit", 1, 10, 0);
-	commit_array_add(arr, &c1);
+	array_add(arr, &c1, assign_commit);
 
-	commit_arr_t *copy = commit_array_copy(arr);
+	array_t *copy = array_copy(arr, assign_commit);
 
 	assert_true(copy != NULL, "copy should not be NULL");
 	assert_true(copy->len == arr->len, "copy should have same length as original");
-	assert_true(str_equals(commit_array_get(copy, 0)->hash, c1.hash), "first commit hash in copy should match original");
+	assert_true(str_equals(((commit_t *)copy->values)->hash, c1.hash),
+				"first commit hash in copy should match original");
 
-	commit_free(&c1);
-	commit_array_free(&arr);
-	commit_array_free(&copy);
+	free_commit(&c1);
+	array_free(&arr, free_commit);
+	array_free(&copy, free_commit);
 }
 
-void test_commit_array_empty_contains(void)
+void test_array_empty_contains(void)
 {
-	commit_arr_t *arr = NULL;
-	commit_array_init(&arr);
+	array_t *arr = NULL;
+	array_init(&arr, sizeof(commit_t));
 
 	commit_t c = make_commit("def456", AUTHORED, 0, "Missing", 0, 0, 0);
-	assert_true(!commit_array_contains(arr, &c), "empty array should not contain any commit");
+	assert_true(!array_contains(arr, &c, compare_commit), "empty array should not contain any commit");
 
-	commit_free(&c);
-	commit_array_free(&arr);
+	free_commit(&c);
+	array_free(&arr, free_commit);
 }
 
-void test_commit_array_multiple_add(void)
+void test_array_multiple_add(void)
 {
-	commit_arr_t *arr = NULL;
-	commit_array_init(&arr);
+	array_t *arr = NULL;
+	array_init(&arr, sizeof(commit_t));
 
-	for (int i = 0; i < 10; i++) {
+	for (int i = 0; i < 30; i++) {
 		char hash[16];
 		snprintf(hash, sizeof(hash), "hash%d", i);
 		commit_t c = make_commit(hash, AUTHORED, i, "msg", 1, i * 2, i);
-		assert_true(commit_array_add(arr, &c) == OK, "commit_array_add should return OK for multiple commits");
-		commit_free(&c);
+		assert_true(array_add(arr, &c, assign_commit) == OK,
+					"array_add should return OK past the initial capacity");
+		free_commit(&c);
 	}
 
-	assert_true(arr->len == 10, "array len should be 10");
-	commit_array_free(&arr);
+	assert_true(arr->len == 30, "array len should be 30");
+	assert_true(str_arr_equals(((commit_t *)arr->values)[29].hash, "hash29"),
+				"elements should survive the growth of the array");
+	array_free(&arr, free_commit);
+}
+
+void test_commit_table_add_row(void)
+{
+	commit_table_t table;
+	commit_stats_t stats = { 2, 10, 3 };
+	const char *hash = "0123456789abcdef0123456789abcdef01234567";
+
+	assert_true(commit_table_init(&table, 0) == OK, "commit_table_init should return OK");
+	assert_true(commit_table_add(&table, hash, "Subject\n\nBody", 42, CO_AUTHORED, &stats) == OK,
+				"commit_table_add should return OK");
+
+	commit_t c = commit_table_row(&table, 0);
+	assert_true(table.len == 1, "table len should be 1");
+	assert_true(str_arr_equals(c.hash, hash), "row hash should match the added one");
+	assert_true(str_arr_equals(c.msg, "Subject\n\nBody"), "row message should match the added one");
+	assert_true(c.date == 42 && c.responsability == CO_AUTHORED, "row date and responsability should match");
+	assert_true(c.stats.files_changed == 2 && c.stats.lines_added == 10 && c.stats.lines_removed == 3,
+				"row stats should match the added ones");
+
+	commit_table_add(&table, hash, "", 43, AUTHORED, &stats);
+	commit_table_add(&table, hash, "last", 44, AUTHORED, &stats);
+	assert_true(commit_table_row(&table, 0).msg.len == 13 && commit_table_row(&table, 1).msg.len == 0
+				&& str_arr_equals(commit_table_row(&table, 2).msg, "last"),
+				"row messages should end where the next one starts");
+
+	commit_table_free(&table);
+}
+
+void test_commit_table_select_sum(void)
+{
+	commit_table_t table;
+	uint32_t rows[100];
+	size_t added, removed;
+
+	commit_table_init(&table, 0);
+	for (int i = 0; i < 100; i++) {
+		char hash[16];
+		snprintf(hash, sizeof(hash), "hash%d", i);
+		commit_stats_t stats = { 1, (size_t)i, 1 };
+		commit_table_add(&table, hash, "msg", i, i % 3 == 0 ? CO_AUTHORED : AUTHORED, &stats);
+	}
+
+	const size_t n = commit_table_select(&table, CO_AUTHORED, rows);
+	bool all_co_authored = true;
+	for (size_t i = 0; i < n; i++) {
+		all_co_authored = all_co_authored && rows[i] % 3 == 0 && (i == 0 || rows[i - 1] < rows[i]);
+	}
+	assert_true(n == 34, "commit_table_select should find 34 co-authored commits");
+	assert_true(all_co_authored, "selected rows should be co-authored and in table order");
+
+	commit_table_sum_lines(&table, &added, &removed);
+	assert_true(added == 4950 && removed == 100, "commit_table_sum_lines should sum the stats columns");
+
+	commit_table_free(&table);
+}
+
+void test_commit_table_find_copy(void)
+{
+	commit_table_t table, copy;
+	commit_stats_t stats = { 0 };
+	str_t abc = str_init("abc", 3), def = str_init("def", 3);
+	uint32_t row = 0;
+
+	commit_table_init(&table, 1);
+	commit_table_add(&table, "abc123", "first", 1, AUTHORED, &stats);
+	commit_table_add(&table, "abc", "second", 2, AUTHORED, &stats);
+
+	assert_true(commit_table_find(&table, abc, &row) && row == 1,
+				"commit_table_find should match the whole hash");
+	assert_true(!commit_table_find(&table, def, &row),
+				"commit_table_find should not find a missing hash");
+
+	assert_true(commit_table_copy(&copy, &table) == OK, "commit_table_copy should return OK");
+	commit_table_free(&table);
+	assert_true(copy.len == 2 && str_arr_equals(commit_table_row(&copy, 1).msg, "second"),
+				"copied table should not depend on the source");
+
+	str_free(abc);
+	str_free(def);
+	commit_table_free(&copy);
 }
 
 repository_t make_repo(unsigned id, const char *name, const char *url, const char *path)
@@ -327,12 +435,17 @@ void test_cache_array_multiple_add(void)
 
 int main(void)
 {
-	/* commit array */
-	test_commit_array_add_get();
-	test_commit_array_contains();
-	test_commit_array_copy();
-	test_commit_array_empty_contains();
-	test_commit_array_multiple_add();
+	/* generic array */
+	test_array_add_get();
+	test_array_contains();
+	test_array_copy();
+	test_array_empty_contains();
+	test_array_multiple_add();
+
+	/* commit table */
+	test_commit_table_add_row();
+	test_commit_table_select_sum();
+	test_commit_table_find_copy();
 
 	/* repository array */
 	test_repo_array_add_get();
@@ -0,0 +1,241 @@
+/* test_columnar.c
+ * -----------------------------------------------------------------------
+ * Copyright (C) 2025  Matteo Nicoli
+ *
+ * This file is part of TUR.
+ *
+ * TUR is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "test.h"
+#include "../src/alloc.h"
+#include "../src/columnar.h"
+#include "../src/commit.h"
+#include "../src/repo.h"
+#include "../src/settings.h"
+#include "../src/sink.h"
+#include "../src/str.h"
+#include "../src/view.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define COLUMNAR_TEST_FILE "/tmp/tur_test_columnar.turc"
+
+/* A minimal reader, as a downstream tool would write it: the file is
+ * mapped and every column is addressed in place. */
+typedef struct {
+	const char *base;
+	size_t size;
+	const columnar_header_t *header;
+} columnar_file_t;
+
+static bool columnar_open(columnar_file_t *file, const char *path)
+{
+	struct stat st;
+	const int fd = open(path, O_RDONLY);
+	if (fd < 0) { return false; }
+	if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(columnar_header_t)) {
+		close(fd);
+		return false;
+	}
+
+	file->size = (size_t)st.st_size;
+	file->base = mmap(NULL, file->size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (file->base == MAP_FAILED) { return false; }
+
+	file->header = (const columnar_header_t *)file->base;
+	return memcmp(file->header->magic, COLUMNAR_MAGIC, COLUMNAR_MAGIC_SIZE) == 0
+		   && file->header->version == COLUMNAR_VERSION
+		   && file->header->byte_order == COLUMNAR_BYTE_ORDER_MARK
+		   && file->header->file_size == file->size;
+}
+
+static const void *columnar_column(const columnar_file_t *file, columnar_column_t col)
+{
+	return file->base + file->header->offsets[col];
+}
+
+static str_t columnar_string(const columnar_file_t *file, columnar_column_t offsets_col, size_t i)
+{
+	const uint64_t *offsets = columnar_column(file, offsets_col);
+	const char *heap = columnar_column(file, COLUMNAR_HEAP);
+	return STR_VIEW(heap + offsets[i], (size_t)(offsets[i + 1] - offsets[i]));
+}
+
+static void columnar_close(columnar_file_t *file)
+{
+	munmap((void *)file->base, file->size);
+}
+
+static work_history_t *make_history(unsigned repo_id, size_t n_authored, size_t n_co_authored)
+{
+	work_history_t *history = tur_calloc(1, sizeof(work_history_t));
+	const size_t n = n_authored + n_co_authored;
+	commit_table_init(&history->commits, 0);
+
+	for (size_t i = 0; i < n; i++) {
+		char hash[GIT_HASH_LEN + 1], msg[64];
+		for (size_t j = 0; j < GIT_HASH_LEN; j++) {
+			hash[j] = "0123456789abcdef"[(repo_id * 7 + i * 13 + j) % 16];
+		}
+		hash[GIT_HASH_LEN] = '\0';
+		snprintf(msg, sizeof(msg), "repo %u \"commit\" %zu\n\nbody", repo_id, i);
+		commit_stats_t stats = {
+			.files_changed = i + 1,
+			.lines_added = 10 * i + repo_id,
+			.lines_removed = i
+		};
+		/* Dates decrease, as the indexes of a DESC sorted walk */
+		commit_table_add(&history->commits, hash, msg,
+						 (time_t)(1000000 - 100 * i - repo_id),
+						 i < n_authored ? AUTHORED : CO_AUTHORED, &stats);
+	}
+
+	history->n_authored = n_authored;
+	history->n_co_authored = n_co_authored;
+	history->indexes.authored = tur_malloc((n_authored + 1) * sizeof(uint32_t));
+	history->indexes.co_authored = tur_malloc((n_co_authored + 1) * sizeof(uint32_t));
+	(void)commit_table_select(&history->commits, AUTHORED, history->indexes.authored);
+	(void)commit_table_select(&history->commits, CO_AUTHORED, history->indexes.co_authored);
+
+	return history;
+}
+
+static repository_array_t *make_repos(const size_t (*n_commits)[2], size_t n_repos)
+{
+	repository_array_t *repos = NULL;
+	repo_array_init(&repos);
+
+	for (unsigned i = 0; i < n_repos; i++) {
+		char path[32];
+		snprintf(path, sizeof(path), "/tmp/columnar_repo%u", i);
+		repository_t repo = parse_repository(path, strlen(path), i);
+		repo_array_add(repos, &repo);
+		str_free(repo.path);
+		str_free(repo.name);
+		str_free(repo.url);
+		repo_array_get(repos, i)->history = make_history(i, n_commits[i][0], n_commits[i][1]);
+	}
+
+	return repos;
+}
+
+static bool write_export(const repository_array_t *repos, const settings_t *settings)
+{
+	sink_t out;
+	if (sink_init_file(&out, COLUMNAR_TEST_FILE, false) != OK) { return false; }
+	generate_columnar_file(&out, repos, settings, NULL);
+	return sink_close(&out) == OK;
+}
+
+void test_columnar_roundtrip(void)
+{
+	const size_t n_commits[][2] = { { 5, 2 }, { 0, 0 }, { 3, 0 } };
+	repository_array_t *repos = make_repos(n_commits, 3);
+	settings_t settings = { .sorted = true, .sort_order = DESC };
+	columnar_file_t file;
+
+	assert_true(write_export(repos, &settings), "the columnar export should be written");
+	assert_true(columnar_open(&file, COLUMNAR_TEST_FILE), "the columnar export should have a valid header");
+
+	const columnar_header_t *header = file.header;
+	assert_true(header->n_commits == 10 && header->n_repos == 3, "the header should count commits and repositories");
+
+	bool aligned = true;
+	for (size_t col = 0; col < COLUMNAR_N_COLUMNS; col++) {
+		aligned = aligned && header->offsets[col] % COLUMNAR_ALIGNMENT == 0
+				  && header->offsets[col] <= file.size;
+	}
+	assert_true(aligned, "every column should be aligned and inside the file");
+
+	const uint32_t *repo_ids = columnar_column(&file, COLUMNAR_REPO_ID);
+	const int64_t *dates = columnar_column(&file, COLUMNAR_DATE);
+	const uint8_t *resps = columnar_column(&file, COLUMNAR_RESPONSABILITY);
+	const uint32_t *files_changed = columnar_column(&file, COLUMNAR_FILES_CHANGED);
+	const uint32_t *lines_added = columnar_column(&file, COLUMNAR_LINES_ADDED);
+	const uint32_t *lines_removed = columnar_column(&file, COLUMNAR_LINES_REMOVED);
+	const uint8_t *oids = columnar_column(&file, COLUMNAR_OID);
+	bool sorted = true, matching = true;
+
+	for (size_t i = 0; i < header->n_commits; i++) {
+		sorted = sorted && (i == 0 || dates[i - 1] >= dates[i]);
+
+		/* Every row must match the commit with the same hash */
+		char hash[GIT_HASH_LEN + 1];
+		for (size_t j = 0; j < COLUMNAR_OID_SIZE; j++) {
+			snprintf(hash + 2 * j, 3, "%02x", oids[i * COLUMNAR_OID_SIZE + j]);
+		}
+		const repository_t *repo = repo_array_get(repos, repo_ids[i]);
+		uint32_t row;
+		if (!repo || !commit_table_find(&repo->history->commits, STR_VIEW(hash, GIT_HASH_LEN), &row)) {
+			matching = false;
+			continue;
+		}
+		const commit_t commit = commit_table_row(&repo->history->commits, row);
+		const str_t msg = columnar_string(&file, COLUMNAR_MSG_OFFSET, i);
+		matching = matching
+				   && dates[i] == commit.date
+				   && resps[i] == (uint8_t)commit.responsability
+				   && files_changed[i] == commit.stats.files_changed
+				   && lines_added[i] == commit.stats.lines_added
+				   && lines_removed[i] == commit.stats.lines_removed
+				   && msg.len == commit.msg.len
+				   && memcmp(msg.val, commit.msg.val, msg.len) == 0;
+	}
+	assert_true(sorted, "the rows should follow the timeline order");
+	assert_true(matching, "every row should match its commit, hash and message included");
+
+	bool names = true;
+	for (size_t i = 0; i < header->n_repos; i++) {
+		const str_t name = columnar_string(&file, COLUMNAR_REPO_NAME_OFFSET, i);
+		const repository_t *repo = repo_array_get(repos, i);
+		names = names && name.len == repo->name.len && memcmp(name.val, repo->name.val, name.len) == 0;
+	}
+	assert_true(names, "the heap should hold the repository names");
+
+	columnar_close(&file);
+	unlink(COLUMNAR_TEST_FILE);
+	repo_array_free(&repos);
+}
+
+void test_columnar_empty(void)
+{
+	const size_t n_commits[][2] = { { 0, 0 } };
+	repository_array_t *repos = make_repos(n_commits, 1);
+	settings_t settings = { 0 };
+	columnar_file_t file;
+
+	assert_true(write_export(repos, &settings), "an export without commits should be written");
+	assert_true(columnar_open(&file, COLUMNAR_TEST_FILE), "an export without commits should be valid");
+	assert_true(file.header->n_commits == 0 && file.header->n_repos == 1,
+				"an export without commits should still list the repositories");
+
+	columnar_close(&file);
+	unlink(COLUMNAR_TEST_FILE);
+	repo_array_free(&repos);
+}
+
+int main(void)
+{
+	test_columnar_roundtrip();
+	test_columnar_empty();
+	print_report();
+}
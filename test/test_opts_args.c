@@ -151,9 +151,67 @@ void test_parse_sort_order(void) {
 	}
 }
 
+void test_parse_output_file_ext(void) {
+	assert_true(parse_output_file_ext("out.tex") == LATEX, "'.tex' should select LaTeX");
+	assert_true(parse_output_file_ext("out.HTM") == HTML, "'.HTM' should select HTML");
+	assert_true(parse_output_file_ext("out.md") == JEKYLL, "'.md' should select Markdown");
+	assert_true(parse_output_file_ext("out.json") == JSON, "'.json' should select JSON");
+	assert_true(parse_output_file_ext("a.b/out.ndjson") == NDJSON, "'.ndjson' should select NDJSON");
+	assert_true(parse_output_file_ext("out.jsonl") == NDJSON, "'.jsonl' should select NDJSON");
+	assert_true(parse_output_file_ext("out.csv") == CSV, "'.csv' should select CSV");
+	assert_true(parse_output_file_ext("out.TSV") == TSV, "'.TSV' should select TSV");
+	assert_true(parse_output_file_ext("out.turc") == COLUMNAR, "'.turc' should select the columnar export");
+	assert_true(parse_output_file_ext("out.jsonx") == STDOUT, "'.jsonx' should fall back to stdout");
+	assert_true(parse_output_file_ext("json") == STDOUT, "a file without extension should fall back to stdout");
+}
+
+void test_parse_jobs(void) {
+	{
+		size_t n_threads = 4;
+		bool adaptive = true;
+		int result = parse_jobs("16", &n_threads, &adaptive);
+		assert_true(result == OK && n_threads == 16 && !adaptive, "'16' should set sixteen threads");
+	}
+
+	{
+		size_t n_threads = 4;
+		bool adaptive = false;
+		int result = parse_jobs("AUTO", &n_threads, &adaptive);
+		assert_true(result == OK && n_threads == 4 && adaptive, "'AUTO' should enable the adaptive mode");
+	}
+
+	{
+		size_t n_threads = 4;
+		bool adaptive = false;
+		assert_true(parse_jobs("0", &n_threads, &adaptive) != OK && n_threads == 4,
+					"'0' should not be a valid number of jobs");
+		assert_true(parse_jobs("513", &n_threads, &adaptive) != OK, "jobs should be capped at MAX_THREADS");
+		assert_true(parse_jobs("-2", &n_threads, &adaptive) != OK, "negative jobs should be rejected");
+		assert_true(parse_jobs("4x", &n_threads, &adaptive) != OK, "'4x' should be rejected");
+		assert_true(parse_jobs(NULL, &n_threads, &adaptive) == REQUIRED_ARG_NULL, "the argument should be required");
+	}
+}
+
+void test_parse_progress(void) {
+	progress_mode_t mode = PROGRESS_OFF;
+
+	assert_true(parse_progress(NULL, &mode) == OK && mode == PROGRESS_TEXT,
+				"no argument should select the text reports");
+	assert_true(parse_progress("JSON", &mode) == OK && mode == PROGRESS_JSON,
+				"'JSON' should select the JSON reports");
+	assert_true(parse_progress("text", &mode) == OK && mode == PROGRESS_TEXT,
+				"'text' should select the text reports");
+	assert_true(parse_progress("yaml", &mode) != OK && mode == PROGRESS_TEXT,
+				"an unknown format should be rejected");
+	assert_true(parse_progress("json", NULL) == NULL_PARAMETER, "the mode should be required");
+}
+
 int main(void)
 {
 	test_parse_optarg_to_int();
 	test_parse_sort_order();
+	test_parse_output_file_ext();
+	test_parse_jobs();
+	test_parse_progress();
 	print_report();
 }
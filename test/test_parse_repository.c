@@ -169,6 +169,22 @@ void test_parse_repository()
 		str_array_free(&repo.branches);
 	}
 
+	{
+		const char *line = "repo/path:v1.2..HEAD,main..feature,^old[https://example.com/]";
+		repository_t repo = parse_repository(line, strlen(line), 0);
+
+		assert_true(str_arr_equals(repo.path, "repo/path"), "Path should be 'repo/path'");
+		assert_true(repo.branches->len == 3, "Should have three revisions");
+		assert_true(str_arr_equals(str_array_get(repo.branches, 0), "v1.2..HEAD"), "Revision[0] should be 'v1.2..HEAD'");
+		assert_true(str_arr_equals(str_array_get(repo.branches, 1), "main..feature"), "Revision[1] should be 'main..feature'");
+		assert_true(str_arr_equals(str_array_get(repo.branches, 2), "^old"), "Revision[2] should be '^old'");
+
+		str_free(repo.path);
+		str_free(repo.name);
+		str_free(repo.url);
+		str_array_free(&repo.branches);
+	}
+
 	{
 		const char *line = ":main[https://example.com/]";
 		repository_t repo = parse_repository(line, strlen(line), 0);
@@ -198,6 +214,49 @@ void test_parse_repository()
 		str_free(repo.url);
 		str_array_free(&repo.branches);
 	}
+
+	/* Budgets */
+	{
+		const char *line = "repo/path:main[https://example.com/] {time=60,commits=100000}";
+		repository_t repo = parse_repository(line, strlen(line), 0);
+
+		assert_true(str_arr_equals(repo.url, "https://example.com/"), "URL should be 'https://example.com/'");
+		assert_true(str_arr_equals(str_array_get(repo.branches, 0), "main"), "Branch should be 'main'");
+		assert_true(repo.budget.max_seconds == 60, "Time budget should be 60 seconds");
+		assert_true(repo.budget.max_commits == 100000, "Commit budget should be 100000");
+		assert_true(repo.budget.max_diffs == 0, "Diff budget should not be set");
+
+		str_free(repo.path);
+		str_free(repo.name);
+		str_free(repo.url);
+		str_array_free(&repo.branches);
+	}
+
+	{
+		const char *line = "path/to/repo{diffs=0}";
+		repository_t repo = parse_repository(line, strlen(line), 0);
+
+		assert_true(str_arr_equals(repo.path, "path/to/repo"), "Path should be 'path/to/repo'");
+		assert_true(repo.url.len == 0, "URL should be empty");
+		assert_true(repo.budget.max_diffs == BUDGET_UNLIMITED, "diffs=0 should lift the diff budget");
+
+		str_free(repo.path);
+		str_free(repo.name);
+		str_free(repo.url);
+	}
+
+	{
+		const char *line = "repo/path[https://example.com/]{pages=3}";
+		repository_t repo = parse_repository(line, strlen(line), 0);
+
+		assert_true(str_arr_equals(repo.url, "https://example.com/"), "URL should be 'https://example.com/'");
+		assert_true(repo.budget.max_seconds == 0 && repo.budget.max_commits == 0
+					&& repo.budget.max_diffs == 0, "An invalid budget should be ignored");
+
+		str_free(repo.path);
+		str_free(repo.name);
+		str_free(repo.url);
+	}
 }
 
 int main(void)
@@ -0,0 +1,243 @@
+/* test_query.c
+ * -----------------------------------------------------------------------
+ * Copyright (C) 2025  Matteo Nicoli
+ *
+ * This file is part of TUR.
+ *
+ * TUR is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "test.h"
+#include "../src/alloc.h"
+#include "../src/commit.h"
+#include "../src/query.h"
+#include "../src/settings.h"
+#include "../src/str.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+
+#define ERROR_SIZE 256
+#define REQUEST_SIZE 64
+
+static str_array_t *cli_emails = NULL;
+
+/* Settings as tur was started: `tur -e me@example.com --serve ...` */
+static settings_t cli_settings(void)
+{
+	settings_t settings = { 0 };
+	settings.emails = cli_emails;
+	return settings;
+}
+
+static bool parse(const char *line, query_t *query, char *error)
+{
+	char request[REQUEST_SIZE * 2];
+	const settings_t settings = cli_settings();
+
+	(void)snprintf(request, sizeof(request), "%s", line);
+	query_init(query, &settings);
+	error[0] = '\0';
+	return parse_query(request, query, error, ERROR_SIZE);
+}
+
+void test_parse_query_cli_emails(void)
+{
+	query_t query;
+	char error[ERROR_SIZE];
+
+	assert_true(parse("format=json group diffs", &query, error),
+				"a query without emails= should be accepted with -e");
+	assert_true(query.settings.emails == cli_emails && !query.owns_emails,
+				"the emails of -e should be used as they are");
+	assert_true(query.settings.output_mode == JSON, "format=json should select JSON");
+	assert_true(query.settings.grouped && query.settings.show_diffs && !query.settings.print_msg,
+				"flags should set only their options");
+	assert_true(!query.settings.sorted && query.since == 0 && query.until == 0,
+				"a query without sort, since and until should keep every commit in order");
+	query_free(&query);
+
+	assert_true(parse("", &query, error) && query.settings.output_mode == STDOUT,
+				"an empty query should render text");
+	query_free(&query);
+}
+
+void test_parse_query_emails(void)
+{
+	query_t query;
+	char error[ERROR_SIZE];
+
+	assert_true(parse("emails=a@b.c,d@e.f format=md", &query, error),
+				"emails= should be accepted");
+	assert_true(query.owns_emails && query.settings.emails != cli_emails
+				&& query.settings.emails->len == 2
+				&& str_arr_equals(str_array_get(query.settings.emails, 0), "a@b.c")
+				&& str_arr_equals(str_array_get(query.settings.emails, 1), "d@e.f"),
+				"emails= should override the emails of -e");
+	query_free(&query);
+	assert_true(cli_emails->len == 1, "the emails of -e should not be modified");
+
+	assert_true(parse("emails=a@b.c emails=x@y.z", &query, error)
+				&& query.settings.emails->len == 1
+				&& str_arr_equals(str_array_get(query.settings.emails, 0), "x@y.z"),
+				"the last emails= should win");
+	query_free(&query);
+
+	assert_true(!parse("emails= group", &query, error) && strstr(error, "no emails"),
+				"an empty emails= should be rejected");
+	query_free(&query);
+
+	settings_t no_emails = { 0 };
+	char request[] = "group";
+	query_init(&query, &no_emails);
+	assert_true(!parse_query(request, &query, error, ERROR_SIZE),
+				"a query should be rejected without emails= nor -e");
+	query_free(&query);
+}
+
+void test_parse_query_invalid(void)
+{
+	query_t query;
+	char error[ERROR_SIZE];
+
+	assert_true(!parse("group color=red", &query, error) && strstr(error, "color=red"),
+				"an unknown key should be rejected and reported");
+	query_free(&query);
+	assert_true(!parse("verbose", &query, error) && strstr(error, "verbose"),
+				"an unknown flag should be rejected and reported");
+	query_free(&query);
+	assert_true(!parse("format=pdf", &query, error), "an unknown format should be rejected");
+	query_free(&query);
+
+	assert_true(!parse("sort=sideways", &query, error) && !query.settings.sorted,
+				"an invalid sort should be rejected without enabling the sort");
+	query_free(&query);
+	assert_true(parse("sort=desc", &query, error)
+				&& query.settings.sorted && query.settings.sort_order == DESC,
+				"sort=desc should sort in descending order");
+	query_free(&query);
+}
+
+void test_parse_query_bounds(void)
+{
+	query_t query;
+	char error[ERROR_SIZE];
+
+	assert_true(parse("since=100 until=200", &query, error)
+				&& query.since == 100 && query.until == 200,
+				"since and until should be parsed as Unix times");
+	query_free(&query);
+
+	assert_true(!parse("since=-1", &query, error), "a negative since should be rejected");
+	query_free(&query);
+	assert_true(!parse("until=12abc", &query, error), "a non numeric until should be rejected");
+	query_free(&query);
+	assert_true(!parse("since=", &query, error), "an empty since should be rejected");
+	query_free(&query);
+}
+
+void test_select_rows(void)
+{
+	const time_t dates[] = { 150, 50, 200, 100, 199, 250, 120 };
+	const size_t n_dates = sizeof(dates) / sizeof(dates[0]);
+	const commit_stats_t stats = { 0 };
+	work_history_t history = { 0 };
+	query_t query;
+	char error[ERROR_SIZE];
+	size_t n = 0;
+
+	commit_table_init(&history.commits, 0);
+	for (size_t i = 0; i < n_dates; i++) {
+		char hash[16];
+		(void)snprintf(hash, sizeof(hash), "hash%zu", i);
+		commit_table_add(&history.commits, hash, "msg", dates[i],
+						 i == n_dates - 1 ? CO_AUTHORED : AUTHORED, &stats);
+	}
+
+	(void)parse("since=100 until=200", &query, error);
+	uint32_t *rows = select_rows(&history, AUTHORED, &query, &n);
+	assert_true(rows && n == 3 && rows[0] == 0 && rows[1] == 3 && rows[2] == 4,
+				"since should be inclusive and until exclusive, in the order of the walk");
+	tur_free(rows);
+
+	rows = select_rows(&history, CO_AUTHORED, &query, &n);
+	assert_true(rows && n == 1 && rows[0] == 6, "only the rows of the responsability should be selected");
+	tur_free(rows);
+	query_free(&query);
+
+	(void)parse("since=100 sort=desc", &query, error);
+	rows = select_rows(&history, AUTHORED, &query, &n);
+	assert_true(rows && n == 5 && rows[0] == 5 && rows[1] == 2 && rows[2] == 4
+				&& rows[3] == 0 && rows[4] == 3,
+				"without until, every later commit should be selected, sorted by date");
+	tur_free(rows);
+	query_free(&query);
+
+	commit_table_free(&history.commits);
+}
+
+static bool read_written(const char *data, size_t len, char *buf)
+{
+	int fds[2];
+
+	if (pipe(fds) != 0) { return false; }
+	const bool written = write(fds[1], data, len) == (ssize_t)len;
+	close(fds[1]);
+	const bool read = written && read_request(fds[0], buf, REQUEST_SIZE, NULL);
+	close(fds[0]);
+	return read;
+}
+
+void test_read_request(void)
+{
+	char buf[REQUEST_SIZE];
+	char full[REQUEST_SIZE];
+	const char *line = "emails=a@b.c group\nignored";
+
+	assert_true(read_written(line, strlen(line), buf) && strcmp(buf, "emails=a@b.c group") == 0,
+				"the request should end at its newline");
+	assert_true(read_written("format=json", 11, buf) && strcmp(buf, "format=json") == 0,
+				"a request without newline should end with the stream");
+	assert_true(!read_written("\n", 1, buf), "an empty request should be rejected");
+
+	memset(full, 'a', sizeof(full));
+	assert_true(!read_written(full, sizeof(full), buf),
+				"a request that fills the buffer without a newline should be rejected");
+	assert_true(!read_written(full, sizeof(full) - 1, buf),
+				"a request of exactly the buffer size without a newline should be rejected");
+	full[REQUEST_SIZE - 2] = '\n';
+	assert_true(read_written(full, sizeof(full) - 1, buf) && strlen(buf) == REQUEST_SIZE - 2,
+				"the longest request should fit with its newline");
+}
+
+int main(void)
+{
+	str_t email = str_init("me@example.com", 14);
+	str_array_init(&cli_emails);
+	str_array_add(cli_emails, email);
+	str_free(email);
+
+	test_parse_query_cli_emails();
+	test_parse_query_emails();
+	test_parse_query_invalid();
+	test_parse_query_bounds();
+	test_select_rows();
+	test_read_request();
+
+	str_array_free(&cli_emails);
+	print_report();
+}
@@ -0,0 +1,335 @@
+/* test_revisions.c
+ * -----------------------------------------------------------------------
+ * Copyright (C) 2025  Matteo Nicoli
+ *
+ * This file is part of TUR.
+ *
+ * TUR is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/* Ranges and exclusions of the branch list, walked on a small repository
+ * written with libgit2:
+ *
+ *     c1 - c2 - c3 - c4    main
+ *          |    \
+ *          v1    s1        side
+ *
+ * and the bounds of a --recent walk, on a bare repository (no reflog is
+ * written for its refs) with a long history before the time window:
+ *
+ *     o1 - ... - o10 - ... - o50 - r1 - r2    main, HEAD
+ *                  \               |
+ *                   t1  topic      fresh (reflog: created at r1)
+ */
+
+#include "test.h"
+#include "../src/commit.h"
+#include "../src/profile.h"
+#include "../src/settings.h"
+#include "../src/str.h"
+
+#include <ftw.h>
+#include <git2.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TEST_EMAIL "me@example.com"
+#define BASE_DATE 1577836800 /* 2020-01-01 */
+#define MAX_REVISIONS 4
+#define N_OLD_COMMITS 50
+#define RECENT_DATE (BASE_DATE + 1000)
+#define RECENT_SINCE (BASE_DATE + 500)
+
+static char repo_dir[] = "/tmp/tur_test_revisions_XXXXXX";
+static char recent_dir[] = "/tmp/tur_test_recent_XXXXXX";
+
+static bool commit(git_repository *repo, const char *update_ref, const git_commit *parent,
+				   const char *subject, git_time_t date, git_commit **out)
+{
+	git_signature *sig = NULL;
+	git_treebuilder *builder = NULL;
+	git_tree *tree = NULL;
+	git_oid blob, oid;
+	const git_commit *parents[] = { parent };
+	bool ok = false;
+
+	if (git_signature_new(&sig, "Me", TEST_EMAIL, date, 0) != 0) { goto cleanup; }
+	/* Every commit changes the same file, so that each one has a diff */
+	if (git_blob_create_from_buffer(&blob, repo, subject, strlen(subject)) != 0
+		|| git_treebuilder_new(&builder, repo, NULL) != 0
+		|| git_treebuilder_insert(NULL, builder, "file", &blob, GIT_FILEMODE_BLOB) != 0
+		|| git_treebuilder_write(&oid, builder) != 0
+		|| git_tree_lookup(&tree, repo, &oid) != 0) {
+		goto cleanup;
+	}
+	if (git_commit_create(&oid, repo, update_ref, sig, sig, NULL, subject, tree,
+						  parent ? 1 : 0, parents) != 0) {
+		goto cleanup;
+	}
+	ok = git_commit_lookup(out, repo, &oid) == 0;
+
+cleanup:
+	git_tree_free(tree);
+	git_treebuilder_free(builder);
+	git_signature_free(sig);
+	return ok;
+}
+
+static bool branch(git_repository *repo, const char *name, const git_commit *target)
+{
+	git_reference *ref = NULL;
+	const bool ok = git_branch_create(&ref, repo, name, target, 0) == 0;
+	git_reference_free(ref);
+	return ok;
+}
+
+static bool build_repository(void)
+{
+	git_repository *repo = NULL;
+	git_commit *c[4] = { NULL }, *s1 = NULL;
+	bool ok = false;
+
+	if (!mkdtemp(repo_dir) || git_repository_init(&repo, repo_dir, 0) != 0) { return false; }
+
+	ok = commit(repo, "refs/heads/main", NULL, "c1", BASE_DATE, &c[0])
+		 && commit(repo, "refs/heads/main", c[0], "c2", BASE_DATE + 1, &c[1])
+		 && branch(repo, "v1", c[1])
+		 && commit(repo, "refs/heads/main", c[1], "c3", BASE_DATE + 2, &c[2])
+		 && commit(repo, "refs/heads/main", c[2], "c4", BASE_DATE + 3, &c[3])
+		 && commit(repo, NULL, c[2], "s1", BASE_DATE + 4, &s1)
+		 && branch(repo, "side", s1);
+
+	for (size_t i = 0; i < 4; i++) {
+		git_commit_free(c[i]);
+	}
+	git_commit_free(s1);
+	git_repository_free(repo);
+	return ok;
+}
+
+static bool append_reflog(git_repository *repo, const char *ref_name,
+						  const git_commit *target, git_time_t date)
+{
+	git_reflog *reflog = NULL;
+	git_signature *sig = NULL;
+	bool ok = git_signature_new(&sig, "Me", TEST_EMAIL, date, 0) == 0
+			  && git_reflog_read(&reflog, repo, ref_name) == 0
+			  && git_reflog_append(reflog, git_commit_id(target), sig, "update") == 0
+			  && git_reflog_write(reflog) == 0;
+
+	git_reflog_free(reflog);
+	git_signature_free(sig);
+	return ok;
+}
+
+static bool build_recent_repository(void)
+{
+	git_repository *repo = NULL;
+	git_commit *old[N_OLD_COMMITS] = { NULL }, *r1 = NULL, *r2 = NULL, *t1 = NULL;
+	bool ok = true;
+
+	if (!mkdtemp(recent_dir) || git_repository_init(&repo, recent_dir, 1) != 0) { return false; }
+
+	for (size_t i = 0; ok && i < N_OLD_COMMITS; i++) {
+		char subject[8];
+		(void)snprintf(subject, sizeof(subject), "o%zu", i + 1);
+		ok = commit(repo, "refs/heads/main", i ? old[i - 1] : NULL, subject,
+					BASE_DATE + (git_time_t)i, &old[i]);
+	}
+	ok = ok
+		 && commit(repo, "refs/heads/main", old[N_OLD_COMMITS - 1], "r1", RECENT_DATE, &r1)
+		 && commit(repo, "refs/heads/main", r1, "r2", RECENT_DATE + 1, &r2)
+		 && commit(repo, NULL, old[9], "t1", RECENT_DATE + 2, &t1)
+		 && branch(repo, "topic", t1)
+		 && branch(repo, "fresh", r1)
+		 && git_repository_set_head(repo, "refs/heads/main") == 0
+		 /* fresh was created in the window; topic and HEAD have no reflog */
+		 && append_reflog(repo, "refs/heads/fresh", r1, RECENT_DATE);
+
+	for (size_t i = 0; i < N_OLD_COMMITS; i++) {
+		git_commit_free(old[i]);
+	}
+	git_commit_free(r1);
+	git_commit_free(r2);
+	git_commit_free(t1);
+	git_repository_free(repo);
+	return ok;
+}
+
+static int remove_entry(const char *path, const struct stat *sb, int flag, struct FTW *ftw)
+{
+	(void)sb; (void)flag; (void)ftw;
+	return remove(path);
+}
+
+static void add_str(str_array_t *arr, const char *val)
+{
+	str_t str = str_init(val, strlen(val));
+	str_array_add(arr, str);
+	str_free(str);
+}
+
+/* Walks the test repository with a branch list, or NULL on failure */
+static work_history_t *walk(const char *revisions[MAX_REVISIONS])
+{
+	settings_t settings = { 0 };
+	str_array_t *branches = NULL;
+
+	str_array_init(&settings.emails);
+	add_str(settings.emails, TEST_EMAIL);
+	str_array_init(&branches);
+	for (size_t i = 0; i < MAX_REVISIONS && revisions[i]; i++) {
+		add_str(branches, revisions[i]);
+	}
+
+	str_t path = str_init(repo_dir, strlen(repo_dir));
+	work_history_t *history = get_commit_history(path, branches, &settings, NULL, NULL);
+	str_free(path);
+	str_array_free(&branches);
+	str_array_free(&settings.emails);
+	return history;
+}
+
+/* True when the history holds exactly the commits of `subjects`, a
+ * space separated list */
+static bool walked(const work_history_t *history, const char *subjects)
+{
+	size_t n_expected = 0;
+
+	if (!history) { return false; }
+	for (const char *s = subjects; *s; s += strcspn(s, " ") + (s[strcspn(s, " ")] != '\0')) {
+		n_expected++;
+	}
+	if (history->commits.len != n_expected) { return false; }
+
+	for (uint32_t row = 0; row < history->commits.len; row++) {
+		const commit_t c = commit_table_row(&history->commits, row);
+		const char *found = strstr(subjects, c.msg.val);
+		if (!found || (found[c.msg.len] != ' ' && found[c.msg.len] != '\0')) { return false; }
+	}
+	return true;
+}
+
+void test_range(void)
+{
+	const char *revisions[MAX_REVISIONS] = { "v1..main" };
+	work_history_t *history = walk(revisions);
+
+	assert_true(walked(history, "c3 c4"), "`v1..main` should walk the commits after v1 on main");
+	assert_true(history && history->refs->len == 1
+				&& str_arr_equals(str_array_get(history->refs, 0), "v1..main"),
+				"the range should be listed as a ref of the walk");
+	history_free(&history);
+}
+
+void test_exclusion(void)
+{
+	const char *revisions[MAX_REVISIONS] = { "main", "^v1" };
+	work_history_t *history = walk(revisions);
+
+	assert_true(walked(history, "c3 c4"), "`main,^v1` should walk the commits after v1 on main");
+	history_free(&history);
+}
+
+void test_exclusion_whole_walk(void)
+{
+	const char *after[MAX_REVISIONS] = { "main", "side", "^v1" };
+	const char *before[MAX_REVISIONS] = { "^v1", "side", "main" };
+	work_history_t *history = walk(after);
+
+	assert_true(walked(history, "c3 c4 s1"), "`^v1` should hide v1 from every tip of the entry");
+	history_free(&history);
+
+	history = walk(before);
+	assert_true(walked(history, "c3 c4 s1"), "`^v1` should apply to the tips listed after it");
+	history_free(&history);
+}
+
+void test_exclusion_range(void)
+{
+	const char *revisions[MAX_REVISIONS] = { "v1..side", "^main" };
+	work_history_t *history = walk(revisions);
+
+	assert_true(walked(history, "s1"), "`^main` should hide main from the range of another tip");
+	history_free(&history);
+}
+
+void test_invalid_revisions(void)
+{
+	const char *skipped[MAX_REVISIONS] = { "nope..main", "main", "^nope", "v1...main" };
+	const char *nothing_left[MAX_REVISIONS] = { "nope..main", "^v1" };
+	work_history_t *history = walk(skipped);
+
+	assert_true(walked(history, "c1 c2 c3 c4"),
+				"unresolvable ranges and exclusions should be skipped");
+	assert_true(history && history->refs->len == 1,
+				"a skipped range should not be listed as a ref of the walk");
+	history_free(&history);
+
+	history = walk(nothing_left);
+	assert_true(history == NULL, "a walk left without tips should fail");
+}
+
+void test_recent_bounds(void)
+{
+	settings_t settings = { 0 };
+	str_array_t *branches = NULL;
+	profile_t profile = { 0 };
+
+	settings.since = RECENT_SINCE;
+	str_array_init(&settings.emails);
+	add_str(settings.emails, TEST_EMAIL);
+	str_array_init(&branches);
+	add_str(branches, "topic");
+	add_str(branches, "fresh");
+
+	str_t path = str_init(recent_dir, strlen(recent_dir));
+	work_history_t *history = get_commit_history(path, branches, &settings, NULL, &profile);
+
+	assert_true(walked(history, "r1 r2 t1"), "--recent should walk only the commits of the window");
+	assert_true(profile.counters[PROFILE_VISITED] == 3,
+				"refs without a reflog, or created in the window, should not be walked "
+				"before the window");
+
+	history_free(&history);
+	str_free(path);
+	str_array_free(&branches);
+	str_array_free(&settings.emails);
+}
+
+int main(void)
+{
+	git_libgit2_init();
+
+	if (!build_repository() || !build_recent_repository()) {
+		const git_error *err = git_error_last();
+		fprintf(stderr, "test_revisions: cannot build the test repository: %s\n",
+				err && err->message ? err->message : "unknown error");
+		return 1;
+	}
+
+	test_range();
+	test_exclusion();
+	test_exclusion_whole_walk();
+	test_exclusion_range();
+	test_invalid_revisions();
+	test_recent_bounds();
+
+	(void)nftw(repo_dir, remove_entry, 16, FTW_DEPTH | FTW_PHYS);
+	(void)nftw(recent_dir, remove_entry, 16, FTW_DEPTH | FTW_PHYS);
+	git_libgit2_shutdown();
+	print_report();
+}
@@ -0,0 +1,260 @@
+/* test_sink.c
+ * -----------------------------------------------------------------------
+ * Copyright (C) 2025  Matteo Nicoli
+ *
+ * This file is part of TUR.
+ *
+ * TUR is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "test.h"
+#include "../src/sink.h"
+#include "../src/str.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define SINK_TEST_FILE "/tmp/tur_test_sink.out"
+
+static bool sink_equals(const sink_t *sink, const char *expected)
+{
+	return sink->len == strlen(expected) && memcmp(sink->buf, expected, sink->len) == 0;
+}
+
+/* Reads back the whole file written by a sink */
+static char *read_file(const char *path, size_t *len)
+{
+	struct stat st;
+	if (stat(path, &st) != 0) { return NULL; }
+
+	char *content = malloc((size_t)st.st_size + 1);
+	FILE *fp = fopen(path, "r");
+	*len = fread(content, 1, (size_t)st.st_size, fp);
+	content[*len] = '\0';
+	fclose(fp);
+	return content;
+}
+
+void test_sink_primitives(void)
+{
+	sink_t sink;
+	const uint8_t oid[] = { 0x00, 0x1f, 0xa0, 0xff };
+
+	assert_true(sink_init_memory(&sink) == OK, "sink_init_memory should return OK");
+
+	sink_puts(&sink, "n=");
+	sink_put_uint(&sink, 0);
+	sink_putc(&sink, ',');
+	sink_put_uint(&sink, 18446744073709551615ull);
+	assert_true(sink_equals(&sink, "n=0,18446744073709551615"), "sink_put_uint should print every digit");
+
+	sink.len = 0;
+	sink_put_hex(&sink, oid, sizeof(oid));
+	assert_true(sink_equals(&sink, "001fa0ff"), "sink_put_hex should print two lowercase digits per byte");
+
+	sink.len = 0;
+	sink_put_date(&sink, 1732838400, true);
+	assert_true(sink_equals(&sink, "Nov 29, 2024"), "sink_put_date should format the date in place");
+
+	sink.len = 0;
+	sink_put_padded(&sink, STR_VIEW("ab", 2), 5);
+	sink_putc(&sink, '|');
+	assert_true(sink_equals(&sink, "ab   |"), "sink_put_padded should pad to the given width");
+
+	sink.len = 0;
+	sink_printf(&sink, "%s-%d", "x", 42);
+	assert_true(sink_equals(&sink, "x-42"), "sink_printf should append the formatted string");
+
+	assert_true(sink_close(&sink) == OK, "sink_close should return OK");
+}
+
+void test_sink_json(void)
+{
+	sink_t sink;
+	const char raw[] = "a\"b\\c\n\t\x01\x1f\xc3\xa8/";
+
+	sink_init_memory(&sink);
+
+	sink_put_int(&sink, -42);
+	sink_putc(&sink, ',');
+	sink_put_int(&sink, INT64_MIN);
+	assert_true(sink_equals(&sink, "-42,-9223372036854775808"), "sink_put_int should print the sign");
+
+	sink.len = 0;
+	sink_put_json_str(&sink, STR_VIEW(raw, sizeof(raw) - 1));
+	assert_true(sink_equals(&sink, "\"a\\\"b\\\\c\\n\\t\\u0001\\u001f\xc3\xa8/\""),
+				"sink_put_json_str should escape quotes, backslashes and control characters");
+
+	sink.len = 0;
+	sink_put_json_str(&sink, STR_VIEW("", 0));
+	sink_put_json_str(&sink, STR_VIEW("\0", 1));
+	assert_true(sink_equals(&sink, "\"\"\"\\u0000\""), "sink_put_json_str should handle empty strings and NUL bytes");
+
+	/* Latin-1 'è', a lone continuation byte, an overlong '/', a surrogate,
+	 * then valid 3 and 4 bytes sequences and a cut 'è' */
+	const char invalid[] = "\xe8" "a\x80\xc0\xaf\xed\xa0\x80\xe2\x82\xac\xf0\x9f\x98\x80\xc3";
+	sink.len = 0;
+	sink_put_json_str(&sink, STR_VIEW(invalid, sizeof(invalid) - 1));
+	assert_true(sink_equals(&sink, "\"\\ufffda\\ufffd\\ufffd\\ufffd\\ufffd\\ufffd\\ufffd"
+							"\xe2\x82\xac\xf0\x9f\x98\x80\\ufffd\""),
+				"sink_put_json_str should replace every byte of an invalid UTF-8 sequence");
+
+	sink_close(&sink);
+}
+
+void test_sink_csv(void)
+{
+	sink_t sink;
+
+	sink_init_memory(&sink);
+
+	sink_put_csv_str(&sink, STR_VIEW("say \"hi\", then\nleave", 20));
+	assert_true(sink_equals(&sink, "\"say \"\"hi\"\", then\nleave\""),
+				"sink_put_csv_str should quote the field and double its quotes");
+
+	sink.len = 0;
+	sink_put_csv_str(&sink, STR_VIEW("\"\"", 2));
+	sink_put_csv_str(&sink, STR_VIEW("", 0));
+	assert_true(sink_equals(&sink, "\"\"\"\"\"\"\"\""), "sink_put_csv_str should handle quotes only and empty fields");
+
+	sink.len = 0;
+	sink_put_tsv_str(&sink, STR_VIEW("a\tb\\c\r\n", 7));
+	assert_true(sink_equals(&sink, "a\\tb\\\\c\\r\\n"), "sink_put_tsv_str should escape tabs, newlines and backslashes");
+
+	sink.len = 0;
+	sink_put_iso_date(&sink, 1732838400);
+	sink_putc(&sink, ' ');
+	sink_put_iso_date(&sink, 951782399);
+	assert_true(sink_equals(&sink, "2024-11-29T00:00:00Z 2000-02-28T23:59:59Z"),
+				"sink_put_iso_date should write UTC ISO 8601 timestamps");
+
+	sink_close(&sink);
+}
+
+void test_sink_memory_growth(void)
+{
+	sink_t sink;
+	char big[3 * SINK_BUFFER_SIZE];
+	memset(big, 'x', sizeof(big));
+
+	sink_init_memory(&sink);
+	sink_puts(&sink, "head");
+	sink_write(&sink, big, sizeof(big));
+	sink_printf(&sink, "%.*s", (int)sizeof(big), big);
+
+	assert_true(sink.ret == OK, "memory sink should grow instead of failing");
+	assert_true(sink_size(&sink) == 4 + 2 * sizeof(big), "memory sink should keep every byte");
+	assert_true(memcmp(sink.buf, "headxxx", 7) == 0 && sink.buf[sink.len - 1] == 'x',
+				"memory sink should keep the appended data in order");
+
+	sink_close(&sink);
+}
+
+static void write_pattern(sink_t *sink, size_t n_lines)
+{
+	char big[SINK_BUFFER_SIZE];
+	memset(big, '#', sizeof(big));
+
+	for (size_t i = 0; i < n_lines; i++) {
+		sink_put_uint(sink, i);
+		sink_putc(sink, '\n');
+		/* Every now and then an append large enough to bypass the buffer */
+		if (i % 10000 == 0) {
+			sink_write(sink, big, sizeof(big));
+			sink_putc(sink, '\n');
+		}
+	}
+}
+
+static bool check_pattern(const char *content, size_t len, size_t n_lines)
+{
+	size_t pos = 0;
+	char expected[32];
+
+	for (size_t i = 0; i < n_lines; i++) {
+		const int n = snprintf(expected, sizeof(expected), "%zu\n", i);
+		if (pos + (size_t)n > len || memcmp(content + pos, expected, (size_t)n) != 0) { return false; }
+		pos += (size_t)n;
+		if (i % 10000 == 0) {
+			if (pos + SINK_BUFFER_SIZE + 1 > len) { return false; }
+			for (size_t j = 0; j < SINK_BUFFER_SIZE; j++) {
+				if (content[pos + j] != '#') { return false; }
+			}
+			pos += SINK_BUFFER_SIZE + 1;
+		}
+	}
+
+	return pos == len;
+}
+
+void test_sink_file(bool use_mmap)
+{
+	sink_t sink;
+	size_t len = 0;
+	const size_t n_lines = 100000;
+
+	assert_true(sink_init_file(&sink, SINK_TEST_FILE, use_mmap) == OK,
+				"sink_init_file should open the output file");
+	write_pattern(&sink, n_lines);
+	const size_t size = sink_size(&sink);
+	assert_true(sink_close(&sink) == OK, "closing a file sink should return OK");
+
+	char *content = read_file(SINK_TEST_FILE, &len);
+	assert_true(content && len == size, use_mmap
+				? "mmap sink should truncate the file to the written size"
+				: "fd sink should write every byte");
+	assert_true(content && check_pattern(content, len, n_lines), use_mmap
+				? "mmap sink should write the data in order"
+				: "fd sink should write the data in order, also through writev");
+
+	free(content);
+	unlink(SINK_TEST_FILE);
+}
+
+void test_sink_errors(void)
+{
+	sink_t sink;
+
+	assert_true(sink_init_file(&sink, "/nonexistent/dir/out.txt", false) == CANNOT_OPEN_OUTPUT,
+				"sink_init_file should fail on a missing directory");
+	sink_puts(&sink, "ignored");
+	assert_true(sink_close(&sink) == CANNOT_OPEN_OUTPUT, "sink errors should be sticky");
+
+	/* Writes to a closed descriptor fail at the first flush */
+	int fds[2];
+	(void)pipe(fds);
+	close(fds[1]);
+	close(fds[0]);
+	sink_init_fd(&sink, fds[1]);
+	sink_puts(&sink, "lost");
+	assert_true(sink_flush(&sink) == CANNOT_WRITE_OUTPUT, "sink_flush should report write errors");
+	sink_close(&sink);
+}
+
+int main(void)
+{
+	test_sink_primitives();
+	test_sink_json();
+	test_sink_csv();
+	test_sink_memory_growth();
+	test_sink_file(false);
+	test_sink_file(true);
+	test_sink_errors();
+	print_report();
+}
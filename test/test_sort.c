@@ -0,0 +1,127 @@
+/* test_sort.c
+ * -----------------------------------------------------------------------
+ * Copyright (C) 2025  Matteo Nicoli
+ *
+ * This file is part of TUR.
+ *
+ * TUR is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "test.h"
+#include "../src/sort.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <time.h>
+
+static uint32_t *make_rows(size_t n)
+{
+	uint32_t *rows = malloc(n * sizeof(uint32_t));
+	for (size_t i = 0; i < n; i++) {
+		rows[i] = (uint32_t)i;
+	}
+	return rows;
+}
+
+static bool is_sorted(const uint32_t *rows, size_t n, const time_t *dates, sort_ordering_t order)
+{
+	for (size_t i = 1; i < n; i++) {
+		if (order == ASC && dates[rows[i - 1]] > dates[rows[i]]) { return false; }
+		if (order == DESC && dates[rows[i - 1]] < dates[rows[i]]) { return false; }
+	}
+	return true;
+}
+
+/* Rows with the same date must keep their original order */
+static bool is_stable(const uint32_t *rows, size_t n, const time_t *dates)
+{
+	for (size_t i = 1; i < n; i++) {
+		if (dates[rows[i - 1]] == dates[rows[i]] && rows[i - 1] > rows[i]) { return false; }
+	}
+	return true;
+}
+
+void test_sort_small(void)
+{
+	const time_t dates[] = { 30, -5, 10, 10, 0, 1700000000 };
+	const size_t n = sizeof(dates) / sizeof(dates[0]);
+	uint32_t *rows = make_rows(n);
+
+	assert_true(sort_rows_by_date(rows, n, dates, ASC) == OK, "sort_rows_by_date should return OK");
+	assert_true(is_sorted(rows, n, dates, ASC), "small array should be sorted in ascending order");
+	assert_true(dates[rows[0]] == -5, "negative dates should come first in ascending order");
+	assert_true(is_stable(rows, n, dates), "small array sort should be stable");
+
+	sort_rows_by_date(rows, n, dates, DESC);
+	assert_true(is_sorted(rows, n, dates, DESC), "small array should be sorted in descending order");
+
+	sort_rows_by_date(rows, 0, dates, ASC);
+	assert_true(true, "sorting an empty array should not crash");
+
+	free(rows);
+}
+
+void test_sort_large(void)
+{
+	const size_t n = 100000;
+	time_t *dates = malloc(n * sizeof(time_t));
+	srand(42);
+	for (size_t i = 0; i < n; i++) {
+		/* Few distinct values, to have many ties */
+		dates[i] = 1600000000 + (rand() % 5000) * 3600 - (i % 7 == 0 ? 1700000000 : 0);
+	}
+	uint32_t *rows = make_rows(n);
+
+	sort_rows_by_date(rows, n, dates, ASC);
+	assert_true(is_sorted(rows, n, dates, ASC), "large array should be sorted in ascending order");
+	assert_true(is_stable(rows, n, dates), "ascending radix sort should be stable");
+
+	free(rows);
+	rows = make_rows(n);
+	sort_rows_by_date(rows, n, dates, DESC);
+	assert_true(is_sorted(rows, n, dates, DESC), "large array should be sorted in descending order");
+	assert_true(is_stable(rows, n, dates), "descending radix sort should be stable");
+
+	free(rows);
+	free(dates);
+}
+
+void test_sort_same_date(void)
+{
+	const size_t n = 1000;
+	time_t *dates = malloc(n * sizeof(time_t));
+	for (size_t i = 0; i < n; i++) {
+		dates[i] = 1234567890;
+	}
+	uint32_t *rows = make_rows(n);
+
+	sort_rows_by_date(rows, n, dates, DESC);
+	bool untouched = true;
+	for (size_t i = 0; i < n; i++) {
+		untouched = untouched && rows[i] == i;
+	}
+	assert_true(untouched, "commits with the same date should keep their order");
+
+	free(rows);
+	free(dates);
+}
+
+int main(void)
+{
+	test_sort_small();
+	test_sort_large();
+	test_sort_same_date();
+	print_report();
+}
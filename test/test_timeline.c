@@ -0,0 +1,194 @@
+/* test_timeline.c
+ * -----------------------------------------------------------------------
+ * Copyright (C) 2025  Matteo Nicoli
+ *
+ * This file is part of TUR.
+ *
+ * TUR is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "test.h"
+#include "../src/commit.h"
+#include "../src/repo.h"
+#include "../src/settings.h"
+#include "../src/str.h"
+#include "../src/timeline.h"
+
+#include <string.h>
+#include <time.h>
+
+/* Builds a history whose indexes keep the order of the given dates: the
+ * caller passes them already sorted, as build_indexes does. */
+static work_history_t *make_history(const time_t *authored, size_t n_authored,
+									const time_t *co_authored, size_t n_co_authored)
+{
+	work_history_t *history = calloc(1, sizeof(work_history_t));
+	commit_table_init(&history->commits, 0);
+
+	for (size_t i = 0; i < n_authored + n_co_authored; i++) {
+		char hash[16];
+		snprintf(hash, sizeof(hash), "hash%zu", i);
+		commit_stats_t stats = { 0 };
+		commit_table_add(&history->commits, hash, "msg",
+						 i < n_authored ? authored[i] : co_authored[i - n_authored],
+						 i < n_authored ? AUTHORED : CO_AUTHORED,
+						 &stats);
+	}
+
+	history->n_authored = n_authored;
+	history->n_co_authored = n_co_authored;
+	history->indexes.authored = malloc((n_authored + 1) * sizeof(uint32_t));
+	history->indexes.co_authored = malloc((n_co_authored + 1) * sizeof(uint32_t));
+	for (size_t i = 0; i < n_authored; i++) {
+		history->indexes.authored[i] = (uint32_t)i;
+	}
+	for (size_t i = 0; i < n_co_authored; i++) {
+		history->indexes.co_authored[i] = (uint32_t)(n_authored + i);
+	}
+
+	return history;
+}
+
+static repository_array_t *make_repos(void)
+{
+	repository_array_t *repos = NULL;
+	repo_array_init(&repos);
+
+	for (unsigned i = 0; i < 2; i++) {
+		char path[16];
+		snprintf(path, sizeof(path), "/tmp/repo%u", i);
+		repository_t repo = parse_repository(path, strlen(path), i);
+		repo_array_add(repos, &repo);
+		str_free(repo.path);
+		str_free(repo.name);
+		str_free(repo.url);
+	}
+
+	return repos;
+}
+
+void test_timeline_sorted_desc(void)
+{
+	repository_array_t *repos = make_repos();
+	const time_t a0[] = { 50, 30, 10 }, c0[] = { 60 };
+	const time_t a1[] = { 40, 20 };
+	repo_array_get(repos, 0)->history = make_history(a0, 3, c0, 1);
+	repo_array_get(repos, 1)->history = make_history(a1, 2, NULL, 0);
+
+	settings_t settings = { .sorted = true, .sort_order = DESC };
+	timeline_t timeline;
+	timeline_item_t item;
+	const time_t expected[] = { 60, 50, 40, 30, 20, 10 };
+	const unsigned expected_repo[] = { 0, 0, 1, 0, 1, 0 };
+	size_t n = 0;
+	bool in_order = true;
+
+	assert_true(timeline_init(&timeline, repos, &settings) == OK, "timeline_init should return OK");
+	while (timeline_next(&timeline, &item)) {
+		in_order = in_order && n < 6
+				   && item.commit.date == expected[n]
+				   && item.repo->id == expected_repo[n];
+		n++;
+	}
+	assert_true(n == 6, "timeline should yield every commit of every repository");
+	assert_true(in_order, "timeline should merge the repositories in descending date order");
+	assert_true(!timeline_next(&timeline, &item), "an exhausted timeline should stay exhausted");
+
+	timeline_free(&timeline);
+	repo_array_free(&repos);
+}
+
+void test_timeline_sorted_asc_ties(void)
+{
+	repository_array_t *repos = make_repos();
+	const time_t a0[] = { 1, 2 }, c0[] = { 2 };
+	const time_t a1[] = { 1, 2 };
+	repo_array_get(repos, 0)->history = make_history(a0, 2, c0, 1);
+	repo_array_get(repos, 1)->history = make_history(a1, 2, NULL, 0);
+
+	settings_t settings = { .sorted = true, .sort_order = ASC };
+	timeline_t timeline;
+	timeline_item_t item;
+	const unsigned expected_repo[] = { 0, 1, 0, 0, 1 };
+	const responsability_t expected_resp[] = { AUTHORED, AUTHORED, AUTHORED, CO_AUTHORED, AUTHORED };
+	size_t n = 0;
+	bool in_order = true;
+
+	timeline_init(&timeline, repos, &settings);
+	while (timeline_next(&timeline, &item)) {
+		in_order = in_order && n < 5
+				   && item.repo->id == expected_repo[n]
+				   && item.responsability == expected_resp[n];
+		n++;
+	}
+	assert_true(n == 5, "timeline should yield five commits");
+	assert_true(in_order, "commits with the same date should follow the repository order");
+
+	timeline_free(&timeline);
+	repo_array_free(&repos);
+}
+
+void test_timeline_unsorted(void)
+{
+	repository_array_t *repos = make_repos();
+	const time_t a0[] = { 10, 30 }, c0[] = { 20 };
+	const time_t c1[] = { 5 };
+	repo_array_get(repos, 0)->history = make_history(a0, 2, c0, 1);
+	repo_array_get(repos, 1)->history = make_history(NULL, 0, c1, 1);
+
+	settings_t settings = { .sorted = false };
+	timeline_t timeline;
+	timeline_item_t item;
+	const time_t expected[] = { 10, 30, 20, 5 };
+	size_t n = 0;
+	bool in_order = true;
+
+	timeline_init(&timeline, repos, &settings);
+	while (timeline_next(&timeline, &item)) {
+		in_order = in_order && n < 4 && item.commit.date == expected[n];
+		n++;
+	}
+	assert_true(n == 4, "unsorted timeline should yield four commits");
+	assert_true(in_order, "unsorted timeline should keep the repository order");
+
+	timeline_free(&timeline);
+	repo_array_free(&repos);
+}
+
+void test_timeline_empty(void)
+{
+	repository_array_t *repos = make_repos();
+	repo_array_get(repos, 0)->history = make_history(NULL, 0, NULL, 0);
+	repo_array_get(repos, 1)->history = make_history(NULL, 0, NULL, 0);
+
+	settings_t settings = { .sorted = true, .sort_order = DESC };
+	timeline_t timeline;
+	timeline_item_t item;
+
+	timeline_init(&timeline, repos, &settings);
+	assert_true(!timeline_next(&timeline, &item), "timeline of empty histories should be empty");
+
+	timeline_free(&timeline);
+	repo_array_free(&repos);
+}
+
+int main(void)
+{
+	test_timeline_sorted_desc();
+	test_timeline_sorted_asc_ties();
+	test_timeline_unsorted();
+	test_timeline_empty();
+	print_report();
+}
@@ -364,6 +364,85 @@ void test_parse_commit_id(void)
 	}
 }
 
+void test_parse_budget(void)
+{
+	walk_budget_t budget = { 0 };
+	const char *limits = "time=60,commits=100000,diffs=5000";
+
+	assert_true(parse_budget(&budget, limits, strlen(limits)) == OK
+				&& budget.max_seconds == 60 && budget.max_commits == 100000
+				&& budget.max_diffs == 5000, "should parse every limit");
+
+	limits = "commits=0";
+	assert_true(parse_budget(&budget, limits, strlen(limits)) == OK
+				&& budget.max_commits == BUDGET_UNLIMITED && budget.max_seconds == 60,
+				"0 should lift a limit and leave the others as they are");
+
+	limits = "time=1x";
+	assert_true(parse_budget(&budget, limits, strlen(limits)) == UNSUPPORTED_VALUE
+				&& budget.max_seconds == 60, "should reject a value that is not a number");
+
+	limits = "time=";
+	assert_true(parse_budget(&budget, limits, strlen(limits)) == UNSUPPORTED_VALUE,
+				"should reject a missing value");
+
+	limits = "pages=3";
+	assert_true(parse_budget(&budget, limits, strlen(limits)) == UNSUPPORTED_VALUE,
+				"should reject an unknown limit");
+
+	limits = "diffs=99999999999999999999999";
+	assert_true(parse_budget(&budget, limits, strlen(limits)) == INT_OVERFLOW
+				&& budget.max_diffs == 5000, "should reject a limit that overflows");
+
+	assert_true(parse_budget(NULL, limits, strlen(limits)) == NULL_PARAMETER,
+				"should reject a NULL budget");
+}
+
+void test_merge_budgets(void)
+{
+	const walk_budget_t global = { .max_seconds = 60, .max_commits = 1000, .max_diffs = 0 };
+	const walk_budget_t entry = { .max_seconds = 0, .max_commits = BUDGET_UNLIMITED, .max_diffs = 10 };
+	const walk_budget_t budget = merge_budgets(&global, &entry);
+
+	assert_true(budget.max_seconds == 60, "an unset limit of the entry should keep the global one");
+	assert_true(budget.max_commits == 0, "an unlimited entry should lift the global limit");
+	assert_true(budget.max_diffs == 10, "the limit of the entry should be used");
+}
+
+void test_render_buffers(void)
+{
+	render_buf_t buf;
+
+	{
+		str_t text = str_init("Subject\nBody", strlen("Subject\nBody"));
+		str_t line = first_line_view(text);
+
+		assert_true(line.val == text.val && line.len == 7,
+					"first_line_view should point into the text");
+
+		str_free(text);
+	}
+
+	{
+		str_t input = str_init("fix #12 in my_func", strlen("fix #12 in my_func"));
+		str_t result = render_escaped(&buf, input);
+
+		assert_true(str_arr_equals(result, "fix \\#12 in my\\_func"),
+					"render_escaped should escape '#' and '_'");
+
+		str_free(input);
+	}
+
+	{
+		char long_text[TEXT_BUF_SIZE + 10];
+		memset(long_text, '_', sizeof(long_text));
+		str_t result = render_escaped(&buf, STR_VIEW(long_text, sizeof(long_text)));
+
+		assert_true(result.len == TEXT_BUF_SIZE - 2 && result.val[result.len] == '\0',
+					"render_escaped should truncate without splitting an escape");
+	}
+}
+
 int main(void)
 {
 	test_header_of_text();
@@ -371,5 +450,8 @@ int main(void)
 	test_escape_special_chars();
 	test_trim_whitespace();
 	test_parse_commit_id();
+	test_parse_budget();
+	test_merge_budgets();
+	test_render_buffers();
 	print_report();
 }